@@ -0,0 +1,473 @@
+// end to end throughput of the compiler stages on a synthesized program
+// usage: pascal2c_bench [--subprograms N] [--statements N] [--nesting N]
+//                       [--arrays N] [--array-bound N] [--expr-terms N] [--runs N]
+//                       [--queue-capacity N] [--scan-mb N] [--dump file.pas] [--input file.pas]
+// every stage runs --runs times on the same input and the fastest run is reported,
+// the scanner in tokens/s, the parser in ast nodes/s and the later stages in ms,
+// --input measures a file instead of the synthesized program
+// "scan rate" is the scanner the build links in MB/s, configure with and without
+// PASCAL2C_SIMD_LEXER to compare the flex one with the SIMD one, or build scanner_speed
+// "scan (N threads)" is the chunked scan of TokenStream on 1, 2, 4, ... threads up to 8 or
+// the hardware threads if there are more, with its speedup over one thread, it scans the
+// program repeated to --scan-mb megabytes, 32 by default, so every thread gets chunks
+// well above TokenStream::kMinChunk
+// every global operator new is counted, "heap (parse)" is what parsing allocates besides
+// the nodes, which come from the parser arena, and the arena blocks themselves
+// "heap (analyse)" is what DoProgram allocates, and the difference to a program with
+// twice --statements divided by the extra statements, what visiting one statement costs
+// "parse (queued)" scans on a second thread feeding the parser through a TokenQueue
+// of --queue-capacity tokens, its stall counters are printed for tuning the capacity
+// "parse (shared)" hash-conses the expressions, the arena memory of both parses is
+// printed to show what sharing the equal subtrees saves, "analyse (shared)" runs DoProgram on
+// that program, typing each shared subtree once
+// "load (cache)" reads the program back from the bytes of its --cache entry, with the
+// hashing of the source and the line table a cached run needs, to weigh against parsing
+// "lookup" queries a symbol table block of a growing number of globals from itself and
+// from a nested block, the cost of a lookup should stay flat
+// "node" makes and frees expression nodes the way the parser does, with ArenaAllocator
+// borrowing the arena by pointer, next to an allocator putting a shared_ptr to the arena
+// in every control block, the difference is what keeping the arena alive from every node costs
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "program_generator.h"
+#include "ast/serialize.h"
+#include "code_generation/code_generator.h"
+#include "code_generation/optimizer/transformer.h"
+#include "parser/parser.h"
+#include "semantic_analysis/semantic_analysis.h"
+
+extern "C" {
+#include "lexer.h"
+}
+
+using namespace pascal2c;
+using Clock = std::chrono::steady_clock;
+
+// the scanner and the queued parser allocate on threads of their own
+static std::atomic<size_t> allocations{0};
+
+void *operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+static double Seconds(Clock::time_point begin, Clock::time_point end)
+{
+    return std::chrono::duration<double>(end - begin).count();
+}
+
+// fastest of all runs of one stage
+struct Stage
+{
+    double best = 1e30;
+    size_t items = 0;  // tokens or nodes handled by one run, 0 if not counted
+
+    void Add(double seconds) { best = std::min(best, seconds); }
+};
+
+static void Print(const char *name, const Stage &stage, const char *unit)
+{
+    if (stage.items)
+        printf("%-16s %10.2f ms %12zu %-7s %10.2f M%s/s\n", name, stage.best * 1e3, stage.items, unit,
+               stage.items / stage.best / 1e6, unit);
+    else
+        printf("%-16s %10.2f ms\n", name, stage.best * 1e3);
+}
+
+// param:
+//     globals is the number of variables declared in the program block
+//     lookups is the number of queries issued
+//     from_function is true if the queries start at a block nested in the program block
+// return:
+//     seconds per lookup
+static double Lookup(int globals, int lookups, bool from_function)
+{
+    using namespace symbol_table;
+    ast::Interner symbols;
+    auto item = [&symbols](ItemType type, const std::string &name) {
+        SymbolId id = symbols.Intern(name);
+        return SymbolTableItem(type, id, symbols.Name(id), true, false, {});
+    };
+    auto program_block = std::make_shared<SymbolTableBlock>();
+    for (int i = 0; i < globals; i++)
+        program_block->AddItem(item(INT, "g" + std::to_string(i)));
+
+    auto function_block = std::make_shared<SymbolTableBlock>();
+    function_block->Locate(program_block);
+    function_block->AddItem(item(INT, "local"));
+
+    std::vector<SymbolTableItem> queries;
+    for (int i = 0; i < 64; i++)
+        queries.push_back(item(ERROR, "g" + std::to_string((i * 7919) % globals)));
+
+    auto &block = from_function ? function_block : program_block;
+    int found = 0;
+    auto begin = Clock::now();
+    for (int i = 0; i < lookups; i++)
+    {
+        SymbolTableItem query = queries[i % queries.size()];
+        if (block->Query(query) == saERRORS::NO_ERROR)
+            found++;
+    }
+    double seconds = Seconds(begin, Clock::now());
+    if (found != lookups)
+        fprintf(stderr, "unexpected lookup failure: %d of %d found\n", found, lookups);
+    return seconds / lookups;
+}
+
+// ArenaAllocator owning the arena, every node keeps it alive
+template <typename Tp>
+struct OwningAllocator
+{
+    using value_type = Tp;
+
+    explicit OwningAllocator(std::shared_ptr<ast::Arena> arena) : arena(std::move(arena)) {}
+
+    template <typename Up>
+    OwningAllocator(const OwningAllocator<Up> &other) : arena(other.arena) {}
+
+    Tp *allocate(size_t n) { return static_cast<Tp *>(arena->Allocate(n * sizeof(Tp), alignof(Tp))); }
+    void deallocate(Tp *, size_t) {}
+
+    template <typename Up>
+    bool operator==(const OwningAllocator<Up> &other) const { return arena == other.arena; }
+    template <typename Up>
+    bool operator!=(const OwningAllocator<Up> &other) const { return arena != other.arena; }
+
+    std::shared_ptr<ast::Arena> arena;
+};
+
+// param:
+//     nodes is the number of nodes made
+//     owning gives every node a shared_ptr to the arena, ArenaAllocator is used otherwise
+//     bytes gets the arena bytes per node
+// return:
+//     seconds to make and free one node
+static double NodeCost(int nodes, bool owning, size_t &bytes)
+{
+    auto arena = std::make_shared<ast::Arena>();
+    std::vector<std::shared_ptr<ast::Expression>> kept;
+    kept.reserve(nodes);
+    auto begin = Clock::now();
+    for (int i = 0; i < nodes; i++)
+    {
+        if (owning)
+            kept.push_back(std::allocate_shared<ast::IntegerValue>(OwningAllocator<ast::IntegerValue>(arena), 0u, i));
+        else
+            kept.push_back(std::allocate_shared<ast::IntegerValue>(ast::ArenaAllocator<ast::IntegerValue>(arena.get()), 0u, i));
+    }
+    kept.clear();
+    double seconds = Seconds(begin, Clock::now());
+    bytes = arena->bytes_used() / nodes;
+    return seconds / nodes;
+}
+
+// param:
+//     lines and symbols are the line table and the identifiers of the source of program
+// return:
+//     the heap allocations DoProgram makes on program
+static size_t AnalyseAllocations(const ast::Program &program, std::shared_ptr<const ast::LineTable> lines,
+                                 std::shared_ptr<const ast::Interner> symbols)
+{
+    analysiser::init(std::move(lines), std::move(symbols));
+    size_t before = allocations;
+    analysiser::DoProgram(program);
+    return allocations - before;
+}
+
+static bool ParseArgs(int argc, char **argv, bench::ProgramShape &shape, int &runs, int &queue_capacity,
+                      int &scan_mb, const char *&dump, const char *&input)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--dump") && i + 1 < argc)
+        {
+            dump = argv[++i];
+            continue;
+        }
+        if (!strcmp(argv[i], "--input") && i + 1 < argc)
+        {
+            input = argv[++i];
+            continue;
+        }
+        struct { const char *flag; int *value; } options[] = {
+            {"--subprograms", &shape.subprograms}, {"--statements", &shape.statements},
+            {"--nesting", &shape.nesting}, {"--arrays", &shape.arrays},
+            {"--array-bound", &shape.array_bound}, {"--expr-terms", &shape.expr_terms},
+            {"--runs", &runs}, {"--queue-capacity", &queue_capacity}, {"--scan-mb", &scan_mb},
+        };
+        bool known = false;
+        for (auto &option : options)
+        {
+            if (!strcmp(argv[i], option.flag) && i + 1 < argc)
+            {
+                *option.value = atoi(argv[++i]);
+                known = true;
+            }
+        }
+        if (!known)
+            return false;
+    }
+    return runs > 0 && shape.expr_terms > 0 && shape.array_bound > 0 && queue_capacity > 0 && scan_mb > 0;
+}
+
+int main(int argc, char **argv)
+{
+    bench::ProgramShape shape;
+    int runs = 3;
+    int queue_capacity = parser::TokenQueue::kDefaultCapacity;
+    int scan_mb = 32;
+    const char *dump = nullptr;
+    const char *input = nullptr;
+    if (!ParseArgs(argc, argv, shape, runs, queue_capacity, scan_mb, dump, input))
+    {
+        fprintf(stderr, "usage: %s [--subprograms N] [--statements N] [--nesting N] [--arrays N]"
+                        " [--array-bound N] [--expr-terms N] [--runs N] [--queue-capacity N] [--scan-mb N]"
+                        " [--dump file.pas] [--input file.pas]\n", argv[0]);
+        return 1;
+    }
+
+    std::string source;
+    if (input)
+    {
+        std::ifstream in(input);
+        if (!in)
+        {
+            fprintf(stderr, "cannot open %s\n", input);
+            return 1;
+        }
+        std::stringstream text;
+        text << in.rdbuf();
+        source = text.str();
+        printf("program: %zu bytes from %s\n", source.size(), input);
+    }
+    else
+    {
+        source = bench::GenerateProgram(shape);
+        printf("program: %zu bytes, %d subprograms, %d statements each, nesting %d, %d arrays, %d expression terms\n",
+               source.size(), shape.subprograms, shape.statements, shape.nesting, shape.arrays,
+               shape.expr_terms);
+    }
+    if (dump)
+        std::ofstream(dump) << source;
+
+    Stage scan, parse, queued, shared, store, load, analyse, analyse_shared, transform, generate;
+    parser::TokenQueue::Stats queue_stats;
+    size_t parse_bytes = 0, parse_blocks = 0, parse_allocations = 0, shared_bytes = 0, shared_hits = 0;
+    size_t analyse_allocations = 0;
+    size_t cache_size = 0;
+    size_t code_size = 0;
+    for (int run = 0; run < runs; run++)
+    {
+        // >>>>>> lexer <<<<<<
+        LexerState *lexer = LexerCreate();
+        auto begin = Clock::now();
+        LexerSetBytes(lexer, source.data(), source.size());
+        size_t tokens = 0;
+        int token;
+        while ((token = LexerNext(lexer)) != 0 && token != TOK_ERROR)
+            tokens++;
+        scan.Add(Seconds(begin, Clock::now()));
+        scan.items = tokens;
+        LexerDestroy(lexer);
+
+        // >>>>>> parser <<<<<<
+        size_t before = allocations;
+        begin = Clock::now();
+        parser::Parser parser(source.data(), source.size());
+        auto program = parser.Parse();
+        parse.Add(Seconds(begin, Clock::now()));
+        parse_allocations = allocations - before;
+        parse.items = parser.arena()->allocation_count();
+        parse_bytes = parser.arena()->bytes_used();
+        parse_blocks = parser.arena()->block_count();
+        if (!parser.syntax_errs().empty())
+        {
+            fprintf(stderr, "the program has %zu syntax errors, first: %s\n",
+                    parser.syntax_errs().size(), parser.syntax_errs().front().what());
+            return 1;
+        }
+
+        // >>>>>> lexer & parser on two threads <<<<<<
+        begin = Clock::now();
+        {
+            parser::Parser queued_parser(std::make_unique<parser::TokenQueue>(source, queue_capacity));
+            queued_parser.Parse();
+            queued.Add(Seconds(begin, Clock::now()));
+            queued.items = queued_parser.arena()->allocation_count();
+            queue_stats = queued_parser.token_queue()->stats();
+        }
+
+        // >>>>>> parser sharing equal expressions <<<<<<
+        std::shared_ptr<ast::Program> shared_program;
+        std::shared_ptr<const ast::LineTable> shared_lines;
+        std::shared_ptr<const ast::Interner> shared_symbols;
+        begin = Clock::now();
+        {
+            parser::Parser shared_parser(source.data(), source.size());
+            shared_parser.set_hash_cons(true);
+            shared_program = shared_parser.Parse();
+            shared.Add(Seconds(begin, Clock::now()));
+            shared.items = shared_parser.arena()->allocation_count();
+            shared_bytes = shared_parser.arena()->bytes_used();
+            shared_hits = shared_parser.expr_pool().hits();
+            shared_lines = shared_parser.line_table();
+            shared_symbols = shared_parser.symbols();
+        }
+
+        // >>>>>> cache entry <<<<<<
+        begin = Clock::now();
+        std::string entry = ast::WriteProgram(*program, ast::CacheKey::Of(source));
+        store.Add(Seconds(begin, Clock::now()));
+        cache_size = entry.size();
+
+        begin = Clock::now();
+        {
+            auto key = ast::CacheKey::Of(source);
+            ast::LineTable lines(source);
+            if (!ast::CacheMatches(entry, key))
+            {
+                fprintf(stderr, "cache entry does not match its source\n");
+                return 1;
+            }
+            ast::Interner symbols;
+            auto loaded = ast::ReadProgram(entry, symbols);
+            load.Add(Seconds(begin, Clock::now()));
+            load.items = parse.items;
+        }
+
+        // >>>>>> semantic analysis <<<<<<
+        begin = Clock::now();
+        analysiser::init(parser.line_table(), parser.symbols());
+        analysiser::DoProgram(*program);
+        analyse.Add(Seconds(begin, Clock::now()));
+        analyse_allocations = AnalyseAllocations(*program, parser.line_table(), parser.symbols());
+        if (!analysiser::GetErrors().empty())
+        {
+            fprintf(stderr, "the program has %zu semantic errors\n", analysiser::GetErrors().size());
+            return 1;
+        }
+
+        begin = Clock::now();
+        analysiser::init(shared_lines, shared_symbols);
+        analysiser::DoProgram(*shared_program);
+        analyse_shared.Add(Seconds(begin, Clock::now()));
+        shared_program.reset();
+
+        // >>>>>> code generation <<<<<<
+        begin = Clock::now();
+        code_generation::Transformer trans(program, parser.line_table());
+        auto cg_program = trans.GetASTRoot();
+        transform.Add(Seconds(begin, Clock::now()));
+
+        begin = Clock::now();
+        code_generation::CodeGenerator code_generator;
+        code_generator.Interpret(cg_program);
+        code_size = code_generator.GetCCode().size();
+        generate.Add(Seconds(begin, Clock::now()));
+    }
+
+    // >>>>>> lexer in chunks on several threads <<<<<<
+    std::string large = source;
+    while (large.size() < static_cast<size_t>(scan_mb) << 20)
+        large += large;
+    std::vector<Stage> chunked;
+    for (size_t threads = 1; threads <= std::max(8u, std::thread::hardware_concurrency()); threads *= 2)
+    {
+        Stage stage;
+        for (int run = 0; run < runs; run++)
+        {
+            auto begin = Clock::now();
+            parser::TokenStream stream(large, threads);
+            stage.Add(Seconds(begin, Clock::now()));
+            stage.items = stream.size();
+        }
+        chunked.push_back(stage);
+    }
+
+    Print("scan", scan, "tokens");
+    printf("%-16s %zu bytes, %.1f MB/s\n", "scan rate", source.size(), source.size() / scan.best / 1e6);
+    for (size_t i = 0, threads = 1; i < chunked.size(); i++, threads *= 2)
+    {
+        std::string name = "scan (" + std::to_string(threads) + (threads == 1 ? " thread)" : " threads)");
+        printf("%-16s %10.2f ms %12zu tokens  %7.1f MB/s %6.2fx\n", name.c_str(), chunked[i].best * 1e3,
+               chunked[i].items, large.size() / chunked[i].best / 1e6, chunked[0].best / chunked[i].best);
+    }
+    Print("parse", parse, "nodes");
+    printf("%-16s %zu allocations, arena %zu KiB in %zu blocks\n", "heap (parse)", parse_allocations,
+           parse_bytes / 1024, parse_blocks);
+    Print("parse (queued)", queued, "nodes");
+    printf("%-16s capacity %zu, max depth %zu, scanner stalls %zu, parser stalls %zu\n", "token queue",
+           queue_stats.capacity, queue_stats.max_depth, queue_stats.producer_stalls, queue_stats.consumer_stalls);
+    Print("parse (shared)", shared, "nodes");
+    printf("%-16s %zu subtrees shared, arena %zu KiB instead of %zu KiB\n", "expr pool", shared_hits,
+           shared_bytes / 1024, parse_bytes / 1024);
+    Print("load (cache)", load, "nodes");
+    printf("%-16s %zu KiB, written in %.2f ms\n", "cache entry", cache_size / 1024, store.best * 1e3);
+    Print("DoProgram", analyse, "");
+    Print("analyse (shared)", analyse_shared, "");
+    if (!input && shape.subprograms > 0 && shape.statements > 0)
+    {
+        // the same program with every function body twice as long
+        bench::ProgramShape longer = shape;
+        longer.statements *= 2;
+        std::string longer_source = bench::GenerateProgram(longer);
+        parser::Parser longer_parser(longer_source.data(), longer_source.size());
+        auto longer_program = longer_parser.Parse();
+        size_t extra = static_cast<size_t>(shape.subprograms) * shape.statements;
+        double per_statement =
+            (static_cast<double>(AnalyseAllocations(*longer_program, longer_parser.line_table(), longer_parser.symbols())) - analyse_allocations) / extra;
+        printf("%-16s %zu allocations, %.2f per extra statement\n", "heap (analyse)", analyse_allocations,
+               per_statement);
+    }
+    else
+        printf("%-16s %zu allocations\n", "heap (analyse)", analyse_allocations);
+    Print("Transformer", transform, "");
+    Print("Interpret", generate, "");
+    printf("generated %zu bytes of C\n", code_size);
+
+    // >>>>>> symbol table <<<<<<
+    const int lookups = 20000;
+    for (int globals = 1000; globals <= 64000; globals *= 8)
+    {
+        double program_best = 1e30, function_best = 1e30;
+        for (int run = 0; run < runs; run++)
+        {
+            program_best = std::min(program_best, Lookup(globals, lookups, false));
+            function_best = std::min(function_best, Lookup(globals, lookups, true));
+        }
+        printf("%-16s %6d globals %8.1f ns from the program, %8.1f ns from a function\n", "lookup", globals,
+               program_best * 1e9, function_best * 1e9);
+    }
+
+    // >>>>>> node ownership <<<<<<
+    const int nodes = 1000000;
+    double owning_best = 1e30, borrowing_best = 1e30;
+    size_t owning_bytes = 0, borrowing_bytes = 0;
+    for (int run = 0; run < runs; run++)
+    {
+        owning_best = std::min(owning_best, NodeCost(nodes, true, owning_bytes));
+        borrowing_best = std::min(borrowing_best, NodeCost(nodes, false, borrowing_bytes));
+    }
+    printf("%-16s %8.1f ns %3zu bytes borrowing the arena, %8.1f ns %3zu bytes owning it\n", "node",
+           borrowing_best * 1e9, borrowing_bytes, owning_best * 1e9, owning_bytes);
+    return 0;
+}
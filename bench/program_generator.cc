@@ -0,0 +1,108 @@
+#include "program_generator.h"
+
+namespace pascal2c::bench
+{
+    // param:
+    //     terms is the number of operands
+    // return:
+    //     one long integer expression over the locals of a generated function
+    static std::string LongExpression(int terms)
+    {
+        static const char *ops[] = {" + ", " - ", " * ", " div ", " mod "};
+        std::string expr = "x";
+        for (int i = 1; i < terms; i++)
+        {
+            expr += ops[i % 5];
+            // div and mod by a non-zero literal, a parenthesised term now and then
+            if (i % 5 >= 3)
+                expr += std::to_string(i % 7 + 1);
+            else if (i % 4 == 0)
+                expr += "(y + " + std::to_string(i) + ")";
+            else
+                expr += i % 2 ? "t" : "k";
+        }
+        return expr;
+    }
+
+    static std::string Indent(int depth)
+    {
+        return std::string(4 * depth, ' ');
+    }
+
+    // param:
+    //     index is the number of the function, it may call the ones before it
+    static void AppendFunction(std::string &out, const ProgramShape &shape, int index)
+    {
+        std::string name = "f" + std::to_string(index);
+        out += "function " + name + "(x, y: integer): integer;\n";
+        out += "var\n    t, k: integer;\nbegin\n";
+        out += "    t := " + LongExpression(shape.expr_terms) + ";\n";
+
+        // if, while and for take turns on the way down
+        int depth = 1;
+        for (int level = 0; level < shape.nesting; level++, depth++)
+        {
+            switch (level % 3)
+            {
+            case 0:
+                out += Indent(depth) + "if t > " + std::to_string(level) + " then begin\n";
+                break;
+            case 1:
+                out += Indent(depth) + "while t < y do begin\n";
+                break;
+            default:
+                out += Indent(depth) + "for k := 1 to " + std::to_string(level + 2) + " do begin\n";
+                break;
+            }
+        }
+
+        for (int i = 0; i < shape.statements; i++)
+        {
+            out += Indent(depth);
+            switch (i % 4)
+            {
+            case 0:
+                out += "t := t + k * " + std::to_string(i + 1) + ";\n";
+                break;
+            case 1:
+                if (shape.arrays > 0)
+                    out += "a" + std::to_string(i % shape.arrays) + "[k, " + std::to_string(i % 10) + "] := t;\n";
+                else
+                    out += "g := t - 1;\n";
+                break;
+            case 2:
+                if (index > 0)
+                    out += "t := f" + std::to_string(i % index) + "(t, k);\n";
+                else
+                    out += "t := t div 2;\n";
+                break;
+            default:
+                out += "writeln(t, k);\n";
+                break;
+            }
+        }
+
+        while (--depth > 0)
+            out += Indent(depth) + "end;\n";
+        out += "    " + name + " := t\nend;\n\n";
+    }
+
+    std::string GenerateProgram(const ProgramShape &shape)
+    {
+        std::string out = "program Bench;\n\nvar\n    g, h: integer;\n";
+        for (int i = 0; i < shape.arrays; i++)
+        {
+            out += "    a" + std::to_string(i) + ": array [1.." + std::to_string(shape.array_bound) +
+                   ", 0..9] of integer;\n";
+        }
+        out += "\n";
+        for (int i = 0; i < shape.subprograms; i++)
+            AppendFunction(out, shape, i);
+
+        out += "begin\n    g := 1;\n";
+        for (int i = 0; i < shape.subprograms; i++)
+            out += "    h := f" + std::to_string(i) + "(g, h);\n";
+        out += "    writeln(h)\nend.\n";
+        return out;
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+
+namespace pascal2c::bench
+{
+    // size and shape of a synthesized program, every knob stresses another part
+    // of the compiler, the defaults give a program of a few hundred kilobytes
+    struct ProgramShape
+    {
+        int subprograms = 200;    // functions declared in the program block
+        int statements = 20;      // statements in the body of every function
+        int nesting = 8;          // depth of nested if/while/for blocks per function
+        int arrays = 50;          // global array declarations
+        int array_bound = 100000; // upper bound of the first dimension of every array
+        int expr_terms = 30;      // operands in the long expression of every function
+    };
+
+    // param:
+    //     shape is the size and shape of the program
+    // return:
+    //     the source of a program that passes the parser and the semantic analyser
+    std::string GenerateProgram(const ProgramShape &shape);
+}
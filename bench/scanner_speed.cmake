@@ -0,0 +1,29 @@
+# print the throughput of lexer_exe built on flex and on the SIMD scanner
+# the examples are repeated into one input of at least 16 MB, both scanners
+# scan it from memory, see lexer_exe --speed
+# usage: cmake -DFLEX_LEXER=<exe> -DSIMD_LEXER=<exe> -DEXAMPLES=<dir> -DINPUT=<file.pas> -P scanner_speed.cmake
+file(GLOB_RECURSE examples ${EXAMPLES}/*.pas)
+set(text "")
+foreach(example ${examples})
+        file(READ ${example} example_text)
+        string(APPEND text "${example_text}\n")
+endforeach()
+string(LENGTH "${text}" size)
+if(size EQUAL 0)
+        message(FATAL_ERROR "no examples in ${EXAMPLES}")
+endif()
+set(input "${text}")
+while(size LESS 16777216)
+        string(APPEND input "${input}")
+        math(EXPR size "${size} * 2")
+endwhile()
+file(WRITE ${INPUT} "${input}")
+
+foreach(scanner FLEX SIMD)
+        execute_process(COMMAND ${${scanner}_LEXER} --speed INPUT_FILE ${INPUT}
+                OUTPUT_VARIABLE speed OUTPUT_STRIP_TRAILING_WHITESPACE RESULT_VARIABLE result)
+        if(NOT result EQUAL 0)
+                message(FATAL_ERROR "the ${scanner} scanner failed on ${INPUT}")
+        endif()
+        message(STATUS "${scanner}: ${speed}")
+endforeach()
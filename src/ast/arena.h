@@ -0,0 +1,143 @@
+#ifndef PASCAL2C_SRC_AST_ARENA_H_
+#define PASCAL2C_SRC_AST_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace pascal2c::ast
+{
+    // bump allocator owning the memory of one compilation unit's AST
+    // memory is handed out from large blocks and never given back one by one,
+    // all blocks are released together when the arena is destroyed
+    // usage:
+    //     auto arena = std::make_shared<Arena>();
+    //     auto node = std::allocate_shared<Variable>(ArenaAllocator<Variable>(arena.get()), "a");
+    //     return Root(std::move(node), arena);
+    class Arena
+    {
+    public:
+        // param:
+        //     block_size is the size in bytes of every block requested from the heap
+        explicit Arena(size_t block_size = 64 * 1024) : block_size_(block_size) {}
+
+        Arena(const Arena &) = delete;
+        Arena &operator=(const Arena &) = delete;
+
+        // param:
+        //     size is the number of bytes wanted
+        //     align is the alignment of the returned address
+        // return:
+        //     uninitialized memory that lives as long as the arena
+        void *Allocate(size_t size, size_t align)
+        {
+            auto cur = reinterpret_cast<uintptr_t>(cur_);
+            auto aligned = (cur + align - 1) & ~(uintptr_t(align) - 1);
+            if (cur_ == nullptr || aligned + size > reinterpret_cast<uintptr_t>(end_))
+            {
+                NewBlock(size + align);
+                cur = reinterpret_cast<uintptr_t>(cur_);
+                aligned = (cur + align - 1) & ~(uintptr_t(align) - 1);
+            }
+            cur_ = reinterpret_cast<char *>(aligned + size);
+            bytes_used_ += size;
+            allocation_count_++;
+            return reinterpret_cast<void *>(aligned);
+        }
+
+        // keep other alive as long as this arena, for a tree with nodes from both
+        void Adopt(std::shared_ptr<Arena> other) { adopted_.push_back(std::move(other)); }
+
+        // return:
+        //     the number of blocks requested from the heap so far
+        size_t block_count() const { return blocks_.size(); }
+
+        // return:
+        //     the number of bytes handed out so far
+        size_t bytes_used() const { return bytes_used_; }
+
+        // return:
+        //     the number of allocations so far, one per node made with ArenaAllocator
+        size_t allocation_count() const { return allocation_count_; }
+
+    private:
+        void NewBlock(size_t at_least)
+        {
+            size_t size = at_least > block_size_ ? at_least : block_size_;
+            blocks_.emplace_back(new char[size]);
+            cur_ = blocks_.back().get();
+            end_ = cur_ + size;
+        }
+
+        size_t block_size_;
+        size_t bytes_used_ = 0;
+        size_t allocation_count_ = 0;
+        char *cur_ = nullptr;
+        char *end_ = nullptr;
+        std::vector<std::unique_ptr<char[]>> blocks_;
+        std::vector<std::shared_ptr<Arena>> adopted_; // see Adopt
+    };
+
+    // standard allocator drawing from an Arena
+    // std::allocate_shared keeps a copy of the allocator inside every control block, this
+    // one borrows the arena by pointer, so a node does not keep its arena alive, see Root
+    // a shared_ptr to the arena in every control block cost 8 bytes and two atomic
+    // reference counts per node, pascal2c_bench "node" measured 160-177 ns per node
+    // made and freed with it against 45 ns without
+    template <typename Tp>
+    class ArenaAllocator
+    {
+    public:
+        using value_type = Tp;
+
+        explicit ArenaAllocator(Arena *arena) : arena_(arena) {}
+
+        template <typename Up>
+        ArenaAllocator(const ArenaAllocator<Up> &other) : arena_(other.arena()) {}
+
+        Tp *allocate(size_t n)
+        {
+            return static_cast<Tp *>(arena_->Allocate(n * sizeof(Tp), alignof(Tp)));
+        }
+
+        // memory is reclaimed when the arena is destroyed
+        void deallocate(Tp *, size_t) {}
+
+        Arena *arena() const { return arena_; }
+
+        template <typename Up>
+        bool operator==(const ArenaAllocator<Up> &other) const { return arena_ == other.arena(); }
+
+        template <typename Up>
+        bool operator!=(const ArenaAllocator<Up> &other) const { return arena_ != other.arena(); }
+
+    private:
+        Arena *arena_;
+    };
+
+    // the nodes of a tree only point at each other, the root handed out of the
+    // parser or the cache loader is the one link that keeps their arena alive
+    // a child kept on its own must not outlive the root it came with
+    // param:
+    //     node is the root of a tree allocated from arena
+    // return:
+    //     node, also owning arena, the tree is released before the arena
+    //     nullptr if node is
+    template <typename Tp>
+    std::shared_ptr<Tp> Root(std::shared_ptr<Tp> node, std::shared_ptr<Arena> arena)
+    {
+        if (node == nullptr)
+        {
+            return nullptr;
+        }
+        // members are destroyed last to first, the tree goes before its arena
+        auto owner = std::make_shared<std::pair<std::shared_ptr<Arena>, std::shared_ptr<Tp>>>(std::move(arena),
+                                                                                               std::move(node));
+        return std::shared_ptr<Tp>(owner, owner->second.get());
+    }
+}
+
+#endif // !PASCAL2C_SRC_AST_ARENA_H_
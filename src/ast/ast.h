@@ -1,35 +1,47 @@
 #ifndef AST_H
 #define AST_H
 
+#include <cstdint>
 #include <iostream>
 #include <sstream>
 
+#include "ast/interner.h"
+#include "ast/line_table.h"
+
 #define GETTER(type, name) \
     const type &name() const { return name##_; }
 
 namespace pascal2c::ast
 {
     // Abstract Syntax Tree
+    // a node keeps only the byte offset of its first token, line() and column()
+    // look it up in the LineTable of the source it was parsed from
     class Ast
     {
     public:
         // param:
-        //     line is the line number of the first token of the node
-        //     column is the column number of the first token of the node
-        Ast(const int line, const int column)
-            : line_(line), column_(column){};
+        //     offset is the byte offset of the first token of the node in the source
+        explicit Ast(const uint32_t offset) : offset_(offset) {}
 
-        Ast() : line_(1), column_(1){};
+        Ast() : offset_(0) {}
 
-        inline void SetLineAndColumn(const int line, const int column)
-        {
-            line_ = line;
-            column_ = column;
-        }
+        virtual ~Ast() = default;
+
+        inline void SetOffset(const uint32_t offset) { offset_ = offset; }
 
-        inline virtual const int &line() const { return line_; }
+        inline uint32_t offset() const { return offset_; }
 
-        inline virtual const int &column() const { return column_; }
+        // param:
+        //     lines is the line table of the source the node was parsed from
+        // return:
+        //     the line number of the first token of the node
+        inline int line(const LineTable &lines) const { return lines.Line(offset_); }
+
+        // param:
+        //     lines is the line table of the source the node was parsed from
+        // return:
+        //     the column number of the first token of the node
+        inline int column(const LineTable &lines) const { return lines.Column(offset_); }
 
     protected:
         // for test use
@@ -47,14 +59,14 @@ namespace pascal2c::ast
         // for test use
         // param:
         //     str_s is the string stream to output to
-        inline void LineColumnOutput(std::stringstream &str_s) const
+        //     lines is the line table of the source the node was parsed from
+        inline void LineColumnOutput(std::stringstream &str_s, const LineTable &lines) const
         {
-            str_s << line_ << ":" << column_ << " ";
+            str_s << line(lines) << ":" << column(lines) << " ";
         }
 
     private:
-        int line_;   // line number of the first token of the node
-        int column_; // column number of the first token of the node
+        uint32_t offset_; // byte offset of the first token of the node
     };
 }
 
@@ -18,7 +18,7 @@ extern "C"
     std::stringstream str_s;\
     do{ \
         IndentOutput(str_s, level);     \
-        str_s << line() << ":" << column() <<" "; \
+        str_s << line(lines) << ":" << column(lines) <<" "; \
     }while(0)
 
 namespace pascal2c
@@ -26,11 +26,9 @@ namespace pascal2c
 
     static int Op(int token)
     {
-        static bool inited = false;
-        static std::unordered_map<int,int> op;
-        if(!inited){
-            for(int i = 0;i < 500;i ++)
-                op[i] = i;
+        // built once, thread safe, then only read
+        static const std::unordered_map<int,int> op = []{
+            std::unordered_map<int,int> op;
             op['+'] = '+';
             op['-'] = '-';
             op['*'] = '*';
@@ -43,9 +41,10 @@ namespace pascal2c
             op[TOK_MOD] = 'm';
             op[TOK_DIV] = 'd';
             op[TOK_NOT] = 'n';
-            inited = true;
-        }
-        return op[token];
+            return op;
+        }();
+        auto it = op.find(token);
+        return it == op.end() ? token : it->second;
     }
 
     void ast::CallValue::AddParam(std::shared_ptr<Expression> expr)
@@ -58,7 +57,7 @@ namespace pascal2c
         expr_list_.push_back(std::move(expr));
     }
 
-    std::string ast::CallValue::ToString(int level) const
+    std::string ast::CallValue::ToString(int level, const LineTable &lines) const
     {
         INIT_TOSTRING(str_s, level);
         str_s << "function:" << id_;
@@ -68,12 +67,12 @@ namespace pascal2c
             str_s << "\n";
             IndentOutput(str_s, level);
             str_s << "expr " << i + 1 << ":\n"
-                  << params_[i]->ToString(level + 1);
+                  << params_[i]->ToString(level + 1, lines);
         }
         return str_s.str();
     }
 
-    std::string ast::Variable::ToString(int level) const
+    std::string ast::Variable::ToString(int level, const LineTable &lines) const
     {
         INIT_TOSTRING(str_s, level);
         str_s << "variable:" << id_;
@@ -83,19 +82,19 @@ namespace pascal2c
             str_s << "\n";
             IndentOutput(str_s, level);
             str_s << "index " << i + 1 << ":\n"
-                  << expr_list_[i]->ToString(level + 1);
+                  << expr_list_[i]->ToString(level + 1, lines);
         }
         return str_s.str();
     }
 
-    std::string ast::IntegerValue::ToString(int level) const
+    std::string ast::IntegerValue::ToString(int level, const LineTable &lines) const
     {
         INIT_TOSTRING(str_s, level);
         str_s << value_;
         return str_s.str();
     }
 
-    std::string ast::RealValue::ToString(int level) const
+    std::string ast::RealValue::ToString(int level, const LineTable &lines) const
     {
         INIT_TOSTRING(str_s, level);
         IndentOutput(str_s, level);
@@ -103,7 +102,7 @@ namespace pascal2c
         return str_s.str();
     }
 
-    std::string ast::CharValue::ToString(int level) const
+    std::string ast::CharValue::ToString(int level, const LineTable &lines) const
     {
         char ch = (char)ch_;
         INIT_TOSTRING(str_s, level);
@@ -111,7 +110,7 @@ namespace pascal2c
         return str_s.str();
     }
 
-    std::string ast::BooleanValue::ToString(int level) const
+    std::string ast::BooleanValue::ToString(int level, const LineTable &lines) const
     {
         INIT_TOSTRING(str_s, level);
         if(value_)
@@ -121,37 +120,86 @@ namespace pascal2c
         return str_s.str();
     }
 
-    std::string ast::BinaryExpr::ToString(int level) const
+    // return:
+    //     true if destroying expr would go on to destroy nested operands
+    static bool OwnsNestedOperands(const std::shared_ptr<ast::Expression> &expr)
+    {
+        return expr != nullptr && expr.use_count() == 1 &&
+               (expr->GetType() == ast::BINARY || expr->GetType() == ast::UNARY);
+    }
+
+    void ast::ReleaseOperands(vector<std::shared_ptr<Expression>> &operands)
+    {
+        while (!operands.empty())
+        {
+            std::shared_ptr<Expression> expr = std::move(operands.back());
+            operands.pop_back();
+            if (!OwnsNestedOperands(expr))
+                continue;
+            // move the operands out, expr then dies here without recursing
+            if (expr->GetType() == BINARY)
+            {
+                auto *binary = static_cast<BinaryExpr *>(expr.get());
+                operands.push_back(std::move(binary->lhs_));
+                operands.push_back(std::move(binary->rhs_));
+            }
+            else
+            {
+                operands.push_back(std::move(static_cast<UnaryExpr *>(expr.get())->factor_));
+            }
+        }
+    }
+
+    ast::BinaryExpr::~BinaryExpr()
+    {
+        if (!OwnsNestedOperands(lhs_) && !OwnsNestedOperands(rhs_))
+            return;
+        vector<std::shared_ptr<Expression>> operands;
+        operands.push_back(std::move(lhs_));
+        operands.push_back(std::move(rhs_));
+        ReleaseOperands(operands);
+    }
+
+    ast::UnaryExpr::~UnaryExpr()
+    {
+        if (!OwnsNestedOperands(factor_))
+            return;
+        vector<std::shared_ptr<Expression>> operands;
+        operands.push_back(std::move(factor_));
+        ReleaseOperands(operands);
+    }
+
+    std::string ast::BinaryExpr::ToString(int level, const LineTable &lines) const
     {
         INIT_TOSTRING(str_s, level);
         str_s << "binary_op:" << '\'' << (char)Op(op_) << '\'' << "\n";
         IndentOutput(str_s, level);
         str_s << "lhs :\n";
-        str_s << lhs_->ToString(level + 1) << "\n";
+        str_s << lhs_->ToString(level + 1, lines) << "\n";
         IndentOutput(str_s, level);
         str_s << "rhs :\n";
-        str_s << rhs_->ToString(level + 1);
+        str_s << rhs_->ToString(level + 1, lines);
         return str_s.str();
     }
 
-    std::string ast::UnaryExpr::ToString(int level) const
+    std::string ast::UnaryExpr::ToString(int level, const LineTable &lines) const
     {
         INIT_TOSTRING(str_s, level);
         str_s << "unary_op:" << '\'' << (char)Op(op_) << '\'' << "\n";
         IndentOutput(str_s, level);
         str_s << "expr :\n"
-              << factor_->ToString(level + 1);
+              << factor_->ToString(level + 1, lines);
         return str_s.str();
     }
 
-    std::string ast::CallOrVar::ToString(int level) const {
+    std::string ast::CallOrVar::ToString(int level, const LineTable &lines) const {
         INIT_TOSTRING(str_s, level);
         str_s << "CallOrVar: " << id_;
 
         return str_s.str();
     }
 
-    std::string ast::StringValue::ToString(int level) const {
+    std::string ast::StringValue::ToString(int level, const LineTable &lines) const {
         INIT_TOSTRING(str_s, level);
         str_s << "string: " << value_;
 
@@ -5,6 +5,8 @@
 #ifndef PASCAL2C_EXPR_H
 #define PASCAL2C_EXPR_H
 
+#include <cassert>
+#include <type_traits>
 #include <utility>
 #include <vector>
 #include <memory>
@@ -31,6 +33,16 @@ namespace pascal2c::ast
         STRING = 9,
     };
 
+    class Expression;
+
+    // free the operands of a binary or unary expression being destroyed
+    // the nested operands nobody else holds are taken apart one at a time
+    // with operands as the work list, so destroying a deeply nested
+    // expression does not recurse once per level
+    // param:
+    //     operands are the operands to release, the vector is left empty
+    void ReleaseOperands(vector<std::shared_ptr<Expression>> &operands);
+
     // base class for expression
     class Expression : public Ast
     {
@@ -38,27 +50,32 @@ namespace pascal2c::ast
         // for test use
         // param:
         //     level is the level of indentation that should be applied to the returned string
+        //     lines is the line table of the parsed source, the positions are looked up there
         // return:
         //     a string represents the statement
-        virtual std::string ToString(int level) const = 0;
+        virtual std::string ToString(int level, const LineTable &lines) const = 0;
 
-        // get the exact type of the expression
+        // get the exact type of the expression, it is kept in the node so asking costs no virtual call
         // return:
         //     one of ExprType
-        virtual ExprType GetType() const = 0;
+        inline ExprType GetType() const { return type_; }
+
+        explicit Expression(ExprType type) : type_(type) {}
+        Expression(ExprType type, uint32_t offset) : Ast(offset), type_(type) {}
 
-        Expression() = default;
-        Expression(int line, int col) : Ast(line, col) {}
+    private:
+        ExprType type_; // set by the constructor of the exact class
     };
 
     class StringValue : public Expression{
     public:
-        explicit StringValue(std::string value) : value_(std::move(value)) {}
-        StringValue(int line, int col, std::string value) :Expression(line,col), value_(std::move(value)) {}
+        static constexpr ExprType kType = STRING;
+
+        explicit StringValue(std::string value) : Expression(kType), value_(std::move(value)) {}
+        StringValue(uint32_t offset, std::string value) :Expression(kType, offset), value_(std::move(value)) {}
 
 
-        std::string ToString(int level) const override;
-        inline ExprType GetType() const override { return STRING; }
+        std::string ToString(int level, const LineTable &lines) const override;
 
         GETTER(std::string, value);
 
@@ -73,11 +90,12 @@ namespace pascal2c::ast
     class IntegerValue : public Expression
     {
     public:
-        explicit IntegerValue(int value) : value_(value) {}
-        IntegerValue(int line, int col, int value) : Expression(line, col), value_(value) {}
+        static constexpr ExprType kType = INT;
+
+        explicit IntegerValue(int value) : Expression(kType), value_(value) {}
+        IntegerValue(uint32_t offset, int value) : Expression(kType, offset), value_(value) {}
 
-        std::string ToString(int level) const override;
-        inline ExprType GetType() const override { return INT; }
+        std::string ToString(int level, const LineTable &lines) const override;
 
         GETTER(int, value);
 
@@ -92,11 +110,12 @@ namespace pascal2c::ast
     class RealValue : public Expression
     {
     public:
-        explicit RealValue(double value) : value_(value) {}
-        RealValue(int line, int col, double value) : Expression(line, col), value_(value) {}
+        static constexpr ExprType kType = REAL;
 
-        std::string ToString(int level) const override;
-        inline ExprType GetType() const override { return REAL; }
+        explicit RealValue(double value) : Expression(kType), value_(value) {}
+        RealValue(uint32_t offset, double value) : Expression(kType, offset), value_(value) {}
+
+        std::string ToString(int level, const LineTable &lines) const override;
 
         GETTER(double, value);
 
@@ -111,11 +130,12 @@ namespace pascal2c::ast
     class CharValue : public Expression
     {
     public:
-        explicit CharValue(int ch) : ch_(ch) {}
-        CharValue(int line,int col, int ch) :Expression(line, col), ch_(ch) {}
+        static constexpr ExprType kType = CHAR;
+
+        explicit CharValue(int ch) : Expression(kType), ch_(ch) {}
+        CharValue(uint32_t offset, int ch) :Expression(kType, offset), ch_(ch) {}
 
-        std::string ToString(int level) const override;
-        inline ExprType GetType() const override { return CHAR; }
+        std::string ToString(int level, const LineTable &lines) const override;
 
         GETTER(int, ch);
     private:
@@ -129,11 +149,12 @@ namespace pascal2c::ast
     class BooleanValue : public Expression
     {
     public:
-        explicit BooleanValue(bool value) : value_(value) {}
-        BooleanValue(int line, int col, bool value) : Expression(line, col), value_(value) {}
+        static constexpr ExprType kType = BOOLEAN;
+
+        explicit BooleanValue(bool value) : Expression(kType), value_(value) {}
+        BooleanValue(uint32_t offset, bool value) : Expression(kType, offset), value_(value) {}
 
-        std::string ToString(int level) const override;
-        inline ExprType GetType() const override { return BOOLEAN; }
+        std::string ToString(int level, const LineTable &lines) const override;
 
         GETTER(bool, value);
     private:
@@ -146,20 +167,30 @@ namespace pascal2c::ast
     class CallOrVar : public Expression
     {
     public:
-        explicit CallOrVar(std::string id) : id_(std::move(id)) {}
-        CallOrVar(int line, int col, std::string id) : Expression(line, col), id_(std::move(id)) {}
+        static constexpr ExprType kType = CALL_OR_VAR;
 
-        std::string ToString(int level) const override;
-        inline virtual ExprType GetType() const override { return CALL_OR_VAR; }
+        explicit CallOrVar(std::string id) : Expression(kType), id_(std::move(id)) {}
+        // symbol is the interned id, 0 for a node that was not parsed
+        CallOrVar(uint32_t offset, std::string id, SymbolId symbol = 0) : Expression(kType, offset), id_(std::move(id)), symbol_(symbol) {}
+
+        std::string ToString(int level, const LineTable &lines) const override;
 
         GETTER(std::string, id);
+        // the interned id, see Interner
+        inline SymbolId symbol() const { return symbol_; }
     protected:
+        // for Variable and CallValue, which are CallOrVar once it is known which one it is
+        CallOrVar(ExprType type, std::string id) : Expression(type), id_(std::move(id)) {}
+        CallOrVar(ExprType type, uint32_t offset, std::string id, SymbolId symbol = 0) :
+                                        Expression(type, offset), id_(std::move(id)), symbol_(symbol) {}
+
         // id_ is the name of the variable or function
         // in the example of var1 := A;
         // id_ is "A"
         // and we do not need an expression list since no matter
         // it is a variable or a function call, it has no parameters
         std::string id_;
+        SymbolId symbol_ = 0; // id_ interned
     };
 
     // represent a function call
@@ -169,16 +200,20 @@ namespace pascal2c::ast
     class CallValue : public CallOrVar
     {
     public:
-        explicit CallValue(std::string func_name) : CallOrVar(std::move(func_name)) {}
-        CallValue(int line, int col, std::string func_name) : CallOrVar(line, col, std::move(func_name)) {}
-        CallValue(std::string func_name, vector<std::shared_ptr<Expression>> params) : CallOrVar(std::move(func_name)) , params_(std::move(params)) {}
-        CallValue(int line, int col, std::string func_name, vector<std::shared_ptr<Expression>> params) :
-                                        CallOrVar(line, col, std::move(func_name)), params_(std::move(params)) {}
+        static constexpr ExprType kType = CALL;
+
+        explicit CallValue(std::string func_name) : CallOrVar(kType, std::move(func_name)) {}
+        CallValue(uint32_t offset, std::string func_name) : CallOrVar(kType, offset, std::move(func_name)) {}
+        CallValue(std::string func_name, vector<std::shared_ptr<Expression>> params) : CallOrVar(kType, std::move(func_name)) , params_(std::move(params)) {}
+        CallValue(uint32_t offset, std::string func_name, vector<std::shared_ptr<Expression>> params) :
+                                        CallOrVar(kType, offset, std::move(func_name)), params_(std::move(params)) {}
+        // symbol is the interned func_name
+        CallValue(uint32_t offset, std::string func_name, SymbolId symbol, vector<std::shared_ptr<Expression>> params = {}) :
+                                        CallOrVar(kType, offset, std::move(func_name), symbol), params_(std::move(params)) {}
 
         void AddParam(std::shared_ptr<Expression> expr);
 
-        std::string ToString(int level) const override;
-        inline ExprType GetType() const override { return CALL; }
+        std::string ToString(int level, const LineTable &lines) const override;
 
         GETTER(vector<std::shared_ptr<Expression>>, params);
 
@@ -195,17 +230,21 @@ namespace pascal2c::ast
     class Variable : public CallOrVar
     {
     public:
-        explicit Variable(std::string id) : CallOrVar(std::move(id)) {}
-        Variable(int line, int col, std::string id) : CallOrVar(line, col, std::move(id)) {}
-        Variable(std::string id, vector<std::shared_ptr<Expression>> expr_list) : CallOrVar(std::move(id)) , expr_list_(
+        static constexpr ExprType kType = VARIABLE;
+
+        explicit Variable(std::string id) : CallOrVar(kType, std::move(id)) {}
+        Variable(uint32_t offset, std::string id) : CallOrVar(kType, offset, std::move(id)) {}
+        Variable(std::string id, vector<std::shared_ptr<Expression>> expr_list) : CallOrVar(kType, std::move(id)) , expr_list_(
                                                                                                           std::move(expr_list)) {}
-        Variable(int line, int col, std::string id, vector<std::shared_ptr<Expression>> expr_list) :
-                CallOrVar(line, col, std::move(id)), expr_list_(std::move(expr_list)) {}
+        Variable(uint32_t offset, std::string id, vector<std::shared_ptr<Expression>> expr_list) :
+                CallOrVar(kType, offset, std::move(id)), expr_list_(std::move(expr_list)) {}
+        // symbol is the interned id
+        Variable(uint32_t offset, std::string id, SymbolId symbol, vector<std::shared_ptr<Expression>> expr_list = {}) :
+                CallOrVar(kType, offset, std::move(id), symbol), expr_list_(std::move(expr_list)) {}
 
         void AddExpr(std::shared_ptr<Expression> expr);
 
-        std::string ToString(int level) const override;
-        inline ExprType GetType() const override { return VARIABLE; }
+        std::string ToString(int level, const LineTable &lines) const override;
 
         GETTER(vector<std::shared_ptr<Expression>>, expr_list);
 
@@ -221,18 +260,22 @@ namespace pascal2c::ast
     class BinaryExpr : public Expression
     {
     public:
-        BinaryExpr(int op, std::shared_ptr<Expression> lhs, std::shared_ptr<Expression> rhs) : op_(op), lhs_(std::move(lhs)), rhs_(std::move(rhs)) {}
-        BinaryExpr(int line, int col, int op, std::shared_ptr<Expression> lhs, std::shared_ptr<Expression> rhs) :
-                Expression(line, col), op_(op), lhs_(std::move(lhs)), rhs_(std::move(rhs)) {}
+        static constexpr ExprType kType = BINARY;
+
+        BinaryExpr(int op, std::shared_ptr<Expression> lhs, std::shared_ptr<Expression> rhs) : Expression(kType), op_(op), lhs_(std::move(lhs)), rhs_(std::move(rhs)) {}
+        BinaryExpr(uint32_t offset, int op, std::shared_ptr<Expression> lhs, std::shared_ptr<Expression> rhs) :
+                Expression(kType, offset), op_(op), lhs_(std::move(lhs)), rhs_(std::move(rhs)) {}
+        ~BinaryExpr();
 
-        std::string ToString(int level) const override;
-        inline ExprType GetType() const override { return BINARY; }
+        std::string ToString(int level, const LineTable &lines) const override;
 
         GETTER(int, op);
         GETTER(std::shared_ptr<Expression>, lhs);
         GETTER(std::shared_ptr<Expression>, rhs);
 
     private:
+        friend void ReleaseOperands(vector<std::shared_ptr<Expression>> &operands);
+
         int op_;                                // operator
         std::shared_ptr<Expression> lhs_, rhs_; // two operands
     };
@@ -243,20 +286,81 @@ namespace pascal2c::ast
     class UnaryExpr : public Expression
     {
     public:
-        UnaryExpr(int op, std::shared_ptr<Expression> factor) : op_(op), factor_(std::move(factor)) {}
-        UnaryExpr(int line, int col, int op, std::shared_ptr<Expression> factor) :
-                Expression(line, col), op_(op), factor_(std::move(factor)) {}
+        static constexpr ExprType kType = UNARY;
+
+        UnaryExpr(int op, std::shared_ptr<Expression> factor) : Expression(kType), op_(op), factor_(std::move(factor)) {}
+        UnaryExpr(uint32_t offset, int op, std::shared_ptr<Expression> factor) :
+                Expression(kType, offset), op_(op), factor_(std::move(factor)) {}
+        ~UnaryExpr();
 
-        std::string ToString(int level) const override;
-        inline ExprType GetType() const override { return UNARY; }
+        std::string ToString(int level, const LineTable &lines) const override;
 
         GETTER(int, op);
         GETTER(std::shared_ptr<Expression>, factor);
 
     private:
+        friend void ReleaseOperands(vector<std::shared_ptr<Expression>> &operands);
+
         int op_;
         std::shared_ptr<Expression> factor_;
     };
+
+    // return:
+    //     true if expr is a T, told by its kind tag without rtti,
+    //     Variable and CallValue are CallOrVar as well
+    template <typename T>
+    inline bool IsA(const Expression &expr)
+    {
+        if constexpr (std::is_same_v<T, CallOrVar>)
+            return expr.GetType() == CALL_OR_VAR || expr.GetType() == VARIABLE || expr.GetType() == CALL;
+        else
+            return expr.GetType() == T::kType;
+    }
+
+    // the expression as its exact class, no shared_ptr is copied
+    // param:
+    //     expr must be a T, see IsA
+    template <typename T>
+    inline const T &As(const Expression &expr)
+    {
+        assert(IsA<T>(expr));
+        return static_cast<const T &>(expr);
+    }
+
+    // call visitor with expr as its exact class, the switch over the kind tag replaces
+    // a chain of dynamic_pointer_cast and every overload is picked at compile time
+    // usage:
+    //     Visit(expr, [](const auto &node) { ... });
+    // param:
+    //     visitor is callable with every expression class, all with the same return type
+    template <typename Visitor>
+    inline decltype(auto) Visit(const Expression &expr, Visitor &&visitor)
+    {
+        switch (expr.GetType())
+        {
+            case INT:
+                return visitor(static_cast<const IntegerValue &>(expr));
+            case REAL:
+                return visitor(static_cast<const RealValue &>(expr));
+            case CHAR:
+                return visitor(static_cast<const CharValue &>(expr));
+            case BOOLEAN:
+                return visitor(static_cast<const BooleanValue &>(expr));
+            case STRING:
+                return visitor(static_cast<const StringValue &>(expr));
+            case VARIABLE:
+                return visitor(static_cast<const Variable &>(expr));
+            case CALL:
+                return visitor(static_cast<const CallValue &>(expr));
+            case BINARY:
+                return visitor(static_cast<const BinaryExpr &>(expr));
+            case UNARY:
+                return visitor(static_cast<const UnaryExpr &>(expr));
+            case CALL_OR_VAR:
+            default:
+                return visitor(static_cast<const CallOrVar &>(expr));
+        }
+    }
 }
 
 #endif // PASCAL2C_EXPR_H
@@ -0,0 +1,168 @@
+#include "ast/expr_pool.h"
+
+#include <cstring>
+#include <functional>
+
+namespace pascal2c::ast
+{
+    static size_t Combine(size_t seed, size_t value)
+    {
+        return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+    }
+
+    ExprPool::Shape ExprPool::Shape::Of(const Expression &expr)
+    {
+        Shape shape;
+        shape.type = expr.GetType();
+        switch (expr.GetType())
+        {
+            case INT:
+                shape.value = As<IntegerValue>(expr).value();
+                break;
+            case REAL:
+                shape.real = As<RealValue>(expr).value();
+                break;
+            case CHAR:
+                shape.value = As<CharValue>(expr).ch();
+                break;
+            case BOOLEAN:
+                shape.value = As<BooleanValue>(expr).value();
+                break;
+            case STRING:
+                shape.text = As<StringValue>(expr).value();
+                break;
+            case CALL_OR_VAR:
+                shape.text = As<CallOrVar>(expr).id();
+                break;
+            case VARIABLE:
+                shape.text = As<Variable>(expr).id();
+                shape.list = &As<Variable>(expr).expr_list();
+                break;
+            case CALL:
+                shape.text = As<CallValue>(expr).id();
+                shape.list = &As<CallValue>(expr).params();
+                break;
+            case BINARY:
+                shape.value = As<BinaryExpr>(expr).op();
+                shape.operands[0] = As<BinaryExpr>(expr).lhs().get();
+                shape.operands[1] = As<BinaryExpr>(expr).rhs().get();
+                break;
+            case UNARY:
+                shape.value = As<UnaryExpr>(expr).op();
+                shape.operands[0] = As<UnaryExpr>(expr).factor().get();
+                break;
+        }
+        return shape;
+    }
+
+    // calls visit with every child of shape, left to right
+    template <typename Visitor>
+    static void ForEachChild(const ExprPool::Shape &shape, Visitor &&visit)
+    {
+        for (const Expression *operand : shape.operands)
+            if (operand != nullptr)
+                visit(operand);
+        if (shape.list != nullptr)
+            for (const auto &child : *shape.list)
+                visit(child.get());
+    }
+
+    // return:
+    //     a hash of the kind and the values of a node, not of its children
+    static size_t NodeHash(const ExprPool::Shape &shape)
+    {
+        size_t hash = std::hash<int>()(shape.type);
+        if (shape.type == REAL)
+            return Combine(hash, std::hash<double>()(shape.real));
+        hash = Combine(hash, std::hash<int64_t>()(shape.value));
+        return Combine(hash, std::hash<std::string_view>()(shape.text));
+    }
+
+    // return:
+    //     true if a and b have the same kind and values, their children are not compared
+    static bool SameNode(const ExprPool::Shape &a, const ExprPool::Shape &b)
+    {
+        // reals bit by bit, 0.0 and -0.0 are different literals
+        return a.type == b.type && a.value == b.value && a.text == b.text &&
+               std::memcmp(&a.real, &b.real, sizeof(double)) == 0;
+    }
+
+    size_t ExprPool::ShallowHash(const Shape &shape)
+    {
+        size_t hash = NodeHash(shape);
+        ForEachChild(shape, [&hash](const Expression *child) {
+            hash = Combine(hash, std::hash<const Expression *>()(child));
+        });
+        return hash;
+    }
+
+    bool ExprPool::ShallowEqual(const Shape &a, const Shape &b)
+    {
+        if (!SameNode(a, b) || a.operands[0] != b.operands[0] || a.operands[1] != b.operands[1])
+            return false;
+        if (a.list == nullptr || b.list == nullptr)
+            return (a.list == nullptr || a.list->empty()) && (b.list == nullptr || b.list->empty());
+        if (a.list->size() != b.list->size())
+            return false;
+        for (size_t i = 0; i < a.list->size(); i++)
+            if ((*a.list)[i] != (*b.list)[i])
+                return false;
+        return true;
+    }
+
+    bool ExprPool::Shareable(const Shape &shape) const
+    {
+        if (shape.type == CALL)
+            return false;
+        // a pooled child is the very node the pool holds
+        bool pooled = true;
+        ForEachChild(shape, [this, &pooled](const Expression *child) {
+            pooled = pooled && pooled_.count(child) > 0;
+        });
+        return pooled;
+    }
+
+    std::shared_ptr<Expression> ExprPool::Find(const Shape &shape) const
+    {
+        if (!Shareable(shape))
+            return nullptr;
+        auto range = nodes_.equal_range(ShallowHash(shape));
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (ShallowEqual(Shape::Of(*it->second), shape))
+            {
+                hits_++;
+                return it->second;
+            }
+        }
+        return nullptr;
+    }
+
+    std::shared_ptr<Expression> ExprPool::Intern(std::shared_ptr<Expression> expr)
+    {
+        Shape shape = Shape::Of(*expr);
+        if (!Shareable(shape))
+            return expr;
+        size_t hash = ShallowHash(shape);
+        auto range = nodes_.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second == expr)
+                return expr;
+            if (ShallowEqual(Shape::Of(*it->second), shape))
+            {
+                hits_++;
+                return it->second;
+            }
+        }
+        pooled_.insert(expr.get());
+        nodes_.emplace(hash, expr);
+        return expr;
+    }
+
+    void ExprPool::Clear()
+    {
+        nodes_.clear();
+        pooled_.clear();
+    }
+}
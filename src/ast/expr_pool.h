@@ -0,0 +1,135 @@
+#ifndef PASCAL2C_SRC_AST_EXPR_POOL_H_
+#define PASCAL2C_SRC_AST_EXPR_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "ast/expr.h"
+
+namespace pascal2c::ast
+{
+    // hash-consing of expressions, structurally equal subtrees become one shared node
+    // only pure subtrees are shared, a call and everything above it are left alone
+    // a CallOrVar is shared, it may still name a function without parameters so a
+    // pass evaluating a shared node once has to look the name up first
+    // the nodes are pooled bottom up, the children of a node given to Intern must
+    // have been pooled first, so two nodes are equal if their kinds, values and
+    // child pointers are, and finding a node costs the same at every depth
+    // a shared node keeps the place of its first occurrence, an error found in any
+    // of its occurrences is reported there
+    // usage:
+    //     ExprPool pool;
+    //     auto a = pool.Intern(std::make_shared<CallOrVar>("a"));
+    //     auto b = pool.Intern(std::make_shared<CallOrVar>("a"));
+    //     assert(a == b);
+    class ExprPool
+    {
+    public:
+        // what the pool compares of a node, its kind, values and child pointers,
+        // without the node, so a parser can ask for a node before making one
+        struct Shape
+        {
+            ExprType type = INT;
+            int64_t value = 0;                 // of an INT, CHAR or BOOLEAN, the operator of a BINARY or UNARY
+            double real = 0;                   // of a REAL
+            std::string_view text;             // of a STRING, the id of a CALL_OR_VAR, VARIABLE or CALL
+            const Expression *operands[2] = {}; // of a BINARY, the factor of a UNARY
+            const vector<std::shared_ptr<Expression>> *list = nullptr; // indexes of a VARIABLE, params of a CALL
+
+            // return:
+            //     the shape of a made node, its strings stay owned by expr
+            static Shape Of(const Expression &expr);
+
+            // return:
+            //     the shape of the node Tp(offset, args...) would make, args must
+            //     outlive the shape
+            // usage:
+            //     pool.Find(ExprPool::Shape::Of<BinaryExpr>('+', lhs, rhs));
+            template <typename Tp, typename... Args>
+            static Shape Of(const Args &...args)
+            {
+                Shape shape;
+                shape.type = Tp::kType;
+                auto fields = std::forward_as_tuple(args...);
+                if constexpr (std::is_same_v<Tp, IntegerValue> || std::is_same_v<Tp, CharValue>)
+                    shape.value = static_cast<int>(std::get<0>(fields));
+                else if constexpr (std::is_same_v<Tp, BooleanValue>)
+                    shape.value = static_cast<bool>(std::get<0>(fields));
+                else if constexpr (std::is_same_v<Tp, RealValue>)
+                    shape.real = std::get<0>(fields);
+                else if constexpr (std::is_same_v<Tp, StringValue> || std::is_same_v<Tp, CallOrVar>)
+                    shape.text = std::get<0>(fields);
+                else if constexpr (std::is_same_v<Tp, Variable> || std::is_same_v<Tp, CallValue>)
+                {
+                    // (id[, symbol][, list]), the symbol follows from the id
+                    constexpr size_t last = sizeof...(Args) - 1;
+                    shape.text = std::get<0>(fields);
+                    if constexpr (last > 0 && std::is_same_v<std::tuple_element_t<last, std::tuple<Args...>>,
+                                                             vector<std::shared_ptr<Expression>>>)
+                        shape.list = &std::get<last>(fields);
+                }
+                else if constexpr (std::is_same_v<Tp, BinaryExpr>)
+                {
+                    shape.value = std::get<0>(fields);
+                    shape.operands[0] = std::get<1>(fields).get();
+                    shape.operands[1] = std::get<2>(fields).get();
+                }
+                else if constexpr (std::is_same_v<Tp, UnaryExpr>)
+                {
+                    shape.value = std::get<0>(fields);
+                    shape.operands[0] = std::get<1>(fields).get();
+                }
+                return shape;
+            }
+        };
+
+        // return:
+        //     the pooled node equal to expr, nullptr if there is none or expr cannot be shared
+        std::shared_ptr<Expression> Find(const Expression &expr) const { return Find(Shape::Of(expr)); }
+
+        // return:
+        //     the pooled node of the given shape, nullptr if there is none or it cannot be shared
+        std::shared_ptr<Expression> Find(const Shape &shape) const;
+
+        // return:
+        //     the pooled node equal to expr, expr itself after pooling it if there is
+        //     none, expr unchanged if it cannot be shared
+        std::shared_ptr<Expression> Intern(std::shared_ptr<Expression> expr);
+
+        // forget every node, eg. when a scope ends and its names mean something else,
+        // hits() keeps counting
+        void Clear();
+
+        // return:
+        //     the number of pooled nodes
+        size_t size() const { return nodes_.size(); }
+
+        // return:
+        //     the number of times a node was found pooled already, each one a node saved
+        size_t hits() const { return hits_; }
+
+    private:
+        // return:
+        //     false if shape is a call or has a child that is not pooled
+        bool Shareable(const Shape &shape) const;
+
+        // a hash of the node itself, its children count by address
+        static size_t ShallowHash(const Shape &shape);
+
+        // return:
+        //     true if a and b are equal as nodes with the same children
+        static bool ShallowEqual(const Shape &a, const Shape &b);
+
+        std::unordered_multimap<size_t, std::shared_ptr<Expression>> nodes_; // by ShallowHash
+        std::unordered_set<const Expression *> pooled_;                     // the nodes of nodes_
+        mutable size_t hits_ = 0;
+    };
+}
+
+#endif // !PASCAL2C_SRC_AST_EXPR_POOL_H_
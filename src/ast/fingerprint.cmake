@@ -0,0 +1,21 @@
+# write a header defining PASCAL2C_AST_FINGERPRINT, the SHA-256 of the sources
+# that decide what a parsed program and its cache entry look like, the header is
+# only touched when the fingerprint changes
+# usage: cmake -DSOURCE_DIR=<repo> -DOUTPUT=<ast_fingerprint.h> -P fingerprint.cmake
+file(GLOB sources RELATIVE ${SOURCE_DIR}
+        ${SOURCE_DIR}/src/ast/*.h ${SOURCE_DIR}/src/ast/*.cc
+        ${SOURCE_DIR}/src/parser/*.h ${SOURCE_DIR}/src/parser/*.cc
+        ${SOURCE_DIR}/src/lexer/*.lex ${SOURCE_DIR}/src/lexer/*.c ${SOURCE_DIR}/src/lexer/*.py)
+set(hashes "")
+foreach(source ${sources})
+        file(SHA256 ${SOURCE_DIR}/${source} hash)
+        string(APPEND hashes "${source} ${hash}\n")
+endforeach()
+string(SHA256 fingerprint "${hashes}")
+string(RANDOM LENGTH 8 suffix)
+set(temp ${OUTPUT}.${suffix}.tmp)
+file(WRITE ${temp}
+        "// generated by src/ast/fingerprint.cmake\n"
+        "#define PASCAL2C_AST_FINGERPRINT \"${fingerprint}\"\n")
+configure_file(${temp} ${OUTPUT} COPYONLY)
+file(REMOVE ${temp})
@@ -0,0 +1,26 @@
+#include "ast/interner.h"
+
+namespace pascal2c::ast
+{
+    Interner::Interner()
+    {
+        Intern(""); // the empty name is always id 0
+    }
+
+    SymbolId Interner::Intern(std::string_view name)
+    {
+        auto it = ids_.find(name);
+        if (it != ids_.end())
+            return it->second;
+        SymbolId id = static_cast<SymbolId>(names_.size());
+        names_.emplace_back(name);
+        ids_.emplace(names_.back(), id);
+        return id;
+    }
+
+    SymbolId Interner::Find(std::string_view name) const
+    {
+        auto it = ids_.find(name);
+        return it != ids_.end() ? it->second : 0;
+    }
+}
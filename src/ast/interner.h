@@ -0,0 +1,51 @@
+#ifndef PASCAL2C_SRC_AST_INTERNER_H_
+#define PASCAL2C_SRC_AST_INTERNER_H_
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace pascal2c::ast
+{
+    // interned identifier, equal names of one source always get the same id
+    // 0 is the empty name, which no identifier has
+    using SymbolId = uint32_t;
+
+    // the identifiers of one source and their ids
+    // the scanner side of the parser interns every identifier once, the nodes keep
+    // the id next to the name and the analyser compares ids instead of names
+    // one thread writes it at a time, see TokenStream::symbols and TokenQueue::symbols
+    // usage:
+    //     Interner symbols;
+    //     SymbolId id = symbols.Intern("count");
+    //     std::cout << symbols.Name(id) << std::endl;
+    class Interner
+    {
+    public:
+        Interner();
+
+        // return:
+        //     the id of name, a new one the first time name is seen
+        SymbolId Intern(std::string_view name);
+
+        // return:
+        //     the id of name, 0 if it was never interned
+        SymbolId Find(std::string_view name) const;
+
+        // return:
+        //     the name behind id, it stays put as long as the interner
+        const std::string &Name(SymbolId id) const { return names_[id]; }
+
+        // return:
+        //     the number of names, the empty one included
+        size_t size() const { return names_.size(); }
+
+    private:
+        std::deque<std::string> names_; // a deque keeps the keys of ids_ in place while it grows
+        std::unordered_map<std::string_view, SymbolId> ids_;
+    };
+}
+
+#endif // !PASCAL2C_SRC_AST_INTERNER_H_
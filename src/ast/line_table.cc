@@ -0,0 +1,33 @@
+#include "ast/line_table.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace pascal2c::ast
+{
+    LineTable::LineTable(std::string_view source)
+    {
+        // a rough guess of forty bytes per line saves most of the regrowth
+        starts_.reserve(source.size() / 40 + 1);
+        starts_.push_back(0);
+        const char *begin = source.data();
+        const char *end = begin + source.size();
+        for (const char *p = begin; p < end; p++)
+        {
+            p = static_cast<const char *>(std::memchr(p, '\n', end - p));
+            if (p == nullptr)
+                break;
+            starts_.push_back(static_cast<uint32_t>(p - begin + 1));
+        }
+    }
+
+    int LineTable::Line(uint32_t offset) const
+    {
+        return static_cast<int>(std::upper_bound(starts_.begin(), starts_.end(), offset) - starts_.begin());
+    }
+
+    int LineTable::Column(uint32_t offset) const
+    {
+        return static_cast<int>(offset - starts_[Line(offset) - 1]) + 1;
+    }
+}
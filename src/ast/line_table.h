@@ -0,0 +1,55 @@
+#ifndef PASCAL2C_SRC_AST_LINE_TABLE_H_
+#define PASCAL2C_SRC_AST_LINE_TABLE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace pascal2c::ast
+{
+    // where every line of one source starts
+    // a node only keeps the byte offset of its first token, its line and column
+    // are looked up here when they are printed, eg. in a diagnostic, the parser
+    // hands out the table of its source, see Parser::line_table
+    // usage:
+    //     auto lines = std::make_shared<const LineTable>(source);
+    //     uint32_t offset = lines->Offset(3, 7);
+    //     std::cout << lines->Line(offset) << ":" << lines->Column(offset) << std::endl;
+    class LineTable
+    {
+    public:
+        // param:
+        //     source is the whole program text, only its newlines are looked at
+        explicit LineTable(std::string_view source);
+
+        // return:
+        //     the number of lines, a source ending in a newline has an empty last line
+        size_t size() const { return starts_.size(); }
+
+        // param:
+        //     line and column are 1-based, as the scanner counts them
+        // return:
+        //     the byte offset of that place in the source
+        uint32_t Offset(int line, int column) const
+        {
+            size_t index = line < 1 ? 0 : static_cast<size_t>(line) - 1;
+            if (index >= starts_.size())
+                index = starts_.size() - 1;
+            return starts_[index] + static_cast<uint32_t>(column - 1);
+        }
+
+        // return:
+        //     the 1-based line of offset
+        int Line(uint32_t offset) const;
+
+        // return:
+        //     the 1-based column of offset
+        int Column(uint32_t offset) const;
+
+    private:
+        std::vector<uint32_t> starts_; // offset of the first byte of every line, starts_[0] is 0
+    };
+}
+
+#endif // !PASCAL2C_SRC_AST_LINE_TABLE_H_
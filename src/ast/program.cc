@@ -11,7 +11,7 @@ extern "C"
 // Output the line and column number of the current token and the current level of indentation.
 #define INIT_TOSTRING(str_s, level) \
     std::stringstream str_s;        \
-    LineColumnOutput(str_s);        \
+    LineColumnOutput(str_s, lines);        \
     IndentOutput(str_s, level);
 
 namespace pascal2c::ast
@@ -36,7 +36,7 @@ namespace pascal2c::ast
         }
     }
     // eg. IdList: a, b, c
-    const string IdList::ToString(const int level) const
+    const string IdList::ToString(const int level, const LineTable &lines) const
     {
         INIT_TOSTRING(str_s, level);
 
@@ -55,7 +55,7 @@ namespace pascal2c::ast
 
     // eg. Type: array [1..10, 1..10] of integer
     // eg. Type: integer
-    const string Type::ToString(const int level) const
+    const string Type::ToString(const int level, const LineTable &lines) const
     {
         INIT_TOSTRING(str_s, level);
 
@@ -85,7 +85,7 @@ namespace pascal2c::ast
     //         IdList: a, b, c
     // eg. Parameter: integer
     //        IdList: a, b, c
-    const string Parameter::ToString(const int level) const
+    const string Parameter::ToString(const int level, const LineTable &lines) const
     {
         INIT_TOSTRING(str_s, level);
 
@@ -97,20 +97,20 @@ namespace pascal2c::ast
         }
         str_s << TypeToString(type_) << std::endl;
 
-        str_s << id_list_->ToString(level + 1);
+        str_s << id_list_->ToString(level + 1, lines);
         return str_s.str();
     }
 
     // eg. ConstDeclaration: a
     //         1
-    const string ConstDeclaration::ToString(const int level) const
+    const string ConstDeclaration::ToString(const int level, const LineTable &lines) const
     {
         INIT_TOSTRING(str_s, level);
 
         str_s << "ConstDeclaration: " << id_ << std::endl;
         if (const_value_)
         {
-            str_s << const_value_->ToString(level + 1);
+            str_s << const_value_->ToString(level + 1, lines);
         }
         else
         {
@@ -123,13 +123,13 @@ namespace pascal2c::ast
     // eg. VarDeclaration:
     //         Type: integer
     //         IdList: a, b, c
-    const string VarDeclaration::ToString(const int level) const
+    const string VarDeclaration::ToString(const int level, const LineTable &lines) const
     {
         INIT_TOSTRING(str_s, level);
 
         str_s << "VarDeclaration: " << std::endl;
-        str_s << type_->ToString(level + 1) << std::endl;
-        str_s << id_list_->ToString(level + 1);
+        str_s << type_->ToString(level + 1, lines) << std::endl;
+        str_s << id_list_->ToString(level + 1, lines);
         return str_s.str();
     }
 
@@ -141,7 +141,7 @@ namespace pascal2c::ast
     //             IdList: a
     //         Parameter: real
     //             IdList: b, c
-    const string SubprogramHead::ToString(const int level) const
+    const string SubprogramHead::ToString(const int level, const LineTable &lines) const
     {
         INIT_TOSTRING(str_s, level);
 
@@ -156,11 +156,11 @@ namespace pascal2c::ast
         }
         if (parameters_.size() > 0)
         {
-            str_s << parameters_[0]->ToString(level + 1);
+            str_s << parameters_[0]->ToString(level + 1, lines);
             for (int i = 1; i < parameters_.size(); i++)
             {
                 str_s << std::endl
-                      << parameters_[i]->ToString(level + 1);
+                      << parameters_[i]->ToString(level + 1, lines);
             }
         }
         return str_s.str();
@@ -173,22 +173,22 @@ namespace pascal2c::ast
     //             Type: integer
     //             IdList: a, b, c
     //         CompoundStatement :0
-    const string SubprogramBody::ToString(const int level) const
+    const string SubprogramBody::ToString(const int level, const LineTable &lines) const
     {
         INIT_TOSTRING(str_s, level);
 
         str_s << "SubprogramBody: " << std::endl;
         for (int i = 0; i < const_declarations_.size(); i++)
         {
-            str_s << const_declarations_[i]->ToString(level + 1) << std::endl;
+            str_s << const_declarations_[i]->ToString(level + 1, lines) << std::endl;
         }
 
         for (int i = 0; i < var_declarations_.size(); i++)
         {
-            str_s << var_declarations_[i]->ToString(level + 1) << std::endl;
+            str_s << var_declarations_[i]->ToString(level + 1, lines) << std::endl;
         }
 
-        str_s << statements_->ToString(level + 1);
+        str_s << statements_->ToString(level + 1, lines);
 
         return str_s.str();
     }
@@ -197,26 +197,26 @@ namespace pascal2c::ast
     //         SubprogramHead: procedure a
     //         SubprogramBody:
     //             CompoundStatement: 0
-    const string Subprogram::ToString(const int level) const
+    const string Subprogram::ToString(const int level, const LineTable &lines) const
     {
         INIT_TOSTRING(str_s, level);
 
         str_s << "Subprogram: " << std::endl;
-        str_s << subprogram_head_->ToString(level + 1) << std::endl;
-        str_s << subprogram_body_->ToString(level + 1);
+        str_s << subprogram_head_->ToString(level + 1, lines) << std::endl;
+        str_s << subprogram_body_->ToString(level + 1, lines);
         return str_s.str();
     }
 
     // eg. ProgramHead: a
     //         IdList: a, b, c
-    const string ProgramHead::ToString(const int level) const
+    const string ProgramHead::ToString(const int level, const LineTable &lines) const
     {
         INIT_TOSTRING(str_s, level);
 
         str_s << "ProgramHead: " << id_ << std::endl;
         if (id_list_ != nullptr)
         {
-            str_s << id_list_->ToString(level + 1);
+            str_s << id_list_->ToString(level + 1, lines);
         }
         return str_s.str();
     }
@@ -232,27 +232,27 @@ namespace pascal2c::ast
     //             SubprogramBody:
     //                 CompoundStatement: 0
     //         CompoundStatement :0
-    const string ProgramBody::ToString(const int level) const
+    const string ProgramBody::ToString(const int level, const LineTable &lines) const
     {
         INIT_TOSTRING(str_s, level);
 
         str_s << "ProgramBody: " << std::endl;
         for (int i = 0; i < const_declarations_.size(); i++)
         {
-            str_s << const_declarations_[i]->ToString(level + 1) << std::endl;
+            str_s << const_declarations_[i]->ToString(level + 1, lines) << std::endl;
         }
 
         for (int i = 0; i < var_declarations_.size(); i++)
         {
-            str_s << var_declarations_[i]->ToString(level + 1) << std::endl;
+            str_s << var_declarations_[i]->ToString(level + 1, lines) << std::endl;
         }
 
         for (int i = 0; i < subprogram_declarations_.size(); i++)
         {
-            str_s << subprogram_declarations_[i]->ToString(level + 1) << std::endl;
+            str_s << subprogram_declarations_[i]->ToString(level + 1, lines) << std::endl;
         }
 
-        str_s << statements_->ToString(level + 1);
+        str_s << statements_->ToString(level + 1, lines);
 
         return str_s.str();
     }
@@ -261,13 +261,13 @@ namespace pascal2c::ast
     //         ProgramHead: a
     //         ProgramBody:
     //             CompoundStatement: 0
-    const string Program::ToString(const int level) const
+    const string Program::ToString(const int level, const LineTable &lines) const
     {
         INIT_TOSTRING(str_s, level);
 
         str_s << "Program: " << std::endl;
-        str_s << program_head_->ToString(level + 1) << std::endl;
-        str_s << program_body_->ToString(level + 1);
+        str_s << program_head_->ToString(level + 1, lines) << std::endl;
+        str_s << program_body_->ToString(level + 1, lines);
         return str_s.str();
     }
 }
\ No newline at end of file
@@ -23,7 +23,7 @@ namespace pascal2c::ast
     class IdList : public Ast
     {
     public:
-        IdList(const int line, const int column) : Ast(line, column) {}
+        explicit IdList(const uint32_t offset) : Ast(offset) {}
 
         // param:
         //     id is the identifier
@@ -31,21 +31,33 @@ namespace pascal2c::ast
         //     the id at the index
         inline const string &operator[](const int index) const { return id_list_[index]; }
 
+        // return:
+        //     the interned id at the index, 0 for a list that was not parsed
+        inline SymbolId symbol(const int index) const { return symbols_[index]; }
+
         // return:
         //     the number of identifiers
         inline const int Size() const { return id_list_.size(); }
 
-        inline void AddId(const string &id) { id_list_.push_back(id); }
+        // param:
+        //     symbol is the interned id
+        inline void AddId(const string &id, const SymbolId symbol = 0)
+        {
+            id_list_.push_back(id);
+            symbols_.push_back(symbol);
+        }
 
         // for test use
         // param:
         //     level is the level of indentation that should be applied to the returned string
+        //     lines is the line table of the parsed source, the positions are looked up there
         // return:
         //     a string represents the statement
-        const string ToString(const int level) const;
+        const string ToString(const int level, const LineTable &lines) const;
 
     private:
         vector<string> id_list_; // a list of identifiers, eg. a, b, c
+        vector<SymbolId> symbols_; // the interned identifiers
     };
 
     // Type -> (TOK_INTEGER_TYPE | TOK_REAL_TYPE | TOK_BOOLEAN_TYPE | TOK_CHAR_TYPE) | array [Period] of (TOK_INTEGER_TYPE | TOK_REAL_TYPE | TOK_BOOLEAN_TYPE | TOK_CHAR_TYPE)
@@ -67,13 +79,13 @@ namespace pascal2c::ast
 
         // param:
         //     is_array is true if the type is array type
-        Type(const int line, const int column, const bool is_array) : Ast(line, column), is_array_(is_array), basic_type_(-1) {}
+        Type(const uint32_t offset, const bool is_array) : Ast(offset), is_array_(is_array), basic_type_(-1) {}
 
         // param:
         //     is_array is true if the type is array type
         //     basic_type is the basic type of the array, eg. integer, real, boolean, char
-        Type(const int line, const int column, const bool is_array, const int basic_type)
-            : Ast(line, column), is_array_(is_array), basic_type_(basic_type) {}
+        Type(const uint32_t offset, const bool is_array, const int basic_type)
+            : Ast(offset), is_array_(is_array), basic_type_(basic_type) {}
 
         inline const bool &is_array() const { return is_array_; }
 
@@ -88,9 +100,10 @@ namespace pascal2c::ast
         // for test use
         // param:
         //     level is the level of indentation that should be applied to the returned string
+        //     lines is the line table of the parsed source, the positions are looked up there
         // return:
         //     a string represents the statement
-        const string ToString(const int level) const;
+        const string ToString(const int level, const LineTable &lines) const;
 
     private:
         bool is_array_;          // true if the type is array type
@@ -111,8 +124,8 @@ namespace pascal2c::ast
         //     is_var is true if the parameter is var parameter
         //     id_list is a list of identifiers
         //     type is the type of the identifiers
-        Parameter(const int line, const int column, const bool is_var, shared_ptr<IdList> id_list, const int type)
-            : Ast(line, column), is_var_(is_var), id_list_(std::move(id_list)), type_(type) {}
+        Parameter(const uint32_t offset, const bool is_var, shared_ptr<IdList> id_list, const int type)
+            : Ast(offset), is_var_(is_var), id_list_(std::move(id_list)), type_(type) {}
 
         inline const bool &is_var() const { return is_var_; }
 
@@ -123,9 +136,10 @@ namespace pascal2c::ast
         // for test use
         // param:
         //     level is the level of indentation that should be applied to the returned string
+        //     lines is the line table of the parsed source, the positions are looked up there
         // return:
         //     a string represents the statement
-        const string ToString(const int level) const;
+        const string ToString(const int level, const LineTable &lines) const;
 
     private:
         bool is_var_;                // true if the parameter is var parameter
@@ -142,22 +156,27 @@ namespace pascal2c::ast
         // param:
         //     id is the identifier
         //     const_value is the value of the identifier
-        ConstDeclaration(const int line, const int column, const string &id, shared_ptr<Expression> const_value)
-            : Ast(line, column), id_(id), const_value_(std::move(const_value)) {}
+        //     symbol is the interned id, 0 for a node that was not parsed
+        ConstDeclaration(const uint32_t offset, const string &id, shared_ptr<Expression> const_value, const SymbolId symbol = 0)
+            : Ast(offset), id_(id), symbol_(symbol), const_value_(std::move(const_value)) {}
 
         inline const string &id() const { return id_; }
 
+        inline SymbolId symbol() const { return symbol_; }
+
         inline const shared_ptr<Expression> &const_value() const { return const_value_; }
 
         // for test use
         // param:
         //     level is the level of indentation that should be applied to the returned string
+        //     lines is the line table of the parsed source, the positions are looked up there
         // return:
         //     a string represents the statement
-        const string ToString(const int level) const;
+        const string ToString(const int level, const LineTable &lines) const;
 
     private:
         string id_;                          // the identifier, eg. a
+        SymbolId symbol_;                    // id_ interned
         shared_ptr<Expression> const_value_; // IntegerValue | RealValue | UnaryExpr | CharValue from expr.h, eg. 1, 2.0, -1, 'a'
     };
 
@@ -171,8 +190,8 @@ namespace pascal2c::ast
         // param:
         //     id_list is a list of identifiers
         //     type is the type of the identifiers
-        VarDeclaration(const int line, const int column, shared_ptr<IdList> id_list, shared_ptr<Type> type)
-            : Ast(line, column), id_list_(std::move(id_list)), type_(std::move(type)) {}
+        VarDeclaration(const uint32_t offset, shared_ptr<IdList> id_list, shared_ptr<Type> type)
+            : Ast(offset), id_list_(std::move(id_list)), type_(std::move(type)) {}
 
         inline const shared_ptr<IdList> &id_list() const { return id_list_; }
 
@@ -181,9 +200,10 @@ namespace pascal2c::ast
         // for test use
         // param:
         //     level is the level of indentation that should be applied to the returned string
+        //     lines is the line table of the parsed source, the positions are looked up there
         // return:
         //     a string represents the statement
-        const string ToString(const int level) const;
+        const string ToString(const int level, const LineTable &lines) const;
 
     private:
         shared_ptr<IdList> id_list_; // a list of identifiers, eg. a, b, c
@@ -201,11 +221,14 @@ namespace pascal2c::ast
         // param:
         //     id is the name of the subprogram
         //     return_type is the return type of the subprogram, -1 means procedure
-        SubprogramHead(const int line, const int column, const string &id, const int return_type = -1)
-            : Ast(line, column), id_(id), return_type_(return_type) {}
+        //     symbol is the interned id, 0 for a node that was not parsed
+        SubprogramHead(const uint32_t offset, const string &id, const int return_type = -1, const SymbolId symbol = 0)
+            : Ast(offset), id_(id), symbol_(symbol), return_type_(return_type) {}
 
         inline const string &id() const { return id_; }
 
+        inline SymbolId symbol() const { return symbol_; }
+
         // return:
         //     the return type of the subprogram, -1 means procedure
         inline const int &return_type() const { return return_type_; }
@@ -223,12 +246,14 @@ namespace pascal2c::ast
         // for test use
         // param:
         //     level is the level of indentation that should be applied to the returned string
+        //     lines is the line table of the parsed source, the positions are looked up there
         // return:
         //     a string represents the statement
-        const string ToString(const int level) const;
+        const string ToString(const int level, const LineTable &lines) const;
 
     private:
         string id_;                                // name of the subprogram, eg. f, p
+        SymbolId symbol_;                          // id_ interned
         int return_type_;                          // -1 means procedure,TOK_INTEGER_TYPE | TOK_REAL_TYPE | TOK_BOOLEAN_TYPE | TOK_CHAR_TYPE ,eg. integer, real
         vector<shared_ptr<Parameter>> parameters_; // can be empty, eg. a, b : integer
     };
@@ -243,7 +268,7 @@ namespace pascal2c::ast
     class SubprogramBody : public Ast
     {
     public:
-        SubprogramBody(const int line, const int column) : Ast(line, column) {}
+        explicit SubprogramBody(const uint32_t offset) : Ast(offset) {}
 
         inline const vector<shared_ptr<ConstDeclaration>> &const_declarations() const
         {
@@ -269,9 +294,10 @@ namespace pascal2c::ast
         // for test use
         // param:
         //     level is the level of indentation that should be applied to the returned string
+        //     lines is the line table of the parsed source, the positions are looked up there
         // return:
         //     a string represents the statement
-        const string ToString(const int level) const;
+        const string ToString(const int level, const LineTable &lines) const;
 
     private:
         vector<shared_ptr<ConstDeclaration>> const_declarations_; // can be empty, eg. const a = 1; b = 2;
@@ -289,8 +315,8 @@ namespace pascal2c::ast
         // param:
         //     subprogram_head is the head of the subprogram
         //     subprogram_body is the body of the subprogram
-        Subprogram(const int line, const int column, shared_ptr<SubprogramHead> subprogram_head, shared_ptr<SubprogramBody> subprogram_body)
-            : Ast(line, column), subprogram_head_(std::move(subprogram_head)), subprogram_body_(std::move(subprogram_body)) {}
+        Subprogram(const uint32_t offset, shared_ptr<SubprogramHead> subprogram_head, shared_ptr<SubprogramBody> subprogram_body)
+            : Ast(offset), subprogram_head_(std::move(subprogram_head)), subprogram_body_(std::move(subprogram_body)) {}
 
         inline const shared_ptr<SubprogramHead> &subprogram_head() const { return subprogram_head_; }
 
@@ -299,9 +325,10 @@ namespace pascal2c::ast
         // for test use
         // param:
         //     level is the level of indentation that should be applied to the returned string
+        //     lines is the line table of the parsed source, the positions are looked up there
         // return:
         //     a string represents the statement
-        const string ToString(const int level) const;
+        const string ToString(const int level, const LineTable &lines) const;
 
     private:
         shared_ptr<SubprogramHead> subprogram_head_; // eg. function f(a, b : integer) : integer;
@@ -318,12 +345,12 @@ namespace pascal2c::ast
         // param:
         //     id is the program name
         //     id_list is the parameters of the program
-        ProgramHead(const int line, const int column, const string &id, shared_ptr<IdList> id_list)
-            : Ast(line, column), id_(id), id_list_(std::move(id_list)) {}
+        ProgramHead(const uint32_t offset, const string &id, shared_ptr<IdList> id_list)
+            : Ast(offset), id_(id), id_list_(std::move(id_list)) {}
 
         // param:
         //     id is the program name
-        ProgramHead(const int line, const int column, const string &id) : Ast(line, column), id_(id), id_list_(nullptr) {}
+        ProgramHead(const uint32_t offset, const string &id) : Ast(offset), id_(id), id_list_(nullptr) {}
 
         inline const string &id() const { return id_; }
 
@@ -337,9 +364,10 @@ namespace pascal2c::ast
         // for test use
         // param:
         //     level is the level of indentation that should be applied to the returned string
+        //     lines is the line table of the parsed source, the positions are looked up there
         // return:
         //     a string represents the statement
-        const string ToString(const int level) const;
+        const string ToString(const int level, const LineTable &lines) const;
 
     private:
         string id_;                  // program name, eg. f
@@ -358,8 +386,8 @@ namespace pascal2c::ast
     class ProgramBody : public Ast
     {
     public:
-        ProgramBody(const int line, const int column)
-            : Ast(line, column) {}
+        explicit ProgramBody(const uint32_t offset)
+            : Ast(offset) {}
 
         inline const vector<shared_ptr<ConstDeclaration>> &const_declarations() const { return const_declarations_; }
 
@@ -389,9 +417,10 @@ namespace pascal2c::ast
         // for test use
         // param:
         //     level is the level of indentation that should be applied to the returned string
+        //     lines is the line table of the parsed source, the positions are looked up there
         // return:
         //     a string represents the statement
-        const string ToString(const int level) const;
+        const string ToString(const int level, const LineTable &lines) const;
 
     private:
         vector<shared_ptr<ConstDeclaration>> const_declarations_; // can be empty, eg. const a = 1; b = 2;
@@ -409,8 +438,8 @@ namespace pascal2c::ast
         // param:
         //     program_head is the shared pointer of ProgramHead
         //     program_body is the shared pointer of ProgramBody
-        Program(const int line, const int column, shared_ptr<ProgramHead> program_head, shared_ptr<ProgramBody> program_body)
-            : Ast(line, column), program_head_(std::move(program_head)), program_body_(std::move(program_body)) {}
+        Program(const uint32_t offset, shared_ptr<ProgramHead> program_head, shared_ptr<ProgramBody> program_body)
+            : Ast(offset), program_head_(std::move(program_head)), program_body_(std::move(program_body)) {}
 
         inline const shared_ptr<ProgramHead> &program_head() const { return program_head_; }
 
@@ -419,9 +448,10 @@ namespace pascal2c::ast
         // for test use
         // param:
         //     level is the level of indentation that should be applied to the returned string
+        //     lines is the line table of the parsed source, the positions are looked up there
         // return:
         //     a string represents the statement
-        const string ToString(const int level) const;
+        const string ToString(const int level, const LineTable &lines) const;
 
     private:
         shared_ptr<ProgramHead> program_head_; // eg. program f(a, b)
@@ -0,0 +1,857 @@
+#include "ast/serialize.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ast/arena.h"
+#include "ast_fingerprint.h"
+
+namespace pascal2c::ast
+{
+    static constexpr char kMagic[4] = {'P', '2', 'C', 'A'};
+    static constexpr size_t kHeaderSize = 4 + 4 + 8 + 16 + 8 + 8;
+
+    // the kind bytes of an expression besides its ExprType
+    static constexpr uint8_t kExprEnd = 0xFD;  // the expression is complete
+    static constexpr uint8_t kExprNull = 0xFE; // no expression
+    static constexpr uint8_t kExprRef = 0xFF;  // the node with the index that follows, written before
+
+    // the kind byte of a missing statement, the others are their StatementType
+    static constexpr uint8_t kStatementNull = 0;
+
+    static uint64_t Rotl(uint64_t x, int r)
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    static uint64_t Fmix(uint64_t k)
+    {
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33;
+        k *= 0xc4ceb9fe1a85ec53ULL;
+        k ^= k >> 33;
+        return k;
+    }
+
+    // MurmurHash3_x64_128 with seed 0, the blocks are read in host order like the
+    // reference does, the fingerprint tells the builds of other byte orders apart
+    static std::pair<uint64_t, uint64_t> Murmur3(std::string_view bytes)
+    {
+        const uint64_t c1 = 0x87c37b91114253d5ULL, c2 = 0x4cf5ad432745937fULL;
+        uint64_t h1 = 0, h2 = 0;
+        size_t blocks = bytes.size() / 16;
+        for (size_t i = 0; i < blocks; i++)
+        {
+            uint64_t k1, k2;
+            std::memcpy(&k1, bytes.data() + 16 * i, 8);
+            std::memcpy(&k2, bytes.data() + 16 * i + 8, 8);
+            h1 ^= Rotl(k1 * c1, 31) * c2;
+            h1 = (Rotl(h1, 27) + h2) * 5 + 0x52dce729;
+            h2 ^= Rotl(k2 * c2, 33) * c1;
+            h2 = (Rotl(h2, 31) + h1) * 5 + 0x38495ab5;
+        }
+
+        const unsigned char *tail = reinterpret_cast<const unsigned char *>(bytes.data()) + 16 * blocks;
+        size_t rest = bytes.size() % 16;
+        uint64_t k1 = 0, k2 = 0;
+        for (size_t i = 8; i < rest; i++)
+            k2 ^= static_cast<uint64_t>(tail[i]) << (8 * (i - 8));
+        if (rest > 8)
+            h2 ^= Rotl(k2 * c2, 33) * c1;
+        for (size_t i = 0; i < rest && i < 8; i++)
+            k1 ^= static_cast<uint64_t>(tail[i]) << (8 * i);
+        if (rest > 0)
+            h1 ^= Rotl(k1 * c1, 31) * c2;
+
+        h1 ^= bytes.size();
+        h2 ^= bytes.size();
+        h1 += h2;
+        h2 += h1;
+        h1 = Fmix(h1);
+        h2 = Fmix(h2);
+        h1 += h2;
+        h2 += h1;
+        return {h1, h2};
+    }
+
+    uint64_t BuildFingerprint()
+    {
+        // the byte order and the word size count too, the digests read words in host order
+        static const uint64_t fingerprint = [] {
+            const uint32_t one = 1;
+            std::string build = std::to_string(kCacheVersion) + " " PASCAL2C_AST_FINGERPRINT " " +
+                                std::to_string(sizeof(void *)) + " " +
+                                std::to_string(*reinterpret_cast<const unsigned char *>(&one));
+            return Murmur3(build).first;
+        }();
+        return fingerprint;
+    }
+
+    CacheKey CacheKey::Of(std::string_view source)
+    {
+        CacheKey key;
+        auto [lo, hi] = Murmur3(source);
+        key.digest[0] = lo;
+        key.digest[1] = hi;
+        key.size = source.size();
+        key.build = BuildFingerprint();
+        return key;
+    }
+
+    static void PutFixed(std::string &out, uint64_t value, int bytes)
+    {
+        for (int i = 0; i < bytes; i++)
+            out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+
+    // LEB128, seven bits a byte from the lowest, the high bit set on all but the last
+    static void PutVarint(std::string &out, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    static uint64_t GetFixed(std::string_view bytes, size_t pos, int size)
+    {
+        uint64_t value = 0;
+        for (int i = 0; i < size; i++)
+            value |= static_cast<uint64_t>(static_cast<unsigned char>(bytes[pos + i])) << (8 * i);
+        return value;
+    }
+
+    // writes a program in the layout of serialize.h, the body is written first
+    // and the string table it collected is put in front of it at the end
+    class CacheWriter
+    {
+    public:
+        std::string Finish(const Program &program, const CacheKey &key)
+        {
+            WriteProgram(program);
+
+            std::string strings;
+            strings.reserve(strings_size_ + 8);
+            ast::PutVarint(strings, strings_.size());
+            for (const std::string *str : strings_)
+            {
+                ast::PutVarint(strings, str->size());
+                strings.append(*str);
+            }
+
+            std::string out;
+            out.reserve(kHeaderSize + strings.size() + body_.size());
+            out.append(kMagic, sizeof(kMagic));
+            PutFixed(out, kCacheVersion, 4);
+            PutFixed(out, key.build, 8);
+            PutFixed(out, key.digest[0], 8);
+            PutFixed(out, key.digest[1], 8);
+            PutFixed(out, key.size, 8);
+            PutFixed(out, 0, 8); // the checksum, once the rest is there
+            out.append(strings);
+            out.append(body_);
+            uint64_t checksum = Murmur3(std::string_view(out).substr(kHeaderSize)).first;
+            for (int i = 0; i < 8; i++)
+                out[kHeaderSize - 8 + i] = static_cast<char>((checksum >> (8 * i)) & 0xff);
+            return out;
+        }
+
+    private:
+        void PutByte(uint8_t byte) { body_.push_back(static_cast<char>(byte)); }
+
+        void PutVarint(uint64_t value) { ast::PutVarint(body_, value); }
+
+        void PutSigned(int64_t value)
+        {
+            PutVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+        }
+
+        void PutString(const std::string &str)
+        {
+            auto [it, added] = string_index_.emplace(str, strings_.size());
+            if (added)
+            {
+                strings_.push_back(&it->first);
+                strings_size_ += str.size() + 1;
+            }
+            PutVarint(it->second);
+        }
+
+        void PutNode(uint8_t kind, const Ast &node)
+        {
+            PutByte(kind);
+            PutVarint(node.offset());
+        }
+
+        // param:
+        //     children gets the children of expr appended, left to right
+        static void Children(const Expression &expr, vector<const Expression *> &children)
+        {
+            switch (expr.GetType())
+            {
+                case VARIABLE:
+                    for (const auto &index : As<Variable>(expr).expr_list())
+                        children.push_back(index.get());
+                    break;
+                case CALL:
+                    for (const auto &param : As<CallValue>(expr).params())
+                        children.push_back(param.get());
+                    break;
+                case BINARY:
+                    children.push_back(As<BinaryExpr>(expr).lhs().get());
+                    children.push_back(As<BinaryExpr>(expr).rhs().get());
+                    break;
+                case UNARY:
+                    children.push_back(As<UnaryExpr>(expr).factor().get());
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        // the fields of expr after its kind and offset, its children are written before it
+        void WriteExprFields(const Expression &expr)
+        {
+            switch (expr.GetType())
+            {
+                case INT:
+                    PutSigned(As<IntegerValue>(expr).value());
+                    break;
+                case REAL:
+                {
+                    double value = As<RealValue>(expr).value();
+                    uint64_t bits;
+                    std::memcpy(&bits, &value, sizeof(bits));
+                    PutFixed(body_, bits, 8);
+                    break;
+                }
+                case CHAR:
+                    PutSigned(As<CharValue>(expr).ch());
+                    break;
+                case BOOLEAN:
+                    PutByte(As<BooleanValue>(expr).value());
+                    break;
+                case STRING:
+                    PutString(As<StringValue>(expr).value());
+                    break;
+                case CALL_OR_VAR:
+                    PutString(As<CallOrVar>(expr).id());
+                    break;
+                case VARIABLE:
+                    PutString(As<Variable>(expr).id());
+                    PutVarint(As<Variable>(expr).expr_list().size());
+                    break;
+                case CALL:
+                    PutString(As<CallValue>(expr).id());
+                    PutVarint(As<CallValue>(expr).params().size());
+                    break;
+                case BINARY:
+                    PutSigned(As<BinaryExpr>(expr).op());
+                    break;
+                case UNARY:
+                    PutSigned(As<UnaryExpr>(expr).op());
+                    break;
+            }
+        }
+
+        // postorder with a work list, a node is written once its children are,
+        // one met again is written as a reference
+        void WriteExpr(const Expression *expr)
+        {
+            if (expr == nullptr)
+            {
+                PutByte(kExprNull);
+                PutByte(kExprEnd);
+                return;
+            }
+            vector<std::pair<const Expression *, bool>> work = {{expr, false}}; // node, children written
+            vector<const Expression *> children;
+            while (!work.empty())
+            {
+                auto [node, ready] = work.back();
+                work.pop_back();
+                if (ready)
+                {
+                    PutNode(node->GetType(), *node);
+                    WriteExprFields(*node);
+                    expr_index_.emplace(node, expr_index_.size());
+                    continue;
+                }
+                auto written = expr_index_.find(node);
+                if (written != expr_index_.end())
+                {
+                    PutByte(kExprRef);
+                    PutVarint(written->second);
+                    continue;
+                }
+                work.push_back({node, true});
+                children.clear();
+                Children(*node, children);
+                for (auto child = children.rbegin(); child != children.rend(); ++child)
+                    work.push_back({*child, false});
+            }
+            PutByte(kExprEnd);
+        }
+
+        void WriteExprList(const vector<std::shared_ptr<Expression>> &exprs)
+        {
+            PutVarint(exprs.size());
+            for (const auto &expr : exprs)
+                WriteExpr(expr.get());
+        }
+
+        void WriteStatement(const Statement *statement)
+        {
+            if (statement == nullptr)
+            {
+                PutByte(kStatementNull);
+                return;
+            }
+            PutNode(statement->GetType(), *statement);
+            switch (statement->GetType())
+            {
+                case ASSIGN_STATEMENT:
+                    WriteExpr(As<AssignStatement>(*statement).var().get());
+                    WriteExpr(As<AssignStatement>(*statement).expr().get());
+                    break;
+                case CALL_STATEMENT:
+                    PutString(As<CallStatement>(*statement).name());
+                    WriteExprList(As<CallStatement>(*statement).expr_list());
+                    break;
+                case COMPOUND_STATEMENT:
+                {
+                    const auto &statements = As<CompoundStatement>(*statement).statements();
+                    PutVarint(statements.size());
+                    for (const auto &child : statements)
+                        WriteStatement(child.get());
+                    break;
+                }
+                case IF_STATEMENT:
+                    WriteExpr(As<IfStatement>(*statement).condition().get());
+                    WriteStatement(As<IfStatement>(*statement).then().get());
+                    WriteStatement(As<IfStatement>(*statement).else_part().get());
+                    break;
+                case FOR_STATEMENT:
+                    PutString(As<ForStatement>(*statement).id());
+                    WriteExpr(As<ForStatement>(*statement).from().get());
+                    WriteExpr(As<ForStatement>(*statement).to().get());
+                    WriteStatement(As<ForStatement>(*statement).statement().get());
+                    break;
+                case EXIT_STATEMENT:
+                    break;
+                case WHILE_STATEMENT:
+                    WriteExpr(As<WhileStatement>(*statement).condition().get());
+                    WriteStatement(As<WhileStatement>(*statement).statement().get());
+                    break;
+            }
+        }
+
+        void WriteIdList(const IdList &id_list)
+        {
+            PutVarint(id_list.offset());
+            PutVarint(id_list.Size());
+            for (int i = 0; i < id_list.Size(); i++)
+                PutString(id_list[i]);
+        }
+
+        void WriteType(const Type &type)
+        {
+            PutVarint(type.offset());
+            PutByte(type.is_array());
+            PutSigned(type.basic_type());
+            PutVarint(type.periods().size());
+            for (const auto &period : type.periods())
+            {
+                PutSigned(period.digits_1);
+                PutSigned(period.digits_2);
+            }
+        }
+
+        void WriteDeclarations(const vector<shared_ptr<ConstDeclaration>> &consts,
+                               const vector<shared_ptr<VarDeclaration>> &vars)
+        {
+            PutVarint(consts.size());
+            for (const auto &declaration : consts)
+            {
+                PutVarint(declaration->offset());
+                PutString(declaration->id());
+                WriteExpr(declaration->const_value().get());
+            }
+            PutVarint(vars.size());
+            for (const auto &declaration : vars)
+            {
+                PutVarint(declaration->offset());
+                WriteIdList(*declaration->id_list());
+                WriteType(*declaration->type());
+            }
+        }
+
+        void WriteSubprogram(const Subprogram &subprogram)
+        {
+            PutVarint(subprogram.offset());
+
+            const SubprogramHead &head = *subprogram.subprogram_head();
+            PutVarint(head.offset());
+            PutString(head.id());
+            PutSigned(head.return_type());
+            PutVarint(head.parameters().size());
+            for (const auto &parameter : head.parameters())
+            {
+                PutVarint(parameter->offset());
+                PutByte(parameter->is_var());
+                WriteIdList(*parameter->id_list());
+                PutSigned(parameter->type());
+            }
+
+            const SubprogramBody &body = *subprogram.subprogram_body();
+            PutVarint(body.offset());
+            WriteDeclarations(body.const_declarations(), body.var_declarations());
+            WriteStatement(body.statement_list().get());
+        }
+
+        void WriteProgram(const Program &program)
+        {
+            PutVarint(program.offset());
+
+            const ProgramHead &head = *program.program_head();
+            PutVarint(head.offset());
+            PutString(head.id());
+            PutByte(head.HasIdList());
+            if (head.HasIdList())
+                WriteIdList(*head.id_list());
+
+            const ProgramBody &body = *program.program_body();
+            PutVarint(body.offset());
+            WriteDeclarations(body.const_declarations(), body.var_declarations());
+            PutVarint(body.subprogram_declarations().size());
+            for (const auto &subprogram : body.subprogram_declarations())
+                WriteSubprogram(*subprogram);
+            WriteStatement(body.statements().get());
+        }
+
+        std::string body_;
+        std::unordered_map<std::string, uint64_t> string_index_;
+        vector<const std::string *> strings_; // keys of string_index_ by index
+        size_t strings_size_ = 0;             // a guess of the bytes of the string table
+        std::unordered_map<const Expression *, uint64_t> expr_index_;
+    };
+
+    // reads the layout of serialize.h back into nodes allocated in an arena,
+    // every read is checked against the end of the bytes
+    class CacheReader
+    {
+    public:
+        CacheReader(std::string_view bytes, Interner &symbols) : bytes_(bytes), symbols_(symbols) {}
+
+        std::shared_ptr<Program> Read()
+        {
+            if (bytes_.size() < kHeaderSize || std::memcmp(bytes_.data(), kMagic, sizeof(kMagic)) != 0)
+                Fail("not a cache entry");
+            if (GetFixed(bytes_, 4, 4) != kCacheVersion)
+                Fail("version " + std::to_string(GetFixed(bytes_, 4, 4)) + " is not " +
+                     std::to_string(kCacheVersion));
+            pos_ = kHeaderSize;
+
+            uint64_t count = GetCount();
+            strings_.reserve(count);
+            for (uint64_t i = 0; i < count; i++)
+            {
+                uint64_t size = GetCount();
+                strings_.emplace_back(bytes_.substr(pos_, size));
+                pos_ += size;
+            }
+            ids_.assign(strings_.size(), kNotInterned);
+
+            auto program = ReadProgram();
+            if (pos_ != bytes_.size())
+                Fail("bytes after the program");
+            return Root(std::move(program), arena_);
+        }
+
+    private:
+        [[noreturn]] void Fail(const std::string &what) const
+        {
+            throw std::runtime_error("ast cache: " + what + " at byte " + std::to_string(pos_));
+        }
+
+        template <typename Tp, typename... Args>
+        std::shared_ptr<Tp> NewNode(Args &&...args)
+        {
+            return std::allocate_shared<Tp>(ArenaAllocator<Tp>(arena_.get()), std::forward<Args>(args)...);
+        }
+
+        uint8_t GetByte()
+        {
+            if (pos_ >= bytes_.size())
+                Fail("cut short");
+            return static_cast<uint8_t>(bytes_[pos_++]);
+        }
+
+        uint64_t GetVarint()
+        {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7)
+            {
+                uint8_t byte = GetByte();
+                value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0)
+                    return value;
+            }
+            Fail("varint too long");
+        }
+
+        int64_t GetSigned()
+        {
+            uint64_t value = GetVarint();
+            return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        }
+
+        int GetInt()
+        {
+            int64_t value = GetSigned();
+            if (value < INT32_MIN || value > INT32_MAX)
+                Fail("number out of range");
+            return static_cast<int>(value);
+        }
+
+        uint32_t GetOffset()
+        {
+            uint64_t value = GetVarint();
+            if (value > UINT32_MAX)
+                Fail("offset out of range");
+            return static_cast<uint32_t>(value);
+        }
+
+        // the length of a list or string, every element takes a byte at least so a
+        // length beyond the rest of the bytes cannot be right
+        uint64_t GetCount()
+        {
+            uint64_t count = GetVarint();
+            if (count > bytes_.size() - pos_)
+                Fail("cut short");
+            return count;
+        }
+
+        uint64_t GetStringIndex()
+        {
+            uint64_t index = GetVarint();
+            if (index >= strings_.size())
+                Fail("no string " + std::to_string(index));
+            return index;
+        }
+
+        const std::string &GetString()
+        {
+            return strings_[GetStringIndex()];
+        }
+
+        // read an identifier, each one is interned the first time it is met
+        // param:
+        //     symbol is set to the id of the identifier in symbols_
+        // return:
+        //     the identifier
+        const std::string &GetName(SymbolId &symbol)
+        {
+            uint64_t index = GetStringIndex();
+            if (ids_[index] == kNotInterned)
+                ids_[index] = symbols_.Intern(strings_[index]);
+            symbol = ids_[index];
+            return strings_[index];
+        }
+
+        // param:
+        //     count is the number of operands the node takes from the stack
+        // return:
+        //     the operands, in the order they were written
+        vector<std::shared_ptr<Expression>> PopOperands(vector<std::shared_ptr<Expression>> &stack, uint64_t count)
+        {
+            if (count > stack.size())
+                Fail("missing operand");
+            vector<std::shared_ptr<Expression>> operands(std::make_move_iterator(stack.end() - count),
+                                                         std::make_move_iterator(stack.end()));
+            stack.resize(stack.size() - count);
+            return operands;
+        }
+
+        std::shared_ptr<Expression> ReadExpr()
+        {
+            vector<std::shared_ptr<Expression>> stack;
+            while (true)
+            {
+                uint8_t kind = GetByte();
+                if (kind == kExprEnd)
+                    break;
+                if (kind == kExprNull)
+                {
+                    stack.push_back(nullptr);
+                    continue;
+                }
+                if (kind == kExprRef)
+                {
+                    uint64_t index = GetVarint();
+                    if (index >= exprs_.size())
+                        Fail("no expression " + std::to_string(index));
+                    stack.push_back(exprs_[index]);
+                    continue;
+                }
+
+                uint32_t offset = GetOffset();
+                std::shared_ptr<Expression> expr;
+                switch (kind)
+                {
+                    case INT:
+                        expr = NewNode<IntegerValue>(offset, GetInt());
+                        break;
+                    case REAL:
+                    {
+                        if (bytes_.size() - pos_ < 8)
+                            Fail("cut short");
+                        uint64_t bits = GetFixed(bytes_, pos_, 8);
+                        pos_ += 8;
+                        double value;
+                        std::memcpy(&value, &bits, sizeof(value));
+                        expr = NewNode<RealValue>(offset, value);
+                        break;
+                    }
+                    case CHAR:
+                        expr = NewNode<CharValue>(offset, GetInt());
+                        break;
+                    case BOOLEAN:
+                        expr = NewNode<BooleanValue>(offset, GetByte() != 0);
+                        break;
+                    case STRING:
+                        expr = NewNode<StringValue>(offset, GetString());
+                        break;
+                    case CALL_OR_VAR:
+                    {
+                        SymbolId symbol;
+                        const std::string &id = GetName(symbol);
+                        expr = NewNode<CallOrVar>(offset, id, symbol);
+                        break;
+                    }
+                    case VARIABLE:
+                    {
+                        SymbolId symbol;
+                        const std::string &id = GetName(symbol);
+                        expr = NewNode<Variable>(offset, id, symbol, PopOperands(stack, GetVarint()));
+                        break;
+                    }
+                    case CALL:
+                    {
+                        SymbolId symbol;
+                        const std::string &id = GetName(symbol);
+                        expr = NewNode<CallValue>(offset, id, symbol, PopOperands(stack, GetVarint()));
+                        break;
+                    }
+                    case BINARY:
+                    {
+                        int op = GetInt();
+                        auto operands = PopOperands(stack, 2);
+                        expr = NewNode<BinaryExpr>(offset, op, std::move(operands[0]), std::move(operands[1]));
+                        break;
+                    }
+                    case UNARY:
+                    {
+                        int op = GetInt();
+                        auto operands = PopOperands(stack, 1);
+                        expr = NewNode<UnaryExpr>(offset, op, std::move(operands[0]));
+                        break;
+                    }
+                    default:
+                        Fail("no expression kind " + std::to_string(kind));
+                }
+                exprs_.push_back(expr);
+                stack.push_back(std::move(expr));
+            }
+            if (stack.size() != 1)
+                Fail("expression left " + std::to_string(stack.size()) + " operands");
+            return std::move(stack.back());
+        }
+
+        vector<std::shared_ptr<Expression>> ReadExprList()
+        {
+            vector<std::shared_ptr<Expression>> exprs(GetCount());
+            for (auto &expr : exprs)
+                expr = ReadExpr();
+            return exprs;
+        }
+
+        std::shared_ptr<Statement> ReadStatement()
+        {
+            uint8_t kind = GetByte();
+            if (kind == kStatementNull)
+                return nullptr;
+            uint32_t offset = GetOffset();
+            switch (kind)
+            {
+                case ASSIGN_STATEMENT:
+                {
+                    auto var = ReadExpr();
+                    if (var == nullptr || !IsA<Variable>(*var))
+                        Fail("assignment to no variable");
+                    auto expr = ReadExpr();
+                    return NewNode<AssignStatement>(offset, std::static_pointer_cast<Variable>(var), std::move(expr));
+                }
+                case CALL_STATEMENT:
+                {
+                    SymbolId symbol;
+                    const std::string &name = GetName(symbol);
+                    return NewNode<CallStatement>(offset, name, symbol, ReadExprList());
+                }
+                case COMPOUND_STATEMENT:
+                {
+                    vector<std::shared_ptr<Statement>> statements(GetCount());
+                    for (auto &statement : statements)
+                        statement = ReadStatement();
+                    return NewNode<CompoundStatement>(offset, std::move(statements));
+                }
+                case IF_STATEMENT:
+                {
+                    auto condition = ReadExpr();
+                    auto then = ReadStatement();
+                    auto else_part = ReadStatement();
+                    return NewNode<IfStatement>(offset, std::move(condition), std::move(then), std::move(else_part));
+                }
+                case FOR_STATEMENT:
+                {
+                    SymbolId symbol;
+                    const std::string &id = GetName(symbol);
+                    auto from = ReadExpr();
+                    auto to = ReadExpr();
+                    auto statement = ReadStatement();
+                    auto loop = NewNode<ForStatement>(id, symbol, std::move(from), std::move(to), std::move(statement));
+                    loop->SetOffset(offset);
+                    return loop;
+                }
+                case EXIT_STATEMENT:
+                    return NewNode<ExitStatement>(offset);
+                case WHILE_STATEMENT:
+                {
+                    auto condition = ReadExpr();
+                    auto statement = ReadStatement();
+                    return NewNode<WhileStatement>(offset, std::move(condition), std::move(statement));
+                }
+            }
+            Fail("no statement kind " + std::to_string(kind));
+        }
+
+        std::shared_ptr<IdList> ReadIdList()
+        {
+            auto id_list = NewNode<IdList>(GetOffset());
+            for (uint64_t count = GetCount(); count > 0; count--)
+            {
+                SymbolId symbol;
+                const std::string &id = GetName(symbol);
+                id_list->AddId(id, symbol);
+            }
+            return id_list;
+        }
+
+        std::shared_ptr<Type> ReadType()
+        {
+            uint32_t offset = GetOffset();
+            bool is_array = GetByte() != 0;
+            auto type = NewNode<Type>(offset, is_array, GetInt());
+            for (uint64_t count = GetCount(); count > 0; count--)
+            {
+                int digits_1 = GetInt();
+                type->AddPeriod({digits_1, GetInt()});
+            }
+            return type;
+        }
+
+        // param:
+        //     body is a ProgramBody or a SubprogramBody to add the declarations to
+        template <typename Body>
+        void ReadDeclarations(Body &body)
+        {
+            for (uint64_t count = GetCount(); count > 0; count--)
+            {
+                uint32_t offset = GetOffset();
+                SymbolId symbol;
+                const std::string &id = GetName(symbol);
+                body.AddConstDeclaration(NewNode<ConstDeclaration>(offset, id, ReadExpr(), symbol));
+            }
+            for (uint64_t count = GetCount(); count > 0; count--)
+            {
+                uint32_t offset = GetOffset();
+                auto id_list = ReadIdList();
+                body.AddVarDeclaration(NewNode<VarDeclaration>(offset, std::move(id_list), ReadType()));
+            }
+        }
+
+        std::shared_ptr<Subprogram> ReadSubprogram()
+        {
+            uint32_t offset = GetOffset();
+
+            uint32_t head_offset = GetOffset();
+            SymbolId symbol;
+            const std::string &id = GetName(symbol);
+            int return_type = GetInt();
+            auto head = NewNode<SubprogramHead>(head_offset, id, return_type, symbol);
+            for (uint64_t count = GetCount(); count > 0; count--)
+            {
+                uint32_t parameter_offset = GetOffset();
+                bool is_var = GetByte() != 0;
+                auto id_list = ReadIdList();
+                head->AddParameter(NewNode<Parameter>(parameter_offset, is_var, std::move(id_list), GetInt()));
+            }
+
+            auto body = NewNode<SubprogramBody>(GetOffset());
+            ReadDeclarations(*body);
+            body->set_statements(ReadStatement());
+            return NewNode<Subprogram>(offset, std::move(head), std::move(body));
+        }
+
+        std::shared_ptr<Program> ReadProgram()
+        {
+            uint32_t offset = GetOffset();
+
+            uint32_t head_offset = GetOffset();
+            const std::string &id = GetString();
+            auto head = GetByte() != 0 ? NewNode<ProgramHead>(head_offset, id, ReadIdList())
+                                       : NewNode<ProgramHead>(head_offset, id);
+
+            auto body = NewNode<ProgramBody>(GetOffset());
+            ReadDeclarations(*body);
+            for (uint64_t count = GetCount(); count > 0; count--)
+                body->AddSubprogram(ReadSubprogram());
+            body->set_statements(ReadStatement());
+            return NewNode<Program>(offset, std::move(head), std::move(body));
+        }
+
+        std::shared_ptr<Arena> arena_ = std::make_shared<Arena>(); // goes after the nodes below
+        std::string_view bytes_;
+        size_t pos_ = 0;
+        vector<std::string> strings_;
+        Interner &symbols_;
+        static constexpr SymbolId kNotInterned = UINT32_MAX;
+        vector<SymbolId> ids_;                      // of strings_ met as an identifier, kNotInterned before
+        vector<std::shared_ptr<Expression>> exprs_; // by the index of a reference
+    };
+
+    std::string WriteProgram(const Program &program, const CacheKey &key)
+    {
+        return CacheWriter().Finish(program, key);
+    }
+
+    bool CacheMatches(std::string_view bytes, const CacheKey &key)
+    {
+        return bytes.size() >= kHeaderSize && std::memcmp(bytes.data(), kMagic, sizeof(kMagic)) == 0 &&
+               GetFixed(bytes, 4, 4) == kCacheVersion && GetFixed(bytes, 8, 8) == key.build &&
+               GetFixed(bytes, 16, 8) == key.digest[0] && GetFixed(bytes, 24, 8) == key.digest[1] &&
+               GetFixed(bytes, 32, 8) == key.size &&
+               GetFixed(bytes, 40, 8) == Murmur3(bytes.substr(kHeaderSize)).first;
+    }
+
+    std::shared_ptr<Program> ReadProgram(std::string_view bytes, Interner &symbols)
+    {
+        return CacheReader(bytes, symbols).Read();
+    }
+}
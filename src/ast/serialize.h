@@ -0,0 +1,77 @@
+#ifndef PASCAL2C_SRC_AST_SERIALIZE_H_
+#define PASCAL2C_SRC_AST_SERIALIZE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "ast/interner.h"
+#include "ast/program.h"
+
+namespace pascal2c::ast
+{
+    // the binary form of a parsed program, written once and loaded on later runs
+    // instead of scanning and parsing the unchanged source again
+    // layout, all numbers little endian:
+    //     header      "P2CA", u32 version, u64 BuildFingerprint(), u64 x 2 digest of the
+    //                 source, u64 size of the source, u64 checksum of all bytes after the header
+    //     strings     count, then every identifier and string literal once: length, bytes
+    //     program     the nodes in preorder, each a kind byte, its offset and its fields,
+    //                 strings by their index, lists by their length first, an expression
+    //                 is its nodes in postorder and an end byte so a deep one is loaded
+    //                 with a stack of operands instead of recursion
+    // the counts, offsets and indexes are LEB128 varints, signed values zigzag coded
+    // an expression met a second time, eg. one shared by ExprPool, is written as a
+    // reference to its first occurrence so the loaded tree shares it too
+    // the loader only reads the bytes, they can be a mapped file
+    // an entry is only taken for the very source and build it was written by, and
+    // only if its bytes are whole, see CacheMatches
+    // usage:
+    //     CacheKey key = CacheKey::Of(source);
+    //     std::string bytes = WriteProgram(*program, key);
+    //     if (CacheMatches(bytes, key))
+    //         program = ReadProgram(bytes);
+    static constexpr uint32_t kCacheVersion = 2;
+
+    // return:
+    //     a fingerprint of kCacheVersion and of the lexer, parser and ast sources this
+    //     program was built from, see src/ast/fingerprint.cmake, so an entry written by
+    //     another build is never loaded
+    uint64_t BuildFingerprint();
+
+    // what a cache entry is looked up and checked by
+    struct CacheKey
+    {
+        uint64_t digest[2] = {}; // MurmurHash3 x64 128 of the source, two sources with the
+                                 // same size and digest are taken to be the same
+        uint64_t size = 0;       // of the source in bytes
+        uint64_t build = 0;      // BuildFingerprint() of the program writing or reading the entry
+
+        // return:
+        //     the key of source for this build
+        static CacheKey Of(std::string_view source);
+    };
+
+    // param:
+    //     program was parsed without syntax errors from the source of key
+    // return:
+    //     the bytes of the cache entry
+    std::string WriteProgram(const Program &program, const CacheKey &key);
+
+    // return:
+    //     true if bytes are a cache entry of this version for the source and build of
+    //     key and the checksum of its body holds
+    bool CacheMatches(std::string_view bytes, const CacheKey &key);
+
+    // param:
+    //     bytes are a cache entry, see CacheMatches
+    //     symbols gets the identifiers of the program, the loaded nodes keep their ids in it
+    // return:
+    //     the program, its nodes live in an arena of their own
+    // throw:
+    //     std::runtime_error if bytes are not a cache entry of this version or are cut short
+    std::shared_ptr<Program> ReadProgram(std::string_view bytes, Interner &symbols);
+}
+
+#endif // !PASCAL2C_SRC_AST_SERIALIZE_H_
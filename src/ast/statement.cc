@@ -12,26 +12,26 @@
     std::stringstream str_s;\
     do{ \
         IndentOutput(str_s, level);     \
-        str_s << line() << ":" << column() <<" "; \
+        str_s << line(lines) << ":" << column(lines) <<" "; \
     }while(0)
 
 namespace pascal2c::ast
 {
 
-    std::string AssignStatement::ToString(int level) const
+    std::string AssignStatement::ToString(int level, const LineTable &lines) const
     {
         INIT_TOSTRING(str_s, level);
         str_s << "AssignStatement :\n";
         IndentOutput(str_s, level);
         str_s << "Variable:\n"
-              << var_->ToString(level + 1) << "\n";
+              << var_->ToString(level + 1, lines) << "\n";
         IndentOutput(str_s, level);
         str_s << "Expr :\n"
-              << expr_->ToString(level + 1);
+              << expr_->ToString(level + 1, lines);
         return str_s.str();
     }
 
-    std::string CallStatement::ToString(int level) const
+    std::string CallStatement::ToString(int level, const LineTable &lines) const
     {
         INIT_TOSTRING(str_s, level);
         str_s << "CallStatement :\n";
@@ -43,13 +43,13 @@ namespace pascal2c::ast
             str_s << "\n";
             IndentOutput(str_s, level);
             str_s << "expr " << i + 1 << ":\n"
-                  << expr_list_[i]->ToString(level + 1);
+                  << expr_list_[i]->ToString(level + 1, lines);
         }
 
         return str_s.str();
     }
 
-    std::string CompoundStatement::ToString(int level) const
+    std::string CompoundStatement::ToString(int level, const LineTable &lines) const
     {
         INIT_TOSTRING(str_s, level);
         str_s << "CompoundStatement :" << statements_.size();
@@ -58,32 +58,32 @@ namespace pascal2c::ast
             str_s << "\n";
             IndentOutput(str_s, level);
             str_s << "statement " << i + 1 << ":\n"
-                  << statements_[i]->ToString(level + 1);
+                  << statements_[i]->ToString(level + 1, lines);
         }
         return str_s.str();
     }
 
-    std::string IfStatement::ToString(int level) const
+    std::string IfStatement::ToString(int level, const LineTable &lines) const
     {
         INIT_TOSTRING(str_s, level);
         str_s << "IfStatement :\n";
         IndentOutput(str_s, level);
         str_s << "condition:\n"
-              << condition_->ToString(level + 1) << "\n";
+              << condition_->ToString(level + 1, lines) << "\n";
         IndentOutput(str_s, level);
         str_s << "if_part:\n"
-              << then_->ToString(level + 1);
+              << then_->ToString(level + 1, lines);
         if (else_part_ != nullptr)
         {
             str_s << "\n";
             IndentOutput(str_s, level);
             str_s << "else_part:\n"
-                  << else_part_->ToString(level + 1);
+                  << else_part_->ToString(level + 1, lines);
         }
         return str_s.str();
     }
 
-    std::string ForStatement::ToString(int level) const
+    std::string ForStatement::ToString(int level, const LineTable &lines) const
     {
         INIT_TOSTRING(str_s, level);
         str_s << "ForStatement:\n";
@@ -91,31 +91,31 @@ namespace pascal2c::ast
         str_s << "id: " << id_ << "\n";
         IndentOutput(str_s, level);
         str_s << "from:\n"
-              << from_->ToString(level + 1) << "\n";
+              << from_->ToString(level + 1, lines) << "\n";
         IndentOutput(str_s, level);
         str_s << "to:\n"
-              << to_->ToString(level + 1) << "\n";
+              << to_->ToString(level + 1, lines) << "\n";
         IndentOutput(str_s, level);
         str_s << "do:\n"
-              << statement_->ToString(level + 1);
+              << statement_->ToString(level + 1, lines);
         return str_s.str();
     }
 
-    std::string ExitStatement::ToString(int level) const {
+    std::string ExitStatement::ToString(int level, const LineTable &lines) const {
         INIT_TOSTRING(str_s, level);
         str_s << "ExitStatement";
         return str_s.str();
     }
 
-    std::string WhileStatement::ToString(int level) const {
+    std::string WhileStatement::ToString(int level, const LineTable &lines) const {
         INIT_TOSTRING(str_s, level);
         str_s << "WhileStatement:\n";
         IndentOutput(str_s, level);
         str_s << "condition:\n"
-              << condition_->ToString(level + 1) << "\n";
+              << condition_->ToString(level + 1, lines) << "\n";
         IndentOutput(str_s, level);
         str_s << "do:\n"
-              << statement_->ToString(level + 1);
+              << statement_->ToString(level + 1, lines);
         return str_s.str();
     }
 }
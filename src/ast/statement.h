@@ -36,32 +36,38 @@ namespace pascal2c::ast
         // for test use
         // param:
         //     level is the level of indentation that should be applied to the returned string
+        //     lines is the line table of the parsed source, the positions are looked up there
         // return:
         //     a string represents the statement
-        virtual std::string ToString(int level) const = 0;
-        // to get exact statement type of the statement
+        virtual std::string ToString(int level, const LineTable &lines) const = 0;
+        // to get exact statement type of the statement, it is kept in the node so asking costs no virtual call
         // return:
         //     exact type of statement
-        virtual StatementType GetType() const = 0;
+        inline StatementType GetType() const { return type_; }
 
-        Statement() = default;
-        Statement(int line, int col) : Ast(line, col) {}
+        explicit Statement(StatementType type) : type_(type) {}
+        Statement(StatementType type, uint32_t offset) : Ast(offset), type_(type) {}
+
+    private:
+        StatementType type_; // set by the constructor of the exact class
     };
 
     class ExitStatement : public Statement{
     public:
-        ExitStatement() = default;
-        ExitStatement(int line, int col) : Statement(line,col) {}
-        std::string ToString(int level) const override;
-        StatementType GetType() const override { return EXIT_STATEMENT; }
+        static constexpr StatementType kType = EXIT_STATEMENT;
+
+        ExitStatement() : Statement(kType) {}
+        explicit ExitStatement(uint32_t offset) : Statement(kType, offset) {}
+        std::string ToString(int level, const LineTable &lines) const override;
     };
 
     class WhileStatement : public Statement{
     public:
-        WhileStatement(std::shared_ptr<Expression> condition, std::shared_ptr<Statement> statement) : condition_(std::move(condition)), statement_(std::move(statement)) {}
-        WhileStatement(int line, int col, std::shared_ptr<Expression> condition, std::shared_ptr<Statement> statement) : Statement(line,col), condition_(std::move(condition)), statement_(std::move(statement)) {}
-        std::string ToString(int level) const override;
-        StatementType GetType() const override { return WHILE_STATEMENT; }
+        static constexpr StatementType kType = WHILE_STATEMENT;
+
+        WhileStatement(std::shared_ptr<Expression> condition, std::shared_ptr<Statement> statement) : Statement(kType), condition_(std::move(condition)), statement_(std::move(statement)) {}
+        WhileStatement(uint32_t offset, std::shared_ptr<Expression> condition, std::shared_ptr<Statement> statement) : Statement(kType, offset), condition_(std::move(condition)), statement_(std::move(statement)) {}
+        std::string ToString(int level, const LineTable &lines) const override;
 
         GETTER(std::shared_ptr<Expression>, condition);
         GETTER(std::shared_ptr<Statement>, statement);
@@ -76,19 +82,19 @@ namespace pascal2c::ast
     class AssignStatement : public Statement
     {
     public:
+        static constexpr StatementType kType = ASSIGN_STATEMENT;
+
         // basic constructor
         // param:
         //     var is used to initialize the class member var_
         //     expr is used to initialize the class member expr_
-        AssignStatement(std::shared_ptr<Variable> var, std::shared_ptr<Expression> expr) : var_(std::move(var)), expr_(
+        AssignStatement(std::shared_ptr<Variable> var, std::shared_ptr<Expression> expr) : Statement(kType), var_(std::move(var)), expr_(
                                                                                                                      std::move(expr)) {}
 
-        AssignStatement(int line,int col, std::shared_ptr<Variable> var, std::shared_ptr<Expression> expr) :Statement(line,col), var_(std::move(var)), expr_(
+        AssignStatement(uint32_t offset, std::shared_ptr<Variable> var, std::shared_ptr<Expression> expr) :Statement(kType, offset), var_(std::move(var)), expr_(
                 std::move(expr)) {}
 
-        inline StatementType GetType() const override { return ASSIGN_STATEMENT; }
-
-        std::string ToString(int level) const override;
+        std::string ToString(int level, const LineTable &lines) const override;
 
         GETTER(std::shared_ptr<Variable>, var);
         GETTER(std::shared_ptr<Expression>, expr);
@@ -106,22 +112,27 @@ namespace pascal2c::ast
     class CallStatement : public Statement
     {
     public:
-        CallStatement(std::string name, vector<std::shared_ptr<Expression>> expr_list) : name_(std::move(name)), expr_list_(std::move(expr_list)) {}
-        CallStatement(int line,int col, std::string name, vector<std::shared_ptr<Expression>> expr_list) :
-                            Statement(line,col), name_(std::move(name)), expr_list_(std::move(expr_list)) {}
-        explicit CallStatement(std::string name) : name_(std::move(name)) {}
-        explicit CallStatement(int line,int col,std::string name) :Statement(line,col), name_(std::move(name)) {}
-
+        static constexpr StatementType kType = CALL_STATEMENT;
 
-        inline StatementType GetType() const override { return CALL_STATEMENT; }
+        CallStatement(std::string name, vector<std::shared_ptr<Expression>> expr_list) : Statement(kType), name_(std::move(name)), expr_list_(std::move(expr_list)) {}
+        CallStatement(uint32_t offset, std::string name, vector<std::shared_ptr<Expression>> expr_list) :
+                            Statement(kType, offset), name_(std::move(name)), expr_list_(std::move(expr_list)) {}
+        explicit CallStatement(std::string name) : Statement(kType), name_(std::move(name)) {}
+        explicit CallStatement(uint32_t offset,std::string name) :Statement(kType, offset), name_(std::move(name)) {}
+        // symbol is the interned name
+        CallStatement(uint32_t offset, std::string name, SymbolId symbol, vector<std::shared_ptr<Expression>> expr_list = {}) :
+                            Statement(kType, offset), name_(std::move(name)), symbol_(symbol), expr_list_(std::move(expr_list)) {}
 
-        std::string ToString(int level) const override;
+        std::string ToString(int level, const LineTable &lines) const override;
 
         GETTER(std::string, name);
         GETTER(vector<std::shared_ptr<Expression>>, expr_list);
+        // the interned name, 0 for a node that was not parsed
+        inline SymbolId symbol() const { return symbol_; }
 
     private:
         std::string name_; // procedure name or function name
+        SymbolId symbol_ = 0;
 
         vector<std::shared_ptr<Expression>> expr_list_; // can be empty:  e.g. procedure_name;   func();
     };
@@ -135,13 +146,13 @@ namespace pascal2c::ast
     class CompoundStatement : public Statement
     {
     public:
-        explicit CompoundStatement(vector<std::shared_ptr<Statement>> statements) : statements_(std::move(statements)) {}
-        explicit CompoundStatement(int line,int col, vector<std::shared_ptr<Statement>> statements) :
-                               Statement(line,col), statements_(std::move(statements)) {}
+        static constexpr StatementType kType = COMPOUND_STATEMENT;
 
-        inline StatementType GetType() const override { return COMPOUND_STATEMENT; }
+        explicit CompoundStatement(vector<std::shared_ptr<Statement>> statements) : Statement(kType), statements_(std::move(statements)) {}
+        explicit CompoundStatement(uint32_t offset, vector<std::shared_ptr<Statement>> statements) :
+                               Statement(kType, offset), statements_(std::move(statements)) {}
 
-        std::string ToString(int level) const override;
+        std::string ToString(int level, const LineTable &lines) const override;
 
         GETTER(vector<std::shared_ptr<Statement>>, statements);
 
@@ -156,17 +167,17 @@ namespace pascal2c::ast
     class IfStatement : public Statement
     {
     public:
+        static constexpr StatementType kType = IF_STATEMENT;
+
         IfStatement(std::shared_ptr<Expression> cond, std::shared_ptr<Statement> then,
                     std::shared_ptr<Statement> else_part)
-            : condition_(std::move(cond)), then_(std::move(then)), else_part_(std::move(else_part)) {}
+            : Statement(kType), condition_(std::move(cond)), then_(std::move(then)), else_part_(std::move(else_part)) {}
 
-        IfStatement(int line,int col, std::shared_ptr<Expression> cond, std::shared_ptr<Statement> then,
+        IfStatement(uint32_t offset, std::shared_ptr<Expression> cond, std::shared_ptr<Statement> then,
                     std::shared_ptr<Statement> else_part) :
-                    Statement(line,col), condition_(std::move(cond)), then_(std::move(then)), else_part_(std::move(else_part)) {}
-
-        inline StatementType GetType() const override { return IF_STATEMENT; }
+                    Statement(kType, offset), condition_(std::move(cond)), then_(std::move(then)), else_part_(std::move(else_part)) {}
 
-        std::string ToString(int level) const override;
+        std::string ToString(int level, const LineTable &lines) const override;
 
         GETTER(std::shared_ptr<Expression>, condition);
         GETTER(std::shared_ptr<Statement>, then);
@@ -182,33 +193,59 @@ namespace pascal2c::ast
     class ForStatement : public Statement
     {
     public:
+        static constexpr StatementType kType = FOR_STATEMENT;
+
         ForStatement(std::shared_ptr<Expression> from, std::shared_ptr<Expression> to,
                      std::shared_ptr<Statement> statement)
-            : from_(std::move(from)), to_(std::move(to)), statement_(std::move(statement)) {}
+            : Statement(kType), from_(std::move(from)), to_(std::move(to)), statement_(std::move(statement)) {}
 
         ForStatement(std::string id, std::shared_ptr<Expression> from, std::shared_ptr<Expression> to,
                      std::shared_ptr<Statement> statement)
-                :id_(std::move(id)), from_(std::move(from)), to_(std::move(to)), statement_(std::move(statement)) {}
+                : Statement(kType), id_(std::move(id)), from_(std::move(from)), to_(std::move(to)), statement_(std::move(statement)) {}
 
-        ForStatement(int line,int col, std::string id, std::shared_ptr<Expression> from, std::shared_ptr<Expression> to,
+        ForStatement(uint32_t offset, std::string id, std::shared_ptr<Expression> from, std::shared_ptr<Expression> to,
                      std::shared_ptr<Statement> statement) :
-                     Statement(line,col), id_(std::move(id)), from_(std::move(from)), to_(std::move(to)), statement_(std::move(statement)) {}
+                     Statement(kType, offset), id_(std::move(id)), from_(std::move(from)), to_(std::move(to)), statement_(std::move(statement)) {}
 
-        inline StatementType GetType() const override { return FOR_STATEMENT; }
+        // symbol is the interned id
+        ForStatement(std::string id, SymbolId symbol, std::shared_ptr<Expression> from, std::shared_ptr<Expression> to,
+                     std::shared_ptr<Statement> statement)
+                : Statement(kType), id_(std::move(id)), symbol_(symbol), from_(std::move(from)), to_(std::move(to)), statement_(std::move(statement)) {}
 
-        std::string ToString(int level) const override;
+        std::string ToString(int level, const LineTable &lines) const override;
 
         GETTER(std::string, id);
         GETTER(std::shared_ptr<Expression>, from);
         GETTER(std::shared_ptr<Expression>, to);
         GETTER(std::shared_ptr<Statement>, statement);
+        // the interned id, 0 for a node that was not parsed
+        inline SymbolId symbol() const { return symbol_; }
 
     private:
         std::string id_;
+        SymbolId symbol_ = 0;
         std::shared_ptr<Expression> from_;
         std::shared_ptr<Expression> to_;
         std::shared_ptr<Statement> statement_;
     };
+
+    // return:
+    //     true if statement is a T, told by its kind tag without rtti
+    template <typename T>
+    inline bool IsA(const Statement &statement)
+    {
+        return statement.GetType() == T::kType;
+    }
+
+    // the statement as its exact class, no shared_ptr is copied
+    // param:
+    //     statement must be a T, see IsA
+    template <typename T>
+    inline const T &As(const Statement &statement)
+    {
+        assert(IsA<T>(statement));
+        return static_cast<const T &>(statement);
+    }
 }
 
 #endif // PASCAL2C_STATEMENT_H
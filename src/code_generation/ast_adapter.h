@@ -22,11 +22,39 @@ const int k_max_parameters = 255;
 
 class Visitor;
 
+// Kind of the nodes the generator tells apart while it walks a tree. The kind
+// is stored in the node, so telling them apart is a load and a compare instead
+// of a chain of dynamic_pointer_cast. Nodes nobody asks about are OTHER.
+enum class NodeKind {
+    OTHER,
+    NUM,
+    BOOL,
+    STRING,
+    REAL,
+    CHAR,
+    FUNCTION_CALL,
+    // the IVar kinds, see IsVar
+    VAR,
+    ARRAY,
+    ARRAY_ACCESS,
+    UNARY_OPERATION,
+    BINARY_OPERATION,
+};
+
 class ASTNode : public std::enable_shared_from_this<ASTNode> {
   public:
     ASTNode() = default;
+    explicit ASTNode(NodeKind kind) : kind_(kind) {}
     virtual ~ASTNode() = default;
     virtual void Accept(Visitor &visitor) = 0;
+    NodeKind GetKind() const { return kind_; }
+    // Whether the node is an IVar
+    bool IsVar() const {
+        return kind_ >= NodeKind::VAR && kind_ <= NodeKind::BINARY_OPERATION;
+    }
+
+  private:
+    NodeKind kind_ = NodeKind::OTHER;
 };
 
 // ASTRoot is an alias of ASTNode, representing the root node of an AST.
@@ -87,7 +115,7 @@ class Block : public ASTNode {
 class Num : public ASTNode {
   public:
     Num(const shared_ptr<Token> &token)
-        : value_(std::stoi(token->GetValue())) {}
+        : ASTNode(NodeKind::NUM), value_(std::stoi(token->GetValue())) {}
     virtual ~Num() = default;
     void Accept(Visitor &visitor) override;
     int GetValue() const { return value_; }
@@ -99,8 +127,8 @@ class Num : public ASTNode {
 class Bool : public ASTNode {
   public:
     Bool(const shared_ptr<Token> &token)
-        : value_(std::stoi(token->GetValue())) {}
-    Bool(const int value = 0) : value_(value) {}
+        : ASTNode(NodeKind::BOOL), value_(std::stoi(token->GetValue())) {}
+    Bool(const int value = 0) : ASTNode(NodeKind::BOOL), value_(value) {}
     virtual ~Bool() = default;
     void Accept(Visitor &visitor) override;
     int GetValue() const { return value_; }
@@ -112,7 +140,7 @@ class Bool : public ASTNode {
 class String : public ASTNode {
   public:
     String(const shared_ptr<Token> &token)
-        : value_(std::move(token->GetValue())) {}
+        : ASTNode(NodeKind::STRING), value_(std::move(token->GetValue())) {}
     virtual ~String() = default;
     void Accept(Visitor &visitor) override;
     const string GetValue() const { return value_; };
@@ -124,7 +152,7 @@ class String : public ASTNode {
 class Real : public ASTNode {
   public:
     Real(const shared_ptr<Token> &token)
-        : value_(std::move(token->GetValue())) {}
+        : ASTNode(NodeKind::REAL), value_(std::move(token->GetValue())) {}
     virtual ~Real() = default;
     void Accept(Visitor &visitor) override;
     const string GetValue() const { return value_; }
@@ -136,7 +164,7 @@ class Real : public ASTNode {
 class Char : public ASTNode {
   public:
     Char(const shared_ptr<Token> &token)
-        : value_(std::move(token->GetValue())) {}
+        : ASTNode(NodeKind::CHAR), value_(std::move(token->GetValue())) {}
     virtual ~Char() = default;
     void Accept(Visitor &visitor) override;
     const string GetValue() const { return value_; }
@@ -147,6 +175,7 @@ class Char : public ASTNode {
 
 class IVar : public ASTNode {
   public:
+    explicit IVar(NodeKind kind) : ASTNode(kind) {}
     virtual ~IVar() = default;
     virtual void Accept(Visitor &visitor) = 0;
     virtual const string GetName() const = 0;
@@ -158,12 +187,13 @@ class Var : public IVar {
     explicit Var(const shared_ptr<Token> &token, bool is_reference = false,
                  bool is_return_var = false,
                  VarType var_type = VarType::UNDEFINED)
-        : name_(token->GetValue()), is_reference_(is_reference),
+        : IVar(NodeKind::VAR), name_(token->GetValue()),
+          is_reference_(is_reference),
           is_return_var_(is_return_var), var_type_(var_type) {}
     explicit Var(const string &name, bool is_reference = false,
                  bool is_return_var = false ,
                  VarType var_type = VarType::UNDEFINED)
-        : name_(name), is_reference_(is_reference), 
+        : IVar(NodeKind::VAR), name_(name), is_reference_(is_reference),
           is_return_var_(is_return_var) , var_type_(var_type){}
     virtual ~Var() = default;
     void Accept(Visitor &visitor) override;
@@ -268,7 +298,8 @@ class Array : public IVar {
   public:
     Array(const shared_ptr<Var> &var, vector<std::pair<int, int>> bounds,
           VarType var_type = VarType::UNDEFINED)
-        : var_(var), bounds_(std::move(bounds)), var_type_(var_type) {}
+        : IVar(NodeKind::ARRAY), var_(var), bounds_(std::move(bounds)),
+          var_type_(var_type) {}
     virtual ~Array() = default;
     void Accept(Visitor &visitor) override;
     const string GetName() const override { return var_->GetName(); }
@@ -303,7 +334,8 @@ class ArrayAccess : public IVar {
     ArrayAccess(const shared_ptr<Array> &array,
                 const vector<shared_ptr<ASTNode>> &indices,
                 VarType var_type = VarType::UNDEFINED)
-        : array_(array), indices_(indices), var_type_(var_type) {}
+        : IVar(NodeKind::ARRAY_ACCESS), array_(array), indices_(indices),
+          var_type_(var_type) {}
     virtual ~ArrayAccess() = default;
     void Accept(Visitor &visitor) override;
     const shared_ptr<Array> &GetArray() const { return array_; }
@@ -444,6 +476,8 @@ class Assignment : public ASTNode {
     const shared_ptr<ASTNode> &GetRight() const { return right_; }
 
   private:
+    friend void ReleaseOperations(vector<shared_ptr<ASTNode>> &operands);
+
     shared_ptr<ASTNode> left_;
     shared_ptr<ASTNode> right_;
 };
@@ -460,12 +494,19 @@ class Oper : public ASTNode {
     string oper_;
 };
 
+// Free the operands of a binary or unary operation being destroyed. Nested
+// operations nobody else holds are taken apart one at a time with operands as
+// the work list, so destroying a deeply nested expression doesn't recurse once
+// per level. operands is left empty.
+void ReleaseOperations(vector<shared_ptr<ASTNode>> &operands);
+
 class UnaryOperation : public IVar {
   public:
     UnaryOperation(const shared_ptr<Oper> &oper,
                    const shared_ptr<ASTNode> &var_node, VarType var_type)
-        : oper_(oper), var_node_(var_node), var_type_(var_type) {}
-    virtual ~UnaryOperation() = default;
+        : IVar(NodeKind::UNARY_OPERATION), oper_(oper), var_node_(var_node),
+          var_type_(var_type) {}
+    virtual ~UnaryOperation();
     void Accept(Visitor &visitor) override;
     const shared_ptr<Oper> GetOper() const { return oper_; }
     const shared_ptr<ASTNode> GetVarNode() const { return var_node_; }
@@ -473,6 +514,8 @@ class UnaryOperation : public IVar {
     const string GetName() const override { return "unary_operation"; }
 
   private:
+    friend void ReleaseOperations(vector<shared_ptr<ASTNode>> &operands);
+
     shared_ptr<Oper> oper_;
     shared_ptr<ASTNode> var_node_;
     VarType var_type_;
@@ -484,8 +527,9 @@ class BinaryOperation : public IVar {
                              const shared_ptr<Oper> &oper,
                              const shared_ptr<ASTNode> &right,
                              VarType var_type = VarType::UNDEFINED)
-        : left_(left), oper_(oper), right_(right), var_type_(var_type) {}
-    virtual ~BinaryOperation() = default;
+        : IVar(NodeKind::BINARY_OPERATION), left_(left), oper_(oper),
+          right_(right), var_type_(var_type) {}
+    virtual ~BinaryOperation();
     void Accept(Visitor &visitor) override;
     const shared_ptr<ASTNode> &GetLeft() { return left_; }
     const shared_ptr<Oper> &GetOper() { return oper_; }
@@ -505,6 +549,8 @@ class BinaryOperation : public IVar {
     }
 
   private:
+    friend void ReleaseOperations(vector<shared_ptr<ASTNode>> &operands);
+
     shared_ptr<ASTNode> left_;
     shared_ptr<Oper> oper_;
     shared_ptr<ASTNode> right_;
@@ -596,9 +642,11 @@ class FunctionCall : public ASTNode {
                  const vector<shared_ptr<ASTNode>> parameters,
                  const bitset<k_max_parameters> ref_set,
                  VarType return_type = VarType::VOID)
-        : name_(name), parameters_(std::move(parameters)),
-          is_reference_(std::move(ref_set)), return_type_(return_type) {}
-    FunctionCall(const string &name) : name_(name), parameters_() {}
+        : ASTNode(NodeKind::FUNCTION_CALL), name_(name),
+          parameters_(std::move(parameters)), is_reference_(std::move(ref_set)),
+          return_type_(return_type) {}
+    FunctionCall(const string &name)
+        : ASTNode(NodeKind::FUNCTION_CALL), name_(name), parameters_() {}
     virtual ~FunctionCall() = default;
     void Accept(Visitor &visitor) override;
     const string GetName() const { return name_; }
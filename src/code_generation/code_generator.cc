@@ -20,6 +20,27 @@ void CodeGenerator::Interpret(const shared_ptr<ASTNode> &node) { Visit(node); }
 
 const string CodeGenerator::GetCCode() const { return ostream_.str(); }
 
+void CodeGenerator::InterpretGlobals(
+    const shared_ptr<Declaration> &declarations) {
+    WriteIncludes();
+    Visit(declarations);
+}
+
+void CodeGenerator::InterpretSubprogram(const shared_ptr<ASTNode> &subprogram) {
+    Visit(subprogram, true);
+}
+
+void CodeGenerator::InterpretMain(const string &program_name,
+                                  const shared_ptr<Compound> &statements) {
+    WriteMain(program_name, statements);
+}
+
+string CodeGenerator::TakeCCode() {
+    string code = ostream_.str();
+    ostream_.str("");
+    return code;
+}
+
 void CodeGenerator::Visit(const shared_ptr<code_generation::ASTNode> &node,
                           bool indent) {
     if (indent)
@@ -66,19 +87,28 @@ void CodeGenerator::VisitArgument(const shared_ptr<Argument> &node) {
 
 void CodeGenerator::VisitProgram(
     const shared_ptr<code_generation::Program> &node) {
+    WriteIncludes();
+
+    auto program_block = node->GetBlock();
+    Visit(program_block->GetDeclaration());
+
+    WriteMain(node->GetName(), program_block->GetCompoundStatement());
+}
+
+void CodeGenerator::WriteIncludes() {
     ostream_ << "#include <stdio.h>" << endl
              << "#include <stdlib.h>" << endl
              << "#include <stdbool.h>" << endl
              << endl;
+}
 
-    auto program_block = node->GetBlock();
-    Visit(program_block->GetDeclaration());
-
-    ostream_ << "// " << node->GetName() << endl;
+void CodeGenerator::WriteMain(const string &program_name,
+                              const shared_ptr<Compound> &statements) {
+    ostream_ << "// " << program_name << endl;
     ostream_ << "int main(int argc, char* argv[]) {" << endl;
 
     IncIndent();
-    Visit(program_block->GetCompoundStatement());
+    Visit(statements);
     ostream_ << Indent() << "return 0;" << endl;
     DecIndent();
     ostream_ << "}\n";
@@ -251,23 +281,49 @@ void CodeGenerator::VisitNoOp(const shared_ptr<code_generation::NoOp> &node) {
 
 void CodeGenerator::VisitUnaryOperation(
     const shared_ptr<UnaryOperation> &node) {
-    Visit(node->GetOper());
-    Visit(node->GetVarNode());
+    VisitOperation(node);
 }
 
 void CodeGenerator::VisitBinOp(
     const shared_ptr<code_generation::BinaryOperation> &node) {
-    ostream_ << '(';
-    if (node->TestCastRequired()) {
-        ostream_ << (node->GetVarType() == VarType::REAL ? "(double) "
-                                                         : "(int) ");
+    VisitOperation(node);
+}
+
+void CodeGenerator::VisitOperation(const shared_ptr<ASTNode> &node) {
+    // Nested operations are expanded on an explicit stack instead of through
+    // Accept, so deeply nested expressions don't use up the call stack.
+    // An item is either a node to visit or text to write.
+    struct Item {
+        shared_ptr<ASTNode> node;
+        const char *text;
+    };
+    vector<Item> items{{node, nullptr}};
+    while (!items.empty()) {
+        Item item = std::move(items.back());
+        items.pop_back();
+        if (item.text) {
+            ostream_ << item.text;
+        } else if (item.node->GetKind() == NodeKind::BINARY_OPERATION) {
+            auto *bin_op = static_cast<BinaryOperation *>(item.node.get());
+            ostream_ << '(';
+            if (bin_op->TestCastRequired()) {
+                ostream_ << (bin_op->GetVarType() == VarType::REAL ? "(double) "
+                                                                   : "(int) ");
+            }
+            items.push_back({nullptr, ")"});
+            items.push_back({bin_op->GetRight(), nullptr});
+            items.push_back({nullptr, " "});
+            items.push_back({bin_op->GetOper(), nullptr});
+            items.push_back({nullptr, " "});
+            items.push_back({bin_op->GetLeft(), nullptr});
+        } else if (item.node->GetKind() == NodeKind::UNARY_OPERATION) {
+            auto *unary_op = static_cast<UnaryOperation *>(item.node.get());
+            items.push_back({unary_op->GetVarNode(), nullptr});
+            items.push_back({unary_op->GetOper(), nullptr});
+        } else {
+            Visit(item.node);
+        }
     }
-    Visit(node->GetLeft());
-    ostream_ << ' ';
-    Visit(node->GetOper());
-    ostream_ << ' ';
-    Visit(node->GetRight());
-    ostream_ << ')';
 }
 
 void CodeGenerator::VisitOper(const shared_ptr<Oper> &node) {
@@ -358,22 +414,6 @@ void CodeGenerator::PrintfFormatString(const shared_ptr<FunctionCall> &node) {
     }
 
     vector<string> specifiers;
-    auto BaseCast = [&](const shared_ptr<ASTNode> &p) -> void {
-        if (auto dp = dynamic_pointer_cast<Num>(p)) {
-            specifiers.push_back("%d");
-        } else if (auto dp = dynamic_pointer_cast<Real>(p)) {
-            specifiers.push_back("%lf");
-        } else if (auto dp = dynamic_pointer_cast<String>(p)) {
-            specifiers.push_back("%s");
-        } else if (auto dp = dynamic_pointer_cast<Char>(p)) {
-            specifiers.push_back("%c");
-        } else if (auto dp = dynamic_pointer_cast<Bool>(p)) {
-            specifiers.push_back("%d");
-        } else {
-            specifiers.push_back("%s");
-        }
-    };
-
     auto CastByVarType = [&](const VarType vt) -> void {
         if (vt == VarType::INT)
             specifiers.push_back("%d");
@@ -389,22 +429,30 @@ void CodeGenerator::PrintfFormatString(const shared_ptr<FunctionCall> &node) {
             specifiers.push_back("%s");
     };
 
-    auto IVarCast = [&](const shared_ptr<IVar> &p) -> void {
-        CastByVarType(p->GetVarType());
-    };
-
-    auto FuncCallCast = [&](const shared_ptr<FunctionCall> &p) -> void {
-        CastByVarType(p->GetReturnType());
-    };
-
-    auto params = node->GetParameters();
-    for (auto &p : params) {
-        if (auto dp = dynamic_pointer_cast<IVar>(p))
-            IVarCast(dp);
-        else if (auto dp = dynamic_pointer_cast<FunctionCall>(p))
-            FuncCallCast(dp);
-        else
-            BaseCast(p);
+    for (const auto &p : node->GetParameters()) {
+        switch (p->GetKind()) {
+        case NodeKind::NUM:
+        case NodeKind::BOOL:
+            specifiers.push_back("%d");
+            break;
+        case NodeKind::REAL:
+            specifiers.push_back("%lf");
+            break;
+        case NodeKind::STRING:
+            specifiers.push_back("%s");
+            break;
+        case NodeKind::CHAR:
+            specifiers.push_back("%c");
+            break;
+        case NodeKind::FUNCTION_CALL:
+            CastByVarType(static_cast<const FunctionCall &>(*p).GetReturnType());
+            break;
+        default:
+            if (p->IsVar())
+                CastByVarType(static_cast<const IVar &>(*p).GetVarType());
+            else
+                specifiers.push_back("%s");
+        }
     }
     ostream_ << '"';
     for (auto &s : specifiers) {
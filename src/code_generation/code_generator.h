@@ -23,6 +23,17 @@ class CodeGenerator : Visitor {
     void Interpret(const shared_ptr<ASTRoot> &node);
     const string GetCCode() const;
 
+    // Generate a program one part at a time, in the order the parts appear
+    // in the source: the global declarations, every subprogram, then the
+    // main statements. The result is the same as Interpret on the whole
+    // program.
+    void InterpretGlobals(const shared_ptr<Declaration> &declarations);
+    void InterpretSubprogram(const shared_ptr<ASTNode> &subprogram);
+    void InterpretMain(const string &program_name,
+                       const shared_ptr<Compound> &statements);
+    // Return the C code generated so far and start over with an empty buffer
+    string TakeCCode();
+
   private:
     virtual void Visit(const shared_ptr<ASTNode> &node,
                        bool indent = false) override;
@@ -85,6 +96,15 @@ class CodeGenerator : Visitor {
 
     void PrintfFormatString(const shared_ptr<FunctionCall> &node);
 
+    // Write the includes every generated file starts with
+    void WriteIncludes();
+    // Write main() running statements
+    void WriteMain(const string &program_name,
+                   const shared_ptr<Compound> &statements);
+
+    // Write a binary or unary operation and all operations nested in it
+    void VisitOperation(const shared_ptr<ASTNode> &node);
+
     // Get current indent blank string based on current indent level
     const string Indent() const;
     // Increase indent level
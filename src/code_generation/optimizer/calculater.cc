@@ -21,12 +21,12 @@ ExprPtr Calculator::convertValueExpr(const ExprPtr& cur , const ExprPtr& origin)
 	case symbol_table::INT :
 		return std::make_shared<ast::IntegerValue>(
 			static_cast<int>(
-				std::static_pointer_cast<ast::RealValue>(cur)->value()));
+				ast::As<ast::RealValue>(*cur).value()));
 	
 	case symbol_table::CHAR :
 		return std::make_shared<ast::CharValue>(
 			static_cast<char>(
-				std::static_pointer_cast<ast::RealValue>(cur)->value()));
+				ast::As<ast::RealValue>(*cur).value()));
 
 	default:
 		return cur;
@@ -43,21 +43,23 @@ ExprPtr Calculator::convertValueExpr(const ExprPtr& cur , const ExprPtr& origin)
 // 		case '/' : return a / b;
 // 	};
 // }
-ResOfExpr Calculator::calcBinaryExpr(const std::shared_ptr<ast::BinaryExpr>& cur) {
-	auto [l_ptr , l_is_val] = calc(cur->lhs());
-	auto [r_ptr , r_is_val] = calc(cur->rhs());
+ResOfExpr Calculator::calcBinaryExpr(const ExprPtr& cur ,
+		ResOfExpr lhs , ResOfExpr rhs) {
+	const auto& bin_expr = ast::As<ast::BinaryExpr>(*cur);
+	auto [l_ptr , l_is_val] = std::move(lhs);
+	auto [r_ptr , r_is_val] = std::move(rhs);
 	
 	if ( !(l_is_val && r_is_val) ) {
-		if (l_is_val) l_ptr = convertValueExpr(l_ptr , cur->lhs());
-		if (r_is_val) r_ptr = convertValueExpr(r_ptr , cur->rhs());
+		if (l_is_val) l_ptr = convertValueExpr(l_ptr , bin_expr.lhs());
+		if (r_is_val) r_ptr = convertValueExpr(r_ptr , bin_expr.rhs());
 		return {
-			std::make_shared<ast::BinaryExpr>(cur->op() , l_ptr , r_ptr) , false};
+			std::make_shared<ast::BinaryExpr>(bin_expr.op() , l_ptr , r_ptr) , false};
 	}
 	
-	double l_val = std::static_pointer_cast<ast::RealValue>(l_ptr)->value();
-	double r_val = std::static_pointer_cast<ast::RealValue>(r_ptr)->value();
+	double l_val = ast::As<ast::RealValue>(*l_ptr).value();
+	double r_val = ast::As<ast::RealValue>(*r_ptr).value();
 
-	switch (cur->op()) {
+	switch (bin_expr.op()) {
 	case '+' : return {std::make_shared<ast::RealValue>(l_val + r_val) , true};
 	case '-' : return {std::make_shared<ast::RealValue>(l_val - r_val) , true};
 	case '*' : return {std::make_shared<ast::RealValue>(l_val * r_val) , true};
@@ -67,14 +69,15 @@ ResOfExpr Calculator::calcBinaryExpr(const std::shared_ptr<ast::BinaryExpr>& cur
 	return {cur , false};
 }
 
-ResOfExpr Calculator::calcUnaryExpr(const std::shared_ptr<ast::UnaryExpr>& cur ) {
-	auto [ptr  , is_val] = calc(cur->factor());
+ResOfExpr Calculator::calcUnaryExpr(const ast::UnaryExpr& cur ,
+		ResOfExpr factor) {
+	auto [ptr  , is_val] = std::move(factor);
 
 	if ( !is_val ) return {ptr  , false};
 
-	double val = std::static_pointer_cast<ast::RealValue>(ptr)->value();
+	double val = ast::As<ast::RealValue>(*ptr).value();
 
-	switch (cur->op()) {
+	switch (cur.op()) {
 	case '-' : return {std::make_shared<ast::RealValue>(-1 * val) , true};
 	}
 	
@@ -82,33 +85,64 @@ ResOfExpr Calculator::calcUnaryExpr(const std::shared_ptr<ast::UnaryExpr>& cur )
 }
 
 
-ResOfExpr Calculator::calc(const ExprPtr& cur) {
-
-	switch(cur->GetType()) {
-	case ast::ExprType::INT : 
-		return {std::make_shared<ast::RealValue>(
-			std::static_pointer_cast<ast::IntegerValue>(cur)->value()) , true};
-
-	case ast::ExprType::CHAR : 
-		return {std::make_shared<ast::RealValue>(
-			std::static_pointer_cast<ast::CharValue>(cur)->ch()) , true};	
-
-	case ast::ExprType::BOOLEAN :
-		return {std::make_shared<ast::RealValue>(
-			std::static_pointer_cast<ast::BooleanValue>(cur)->value()) , true};
-
-	case ast::ExprType::REAL :
-		return {cur , true};
-
-	case ast::ExprType::BINARY :
-		return calcBinaryExpr(std::static_pointer_cast<ast::BinaryExpr>(cur));
-
-	case ast::ExprType::UNARY :
-		return calcUnaryExpr(std::static_pointer_cast<ast::UnaryExpr>(cur));
+ResOfExpr Calculator::calcAtom(const ExprPtr& cur) {
+	// every overload is picked at compile time, the literals fold to a RealValue
+	return ast::Visit(*cur , [&cur](const auto& node) -> ResOfExpr {
+		using Node = std::decay_t<decltype(node)>;
+
+		if constexpr (std::is_same_v<Node , ast::IntegerValue> || std::is_same_v<Node , ast::BooleanValue>)
+			return {std::make_shared<ast::RealValue>(node.value()) , true};
+		else if constexpr (std::is_same_v<Node , ast::CharValue>)
+			return {std::make_shared<ast::RealValue>(node.ch()) , true};
+		else if constexpr (std::is_same_v<Node , ast::RealValue>)
+			return {cur , true};
+		else
+			return {cur , false};
+	});
+}
 
-	default :
-		return {cur , false};
+ResOfExpr Calculator::calc(const ExprPtr& cur) {
+	// operators are folded after their operands, the walk keeps its own
+	// stack so deeply nested expressions don't use up the call stack
+	struct Frame {
+		const ExprPtr* expr;
+		bool expanded;	// operands are already on the stack
+	};
+	std::vector<Frame> frames{{&cur , false}};
+	std::vector<ResOfExpr> results;
+
+	while (!frames.empty()) {
+		const ExprPtr& now = *frames.back().expr;
+
+		if (ast::IsA<ast::BinaryExpr>(*now)) {
+			auto bin_expr = &ast::As<ast::BinaryExpr>(*now);
+			if (!frames.back().expanded) {
+				frames.back().expanded = true;
+				frames.push_back({&bin_expr->rhs() , false});
+				frames.push_back({&bin_expr->lhs() , false});
+				continue;
+			}
+			auto rhs = std::move(results.back()); results.pop_back();
+			auto lhs = std::move(results.back()); results.pop_back();
+			results.push_back(calcBinaryExpr(now , std::move(lhs) , std::move(rhs)));
+
+		} else if (ast::IsA<ast::UnaryExpr>(*now)) {
+			auto expr = &ast::As<ast::UnaryExpr>(*now);
+			if (!frames.back().expanded) {
+				frames.back().expanded = true;
+				frames.push_back({&expr->factor() , false});
+				continue;
+			}
+			auto factor = std::move(results.back()); results.pop_back();
+			results.push_back(calcUnaryExpr(*expr , std::move(factor)));
+
+		} else {
+			results.push_back(calcAtom(now));
+		}
+		frames.pop_back();
 	}
+
+	return std::move(results.back());
 }
 
 
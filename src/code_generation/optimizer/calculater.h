@@ -21,8 +21,11 @@ public :
 
 private :
 	ResOfExpr calc(const ExprPtr& cur);
-	ResOfExpr calcBinaryExpr(const std::shared_ptr<ast::BinaryExpr>& cur);
-	ResOfExpr calcUnaryExpr(const std::shared_ptr<ast::UnaryExpr>& cur);
+	ResOfExpr calcAtom(const ExprPtr& cur);
+	ResOfExpr calcBinaryExpr(const ExprPtr& cur ,
+			ResOfExpr lhs , ResOfExpr rhs);
+	ResOfExpr calcUnaryExpr(const ast::UnaryExpr& cur ,
+			ResOfExpr factor);
 	ExprPtr	  convertValueExpr(const ExprPtr& cur , const ExprPtr& origin);
 
 
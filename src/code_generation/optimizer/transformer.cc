@@ -85,17 +85,7 @@ static auto make_shared_token(
 	}
 }
 
-static struct {
-	string func_line;
-	string func_name;
-	shared_ptr<ast::Subprogram> func_node;
-} las , now;
-
-static std::unordered_map <string , // Scope Line Number, Name
-		shared_ptr<ast::SubprogramHead>> func_name_table;
-
-
-static auto getParamRefs(const string& func_name) {
+std::bitset<k_max_parameters> Transformer::getParamRefs(const string& func_name) {
 	// TODO : override checker and cache
 	std::bitset<k_max_parameters> is_refs; is_refs.reset();
 	size_t idx = 0;
@@ -146,7 +136,7 @@ Transformer::checkIdType(const string& id) {
 
 	symbol_table::SymbolTableItem checker{
 		symbol_table::ERROR , 
-		id , true , true , 
+		analysiser::GetSymbols()->Find(id) , id , true , true , 
 		std::vector<symbol_table::SymbolTablePara>()};
 
 	auto ret 	 = sym_block->Query(checker);
@@ -158,7 +148,7 @@ Transformer::checkIdType(const string& id) {
 	if (ret != saERRORS::NO_ERROR) {
 		symbol_table::SymbolTableItem func_checker{
 			symbol_table::ERROR , 
-			id , false , true , 
+			analysiser::GetSymbols()->Find(id) , id , false , true , 
 			std::vector<symbol_table::SymbolTablePara>()};
 
 		is_func = sym_block->Query(func_checker) == saERRORS::NO_ERROR;
@@ -180,15 +170,14 @@ Transformer::checkArrayType(const string& id) {
 
 	symbol_table::SymbolTableItem checker{
 		symbol_table::MegaType(), 
-		id , true , true , 
+		analysiser::GetSymbols()->Find(id) , id , true , true , 
 		std::vector<symbol_table::SymbolTablePara>()};
 	auto ret 	 =  sym_block->Query(checker);
 
 	if (checker.type().pointer().size() == 0) return std::nullopt;
 
-	static string pattern{"\\d"};
-	static std::regex rgx{pattern};
-	static std::smatch results;
+	static const std::regex rgx{"\\d"};
+	std::smatch results;
 
 	vector<pair<int , int>> bounds;
 
@@ -209,7 +198,8 @@ Transformer::checkArrayType(const string& id) {
 	return make_pair(checker.type().type() ,  bounds);
 }
 
-Transformer::Transformer(shared_ptr<ast::Ast> root) {
+Transformer::Transformer(shared_ptr<ast::Ast> root, std::shared_ptr<const ast::LineTable> lines)
+	: lines(std::move(lines)) {
 	auto program_handle = std::dynamic_pointer_cast<ast::Program>(root);
 	if (program_handle == nullptr) {
 		throw std::runtime_error{"[Transformer] bad root pointer"};
@@ -219,9 +209,33 @@ Transformer::Transformer(shared_ptr<ast::Ast> root) {
 	ast_root = transProgram(program_handle);
 }
 
+Transformer::Transformer(const shared_ptr<ast::ProgramHead>& head, std::shared_ptr<const ast::LineTable> lines)
+	: lines(std::move(lines)) {
+	type_kit = make_shared<TypeToolKit>();
+	table = analysiser::GetTable();
+	now = {std::to_string(head->line(*this->lines)) , head->id() , nullptr};
+}
+
+shared_ptr<Declaration>
+Transformer::TransformGlobals(shared_ptr<ast::ProgramBody> body) {
+	return transDeclaration<ast::ProgramBody>(body);
+}
+
+shared_ptr<ASTNode>
+Transformer::TransformSubprogram(shared_ptr<ast::Subprogram> cur) {
+	return transSubprogram(cur);
+}
+
+shared_ptr<Compound>
+Transformer::TransformMain(shared_ptr<ast::ProgramBody> body) {
+	vector<std::shared_ptr<ASTNode>> child;
+	child.push_back(std::move(transStatement(*body->statements())));
+	return make_shared<Compound>(child);
+}
+
 shared_ptr<Program> Transformer::transProgram(shared_ptr<ast::Program> cur) {
 	now = {
-		std::to_string(cur->program_head()->line()) ,
+		std::to_string(cur->program_head()->line(*lines)) ,
 		cur->program_head()->id() ,
 		nullptr
 	};
@@ -235,7 +249,7 @@ shared_ptr<ASTNode>
 Transformer::transSubprogram(shared_ptr<ast::Subprogram> cur) {
 	las = now;
 	now = {
-		std::to_string(cur->subprogram_head()->line()) ,
+		std::to_string(cur->subprogram_head()->line(*lines)) ,
 		cur->subprogram_head()->id() ,
 		cur
 	};
@@ -296,9 +310,9 @@ Transformer::transBody(shared_ptr<T> body) {
 
 	vector<std::shared_ptr<ASTNode>> child;
 	if constexpr (std::is_same_v<T , ast::ProgramBody>) {
-		child.push_back(std::move(transStatement(body->statements())));
+		child.push_back(std::move(transStatement(*body->statements())));
 	} else {
-		child.push_back(std::move(transStatement(body->statement_list())));
+		child.push_back(std::move(transStatement(*body->statement_list())));
 	}
 
 
@@ -347,7 +361,7 @@ Transformer::transConstDeclaration(shared_ptr<ast::ConstDeclaration> cur) {
 		make_shared_token<ConstType>(
 			TokenType::RESERVED , ToCString(analysiser::GetExprType(cur->const_value()).type())
 		) ,
-		transExpression(cur->const_value())
+		transExpression(*cur->const_value())
 	);
 }
 
@@ -414,15 +428,78 @@ Transformer::transVarDeclaration(shared_ptr<ast::VarDeclaration> cur) {
 	STRING = 9,
 */
 pair<shared_ptr<ASTNode> , VarType>
-Transformer::passExpr(shared_ptr<ast::Expression> cur) {
+Transformer::passExpr(const ast::Expression& cur) {
+	// operators are built after their operands, the walk keeps its own
+	// stack so deeply nested expressions don't use up the call stack
+	struct Frame {
+		const ast::Expression* expr;
+		bool expanded;	// operands are already on the stack
+	};
+	vector<Frame> frames{{&cur , false}};
+	vector<pair<shared_ptr<ASTNode> , VarType>> results;
+
+	while (!frames.empty()) {
+		const auto& now = *frames.back().expr;
+
+		if (ast::IsA<ast::BinaryExpr>(now)) {
+			auto bin_expr = &ast::As<ast::BinaryExpr>(now);
+			if (!frames.back().expanded) {
+				frames.back().expanded = true;
+				frames.push_back({bin_expr->rhs().get() , false});
+				frames.push_back({bin_expr->lhs().get() , false});
+				continue;
+			}
+			auto r_expr = std::move(results.back()); results.pop_back();
+			auto l_expr = std::move(results.back()); results.pop_back();
+			auto expr_type = type_kit->MergeType(l_expr.second , r_expr.second , 
+								ToCString(bin_expr->op()));
+			results.push_back({
+				make_shared<BinaryOperation>(
+					l_expr.first ,
+					make_shared_token<Oper>(TokenType::OPERATOR , ToCString(bin_expr->op())) ,
+					r_expr.first ,
+					expr_type
+				) ,
+				expr_type
+			});
+
+		} else if (ast::IsA<ast::UnaryExpr>(now)) {
+			auto expr = &ast::As<ast::UnaryExpr>(now);
+			if (!frames.back().expanded) {
+				frames.back().expanded = true;
+				frames.push_back({expr->factor().get() , false});
+				continue;
+			}
+			auto factor = std::move(results.back()); results.pop_back();
+			auto type_info = type_kit->MergeType(VarType::CHAR , factor.second , ToCString(expr->op()));
+			results.push_back({
+				make_shared<UnaryOperation>(
+					make_shared_token<Oper> (TokenType::OPERATOR , ToCString(expr->op())) ,
+					factor.first ,
+					type_info
+				) ,
+				type_info
+			});
+
+		} else {
+			results.push_back(passAtom(now));
+		}
+		frames.pop_back();
+	}
+
+	return std::move(results.back());
+}
+
+pair<shared_ptr<ASTNode> , VarType>
+Transformer::passAtom(const ast::Expression& cur) {
 
-	switch (cur->GetType()) {
+	switch (cur.GetType()) {
 	case ast::ExprType::INT :
 		return {
 			make_shared_token<Num>(
 				TokenType::NUMBER ,
 				std::to_string(
-					std::static_pointer_cast<ast::IntegerValue>(cur)->value()
+					ast::As<ast::IntegerValue>(cur).value()
 			)) ,
 			VarType::INT
 		};
@@ -432,7 +509,7 @@ Transformer::passExpr(shared_ptr<ast::Expression> cur) {
 			make_shared_token<Real>(
 				TokenType::NUMBER ,
 				std::to_string(
-					std::static_pointer_cast<ast::RealValue>(cur)->value()
+					ast::As<ast::RealValue>(cur).value()
 				)
 			) ,
 			VarType::REAL
@@ -443,7 +520,7 @@ Transformer::passExpr(shared_ptr<ast::Expression> cur) {
 			make_shared_token<Char>(
 				TokenType::NUMBER ,
 				std::to_string(
-					std::static_pointer_cast<ast::CharValue>(cur)->ch()
+					ast::As<ast::CharValue>(cur).ch()
 				)
 			) ,
 			VarType::CHAR
@@ -453,7 +530,7 @@ Transformer::passExpr(shared_ptr<ast::Expression> cur) {
 		return {
 			make_shared_token<Bool>(
 				TokenType::NUMBER ,
-				std::static_pointer_cast<ast::BooleanValue>(cur)->value() ?
+				ast::As<ast::BooleanValue>(cur).value() ?
 				"1" : "0"
 			),
 			VarType::BOOL
@@ -463,22 +540,22 @@ Transformer::passExpr(shared_ptr<ast::Expression> cur) {
 		return {
 			make_shared_token<String>(
 				TokenType::STRING ,
-				std::static_pointer_cast<ast::StringValue>(cur)->value()
+				ast::As<ast::StringValue>(cur).value()
 			) ,
 			VarType::STRING
 		};
 		
 	case ast::ExprType::VARIABLE : {
-		auto var = std::static_pointer_cast<ast::Variable>(cur);
+		const auto& var = ast::As<ast::Variable>(cur);
 
-		auto [_1 , _2 , is_ref , is_ret , _5 , _type] = checkIdType(var->id());
+		auto [_1 , _2 , is_ref , is_ret , _5 , _type] = checkIdType(var.id());
 
-		if (var->expr_list().size() == 0) { // basic type
+		if (var.expr_list().size() == 0) { // basic type
 			auto var_type  = type_kit->StringToVarType(ToCString(_type));
 
 			return {
 				make_shared<Var>( 
-					var->id() , is_ref , is_ret ,
+					var.id() , is_ref , is_ret ,
 					var_type
 				) ,
 				var_type
@@ -486,18 +563,18 @@ Transformer::passExpr(shared_ptr<ast::Expression> cur) {
 
 		} else { // array type
 			vector<shared_ptr<ASTNode>> indices; 
-			indices.reserve(var->expr_list().size()); 
+			indices.reserve(var.expr_list().size()); 
 
-			for (const auto& elem : var->expr_list()) {
-				indices.push_back(std::move(passExpr(elem).first));
+			for (const auto& elem : var.expr_list()) {
+				indices.push_back(std::move(passExpr(*elem).first));
 			}
 
-			auto type_info = checkArrayType(var->id()).value();
+			auto type_info = checkArrayType(var.id()).value();
 			auto var_type  = type_kit->StringToVarType(ToCString(type_info.first));
 			return {
 				make_shared<ArrayAccess>(
 					make_shared<Array>(
-						make_shared<Var>( var->id() , is_ref ) ,
+						make_shared<Var>( var.id() , is_ref ) ,
 						std::move(type_info.second)
 					),
 					indices ,
@@ -508,76 +585,40 @@ Transformer::passExpr(shared_ptr<ast::Expression> cur) {
 	}
 	}
 
-	case ast::ExprType::UNARY : {
-		auto expr = std::static_pointer_cast<ast::UnaryExpr>(cur);
-		auto factor = passExpr( expr->factor() );
-		auto type_info = type_kit->MergeType(VarType::CHAR , factor.second , ToCString(expr->op()));
-		return {
-			make_shared<UnaryOperation>(
-				make_shared_token<Oper> (TokenType::OPERATOR , ToCString(expr->op())) ,
-				factor.first ,
-				type_info
-			) ,
-			type_info
-		};
-	}
-
-	case ast::ExprType::BINARY : {
-		auto bin_expr = std::static_pointer_cast<ast::BinaryExpr>(cur);
-
-		// std::cerr << "Get Type : " << checkExprType(bin_expr) << "\n";
-		auto l_expr = passExpr(bin_expr->lhs());
-		auto r_expr = passExpr(bin_expr->rhs());
-		// auto expr_type = Ma
-		auto expr_type = type_kit->MergeType(l_expr.second , r_expr.second , 
-							ToCString(bin_expr->op()));
-
-		// std::cerr << bin_expr->line() << " : " << bin_expr->column() << " -> " 
-					// << type_kit->VarTypeToString(expr_type) << "\n";
-
-		return {
-			make_shared<BinaryOperation>(
-				l_expr.first ,
-				make_shared_token<Oper>(TokenType::OPERATOR , ToCString(bin_expr->op())) ,
-				r_expr.first ,
-				expr_type
-			) ,
-			expr_type
-		};
-	}
-
 	case ast::ExprType::CALL : {
-		auto callee = std::static_pointer_cast<ast::CallValue>(cur);
-		vector<shared_ptr<ASTNode>> param; param.reserve(callee->params().size());
+		const auto& callee = ast::As<ast::CallValue>(cur);
+		vector<shared_ptr<ASTNode>> param; param.reserve(callee.params().size());
 
 		auto ret_type = type_kit->StringToVarType(ToCString(
-				func_name_table[callee->id()]->return_type()));
+				func_name_table[callee.id()]->return_type()));
 
-		for (const auto& elem : callee->params()) {
-			param.push_back(std::move(passExpr(elem).first));
+		for (const auto& elem : callee.params()) {
+			param.push_back(std::move(passExpr(*elem).first));
 		}
 
 		return {
-			make_shared<FunctionCall>( callee->id() , param , 
-				getParamRefs(callee->id()) , 
+			make_shared<FunctionCall>( callee.id() , param , 
+				getParamRefs(callee.id()) , 
 				ret_type) ,
 			ret_type
 		};
 	}
 
 	case ast::ExprType::CALL_OR_VAR : {
-		auto callval = std::static_pointer_cast<ast::CallOrVar>(cur);
-		auto [is_var , is_func , _ , is_ret , is_const , _6] = checkIdType(callval->id());
+		const auto& callval = ast::As<ast::CallOrVar>(cur);
+		auto [is_var , is_func , _ , is_ret , is_const , _6] = checkIdType(callval.id());
 		
 		if (is_func) {
-			return passExpr(make_shared<ast::CallValue>(
-				callval->line() , callval->column() , callval->id()));
+			return passExpr(ast::CallValue(
+				callval.offset() , callval.id()));
 		} else if (is_var || is_ret || is_const) { // const and include 'return' -> func := expr;
-			return passExpr(make_shared<ast::Variable>(
-				callval->line() , callval->column() , callval->id()));
+			return passExpr(ast::Variable(
+				callval.offset() , callval.id()));
 		}
 	}
 
+	default :
+		break;
 	}
 
 	throw std::runtime_error{"[Transformer] unknown expr type"};
@@ -588,10 +629,10 @@ Transformer::passExpr(shared_ptr<ast::Expression> cur) {
 
 
 shared_ptr<ASTNode>
-Transformer::transExpression(shared_ptr<ast::Expression> cur) {
+Transformer::transExpression(const ast::Expression& cur) {
 	// Optimizer::Calculator calc{cur};
 	// auto res = calc.getResultExpr();
-	// std::cerr << "Cur@" << cur->line() <<" : " << cur->column() <<"\n";
+	// std::cerr << "Cur@" << cur.line() <<" : " << cur.column() <<"\n";
 
 	return passExpr(cur).first;
 }
@@ -610,30 +651,30 @@ Transformer::transExpression(shared_ptr<ast::Expression> cur) {
     };
 */
 shared_ptr<ASTNode>
-Transformer::transStatement(shared_ptr<ast::Statement> cur) {
-	// std::cerr << "Cur@" << cur->line() <<" : " << cur->column() <<"\n";
-	switch (cur->GetType()) {
+Transformer::transStatement(const ast::Statement& cur) {
+	// std::cerr << "Cur@" << cur.line() <<" : " << cur.column() <<"\n";
+	switch (cur.GetType()) {
 
 	case ast::StatementType::ASSIGN_STATEMENT :
-		return transAssignStatement(std::static_pointer_cast<ast::AssignStatement>(cur));
+		return transAssignStatement(ast::As<ast::AssignStatement>(cur));
 
 	case ast::StatementType::CALL_STATEMENT : 
-		return transCallStatement(std::static_pointer_cast<ast::CallStatement>(cur));
+		return transCallStatement(ast::As<ast::CallStatement>(cur));
 
 	case ast::StatementType::COMPOUND_STATEMENT :
-		return transCompoundStatement(std::static_pointer_cast<ast::CompoundStatement>(cur));
+		return transCompoundStatement(ast::As<ast::CompoundStatement>(cur));
 	
 	case ast::StatementType::IF_STATEMENT :
-		return transIfStatement(std::static_pointer_cast<ast::IfStatement>(cur));
+		return transIfStatement(ast::As<ast::IfStatement>(cur));
 	
 	case ast::StatementType::FOR_STATEMENT :
-		return transForStatement(std::static_pointer_cast<ast::ForStatement>(cur));
+		return transForStatement(ast::As<ast::ForStatement>(cur));
 
 	case ast::StatementType::EXIT_STATEMENT :
-		return transExitStatement(std::static_pointer_cast<ast::ExitStatement>(cur));
+		return transExitStatement(ast::As<ast::ExitStatement>(cur));
 
 	case ast::StatementType::WHILE_STATEMENT : 
-		return transWhileStatement(std::static_pointer_cast<ast::WhileStatement>(cur));
+		return transWhileStatement(ast::As<ast::WhileStatement>(cur));
 	}
 
 	throw std::runtime_error{"[Transformer] unknown statement\n"};
@@ -641,49 +682,49 @@ Transformer::transStatement(shared_ptr<ast::Statement> cur) {
 }
 
 shared_ptr<Assignment> 
-Transformer::transAssignStatement(shared_ptr<ast::AssignStatement> cur) {
+Transformer::transAssignStatement(const ast::AssignStatement& cur) {
 	return make_shared<Assignment>(
-		transExpression(cur->var()) ,
-		transExpression(cur->expr())
+		transExpression(*cur.var()) ,
+		transExpression(*cur.expr())
 	);
 }
 
 shared_ptr<Statement>
-Transformer::transCallStatement(shared_ptr<ast::CallStatement> cur) {
-	vector<shared_ptr<ASTNode>> param; param.reserve(cur->expr_list().size());
+Transformer::transCallStatement(const ast::CallStatement& cur) {
+	vector<shared_ptr<ASTNode>> param; param.reserve(cur.expr_list().size());
 
-	for (const auto& elem : cur->expr_list()) {
-		param.push_back(std::move(transExpression(elem)));
+	for (const auto& elem : cur.expr_list()) {
+		param.push_back(std::move(transExpression(*elem)));
 	}
 
 	return make_shared<Statement>(
-		make_shared<FunctionCall>( cur->name() , param , getParamRefs(cur->name()))
+		make_shared<FunctionCall>( cur.name() , param , getParamRefs(cur.name()))
 	);
 }
 
 shared_ptr<Compound>
-Transformer::transCompoundStatement(shared_ptr<ast::CompoundStatement> cur) {
-	vector<shared_ptr<ASTNode>> states; states.reserve(cur->statements().size());
+Transformer::transCompoundStatement(const ast::CompoundStatement& cur) {
+	vector<shared_ptr<ASTNode>> states; states.reserve(cur.statements().size());
 
-	for(const auto& elem : cur->statements()) {
-		states.push_back(std::move(transStatement(elem)));
+	for(const auto& elem : cur.statements()) {
+		states.push_back(std::move(transStatement(*elem)));
 	}
 	
 	return make_shared<Compound>(states);
 }
 
 shared_ptr<IfStatement>
-Transformer::transIfStatement(shared_ptr<ast::IfStatement> cur) {
-	auto cond = transExpression(cur->condition());
-	vector<shared_ptr<ASTNode>> then_branch_ {std::move(transStatement(cur->then()))};
+Transformer::transIfStatement(const ast::IfStatement& cur) {
+	auto cond = transExpression(*cur.condition());
+	vector<shared_ptr<ASTNode>> then_branch_ {std::move(transStatement(*cur.then()))};
 
-	if (cur->else_part() == nullptr) {
+	if (cur.else_part() == nullptr) {
 		return make_shared<IfStatement>(cond , 
 		make_shared<Compound>(then_branch_)
 	 );
 	}
 
-    vector<shared_ptr<ASTNode>> else_branch_ {std::move(transStatement(cur->else_part()))};
+    vector<shared_ptr<ASTNode>> else_branch_ {std::move(transStatement(*cur.else_part()))};
 	return make_shared<IfStatement>(cond , 
 		make_shared<Compound>(then_branch_) ,
 		make_shared<Compound>(else_branch_)
@@ -691,20 +732,20 @@ Transformer::transIfStatement(shared_ptr<ast::IfStatement> cur) {
 }
 
 shared_ptr<ForStatement>	
-Transformer::transForStatement(shared_ptr<ast::ForStatement> cur) {
-	vector<shared_ptr<ASTNode>> body {std::move(transStatement(cur->statement()))};
-	auto from = transExpression(cur->from());
-	auto to   = transExpression(cur->to()  );
+Transformer::transForStatement(const ast::ForStatement& cur) {
+	vector<shared_ptr<ASTNode>> body {std::move(transStatement(*cur.statement()))};
+	auto from = transExpression(*cur.from());
+	auto to   = transExpression(*cur.to());
 
 	return make_shared<ForStatement>(
-		make_shared_token<Var>(TokenType::IDENTIFIER , cur->id()),
+		make_shared_token<Var>(TokenType::IDENTIFIER , cur.id()),
 		from , to ,
 		make_shared<Compound>(body)
 	);
 }
 
 shared_ptr<ExitStatement>
-Transformer::transExitStatement(shared_ptr<ast::ExitStatement> cur) {
+Transformer::transExitStatement(const ast::ExitStatement& cur) {
 	auto return_type = now.func_node->subprogram_head()->return_type();
 
 	if (return_type == -1) // void type
@@ -714,12 +755,12 @@ Transformer::transExitStatement(shared_ptr<ast::ExitStatement> cur) {
 }
 
 shared_ptr<WhileStatement>
-Transformer::transWhileStatement(shared_ptr<ast::WhileStatement> cur) {
+Transformer::transWhileStatement(const ast::WhileStatement& cur) {
 	return make_shared<WhileStatement>(
-		transExpression(cur->condition()) ,
+		transExpression(*cur.condition()) ,
 		make_shared<Compound>(
 			vector<shared_ptr<ASTNode>>
-			{transStatement( cur->statement() )}
+			{transStatement(*cur.statement())}
 		)
 	);
 }
@@ -11,17 +11,44 @@ namespace pascal2c::code_generation {
 class Transformer {
 public : 
     /**
+     * @param lines the line table given to analysiser::init, the scopes are named by line
      * @attention It need analysis::init() has been executed.
     */
-	explicit Transformer(std::shared_ptr<ast::Ast> root);
+	Transformer(std::shared_ptr<ast::Ast> root, std::shared_ptr<const ast::LineTable> lines);
     Transformer() = delete;
     auto GetASTRoot() const {return ast_root;}
 
+    /**
+     * @brief Lower a program one part at a time while it is parsed,
+     *        the parts must be handed over in source order after the
+     *        semantic analysis of each of them.
+     * @param lines the line table given to analysiser::init
+     * @attention It need analysis::init() has been executed.
+    */
+    Transformer(const shared_ptr<ast::ProgramHead>& head, std::shared_ptr<const ast::LineTable> lines);
+    // global const and var declarations
+    shared_ptr<Declaration> TransformGlobals(shared_ptr<ast::ProgramBody> body);
+    shared_ptr<ASTNode> TransformSubprogram(shared_ptr<ast::Subprogram> cur);
+    // statements of the main program
+    shared_ptr<Compound> TransformMain(shared_ptr<ast::ProgramBody> body);
+
 private :
+	struct Scope {
+		string func_line;
+		string func_name;
+		shared_ptr<ast::Subprogram> func_node;
+	};
+
 	std::shared_ptr<ASTRoot> ast_root;
     analysiser::nameTable* table; // TODO : singleton
+    std::shared_ptr<const ast::LineTable> lines; // of the source, turns node offsets into scope lines
     std::shared_ptr<symbol_table::SymbolTableBlock> sym_block;
     std::shared_ptr<TypeToolKit> type_kit;
+    Scope las , now; // enclosing and current subprogram
+    std::unordered_map <string , // Scope Line Number, Name
+        shared_ptr<ast::SubprogramHead>> func_name_table;
+
+    std::bitset<k_max_parameters> getParamRefs(const string& func_name);
 
     shared_ptr<Program> transProgram(shared_ptr<ast::Program> cur);
     shared_ptr<ASTNode>
@@ -43,28 +70,30 @@ private :
      * @brief Handle Expressions
     */
     shared_ptr<ASTNode>
-        transExpression(shared_ptr<ast::Expression> cur);
+        transExpression(const ast::Expression& cur);
+    std::pair<shared_ptr<ASTNode> , VarType>
+        passExpr(const ast::Expression& cur);
     std::pair<shared_ptr<ASTNode> , VarType>
-        passExpr(shared_ptr<ast::Expression> cur);
+        passAtom(const ast::Expression& cur);
     /**
      * @brief Handle Statements
     */
     shared_ptr<ASTNode>
-        transStatement(shared_ptr<ast::Statement> cur);
+        transStatement(const ast::Statement& cur);
     shared_ptr<Compound>
-        transCompoundStatement(shared_ptr<ast::CompoundStatement> cur);
+        transCompoundStatement(const ast::CompoundStatement& cur);
     shared_ptr<Assignment> 
-        transAssignStatement(shared_ptr<ast::AssignStatement> cur);
+        transAssignStatement(const ast::AssignStatement& cur);
     shared_ptr<Statement>
-        transCallStatement(shared_ptr<ast::CallStatement> cur);
+        transCallStatement(const ast::CallStatement& cur);
     shared_ptr<IfStatement>
-        transIfStatement(shared_ptr<ast::IfStatement> cur);
+        transIfStatement(const ast::IfStatement& cur);
     shared_ptr<ForStatement>
-        transForStatement(shared_ptr<ast::ForStatement> cur);
+        transForStatement(const ast::ForStatement& cur);
     shared_ptr<ExitStatement>
-        transExitStatement(shared_ptr<ast::ExitStatement> cur);
+        transExitStatement(const ast::ExitStatement& cur);
     shared_ptr<WhileStatement>
-        transWhileStatement(shared_ptr<ast::WhileStatement> cur);
+        transWhileStatement(const ast::WhileStatement& cur);
 
 
     std::tuple<bool ,bool , bool , bool , bool , symbol_table::ItemType>
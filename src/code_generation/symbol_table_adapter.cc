@@ -25,7 +25,8 @@ bool SymbolScope::IsReturnVar(const string &name) const {
 
 const shared_ptr<SymbolItem> SymbolScope::Lookup(const string &name) const {
     auto st_item = make_shared<symbol_table::SymbolTableItem>(
-        symbol_table::MegaType(), name, false, false,
+        symbol_table::MegaType(), analysiser::GetSymbols()->Find(name), name,
+        false, false,
         std::vector<symbol_table::SymbolTablePara>());
 
     auto err = symbol_table_block_->Query(*st_item);
@@ -0,0 +1,396 @@
+#include "driver/driver.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <variant>
+
+#include "driver/source_buffer.h"
+#include "ast/serialize.h"
+#include "code_generation/code_generator.h"
+#include "code_generation/optimizer/transformer.h"
+#include "parser/parser.h"
+#include "semantic_analysis/semantic_analysis.h"
+#include "thread_pool.hpp"
+#include "utils.hpp"
+
+namespace pascal2c::driver {
+
+using ErrorMsg = std::variant<pascal2c::parser::SyntaxErr, analysiser::errorMsg>;
+using Location = std::pair<int, int>;
+
+static void PrintError(std::ostream &out, const std::string &input_filename,
+                       const SourceBuffer &source,
+                       const std::string &module_name,
+                       int line, int col, const std::string &msg) {
+    const int context_num = 2;
+    int start = std::max(1, line - context_num);
+    int end = std::min(source.line_count(), line + context_num);
+
+    out << Colorize("Error (" + module_name + ") -> ", Color::Red) << input_filename
+        << ":" << line << ":" << col << std::endl;
+
+    int num_width = std::to_string(end).size();
+
+    for (int i = start; i <= end; ++i) {
+        std::string line_num = std::string(num_width - std::to_string(i).size(), ' ') + std::to_string(i);
+        out << Colorize(line_num + " | ", Color::Blue);
+        std::string_view text = source.Line(i);
+        if (i == line) {
+            out << text;
+            if (text.back() != '\n') {
+                out << std::endl;
+            }
+
+            int offset = num_width + 3 + col - 1;
+            out << std::string(offset, ' ');
+            out << Colorize("^", Color::Red);
+            out << ' ' << Colorize(msg, Color::Red);
+            out << std::endl;
+        } else {
+            out << text;
+        }
+    }
+    out << std::endl;
+}
+
+// print the syntax and semantic errors sorted by position
+// return:
+//     true if there are any
+static bool PrintErrors(std::ostream &out, const Job &job, const SourceBuffer &source,
+                        const std::vector<parser::SyntaxErr> &syntax_errs) {
+    std::map<Location, ErrorMsg> errors;
+    for (auto &err : syntax_errs) {
+        errors.insert({{err.line(), err.col()}, err});
+    }
+    for (auto &err : analysiser::GetErrors()) {
+        errors.insert({{err.line(), err.column()}, err});
+    }
+
+    for (auto &err : errors) {
+        auto [line, col] = err.first;
+        auto &msg = err.second;
+        if (auto *p = std::get_if<pascal2c::parser::SyntaxErr>(&msg)) {
+            PrintError(out, job.input, source, "Parser", line, col, p->err_msg());
+        } else if (auto *p = std::get_if<analysiser::errorMsg>(&msg)) {
+            PrintError(out, job.input, source, "Semantic", line, col, p->msg());
+        }
+    }
+    return !errors.empty();
+}
+
+// analyses, lowers and generates every part of a program as soon as the
+// parser hands it over, code is only generated while the program is free of
+// errors but the rest is still analysed for its diagnostics
+class StreamingCompiler : public parser::ProgramHandler {
+  public:
+    StreamingCompiler(const parser::Parser &parser, std::ostream &out) : parser_(parser), out_(out) {}
+
+    void OnProgramHead(const std::shared_ptr<ast::ProgramHead> &head) override {
+        analysiser::DoProgramHead(*head);
+        name_ = head->id();
+        transformer_ = std::make_unique<code_generation::Transformer>(head, parser_.line_table());
+    }
+
+    void OnGlobals(const std::shared_ptr<ast::ProgramBody> &body) override {
+        analysiser::DoProgramDeclarations(*body);
+        Generate([&] { generator_.InterpretGlobals(transformer_->TransformGlobals(body)); });
+    }
+
+    void OnSubprogram(std::shared_ptr<ast::Subprogram> subprogram) override {
+        analysiser::DoSubprogram(*subprogram);
+        Generate([&] { generator_.InterpretSubprogram(transformer_->TransformSubprogram(subprogram)); });
+    }
+
+    // analyse and generate the main statements once the parser is done
+    void Finish(const ast::Program &program) {
+        analysiser::DoProgramStatements(*program.program_body());
+        Generate([&] { generator_.InterpretMain(name_, transformer_->TransformMain(program.program_body())); });
+    }
+
+    // the message of the exception that stopped code generation, empty if none
+    const std::string &generator_error() const { return generator_error_; }
+
+  private:
+    template <typename Step>
+    void Generate(Step step) {
+        if (stopped_ || !parser_.syntax_errs().empty() || !analysiser::GetErrors().empty()) {
+            stopped_ = true;
+            return;
+        }
+        try {
+            step();
+            out_ << generator_.TakeCCode();
+        } catch (const std::exception &e) {
+            stopped_ = true;
+            generator_error_ = e.what();
+        }
+    }
+
+    const parser::Parser &parser_;
+    std::ostream &out_;
+    std::string name_;
+    std::unique_ptr<code_generation::Transformer> transformer_;
+    code_generation::CodeGenerator generator_;
+    bool stopped_ = false;
+    std::string generator_error_;
+};
+
+// return:
+//     the parser of job, it takes its tokens from a scanner thread if the job is pipelined
+static std::unique_ptr<parser::Parser> NewParser(const Job &job, const SourceBuffer &source) {
+    std::string_view text(source.data(), source.size());
+    if (job.pipeline) {
+        return std::make_unique<parser::Parser>(std::make_unique<parser::TokenQueue>(text));
+    }
+    auto parser = std::make_unique<parser::Parser>(std::make_shared<parser::TokenStream>(text, job.parse_threads));
+    parser->set_parse_threads(job.parse_threads);
+    return parser;
+}
+
+// parse the source of job
+// param:
+//     hash_cons shares the structurally equal expressions of each scope
+//     syntax_errs, line_table and symbols get the errors, the lines and the identifiers of the source
+// return:
+//     the program
+static std::shared_ptr<ast::Program> ParseSource(const Job &job, const SourceBuffer &source, bool hash_cons,
+                                                 std::vector<parser::SyntaxErr> &syntax_errs,
+                                                 std::shared_ptr<const ast::LineTable> &line_table,
+                                                 std::shared_ptr<const ast::Interner> &symbols) {
+    auto parser = NewParser(job, source);
+    parser->set_hash_cons(hash_cons);
+    auto program = parser->Parse();
+    syntax_errs = parser->syntax_errs();
+    line_table = parser->line_table();
+    symbols = parser->symbols();
+    return program;
+}
+
+// return:
+//     the path of the cache entry in dir for the source with key
+static std::string CachePath(const std::string &dir, const ast::CacheKey &key) {
+    char name[48];
+    snprintf(name, sizeof(name), "%016llx%016llx.ast", static_cast<unsigned long long>(key.digest[0]),
+             static_cast<unsigned long long>(key.digest[1]));
+    return (std::filesystem::path(dir) / name).string();
+}
+
+// param:
+//     symbols get the identifiers of the program
+// return:
+//     the program cached at path for the source with key, nullptr if there is
+//     none or it cannot be used, the source is parsed then
+static std::shared_ptr<ast::Program> LoadCached(const std::string &path, const ast::CacheKey &key,
+                                                ast::Interner &symbols) {
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(path, error)) {
+        return nullptr;
+    }
+    try {
+        // mapped, the loader reads the bytes in place
+        SourceBuffer entry(path);
+        if (!ast::CacheMatches(entry.text(), key)) {
+            return nullptr;
+        }
+        return ast::ReadProgram(entry.text(), symbols);
+    } catch (const std::exception &) {
+        return nullptr;
+    }
+}
+
+// write the cache entry of program to path, a failure only costs the next run a parse
+// the entry is written aside and renamed into place, so a job reading it at
+// the same time sees the old entry or the whole new one
+static void StoreCached(const std::string &path, const ast::Program &program, const ast::CacheKey &key) {
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+    std::string temp = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary);
+        out << ast::WriteProgram(program, key);
+        if (!out) {
+            out.close();
+            remove(temp.c_str());
+            return;
+        }
+    }
+    if (rename(temp.c_str(), path.c_str()) != 0) {
+        remove(temp.c_str());
+    }
+}
+
+static Result CompileStreaming(const Job &job, const SourceBuffer &source) {
+    Result result{job, false, ""};
+    std::stringstream diagnostics;
+    std::ofstream fout(job.output);
+
+    auto parser = NewParser(job, source);
+    analysiser::init(parser->line_table(), parser->symbols());
+    StreamingCompiler compiler(*parser, fout);
+    auto program = parser->Parse(compiler);
+    compiler.Finish(*program);
+
+    if (PrintErrors(diagnostics, job, source, parser->syntax_errs())) {
+        fout.close();
+        remove(job.output.c_str());
+        result.diagnostics = diagnostics.str();
+        return result;
+    }
+    if (!compiler.generator_error().empty()) {
+        fout.close();
+        remove(job.output.c_str());
+        result.diagnostics = Colorize("Error (Generator) -> ", Color::Red) + job.input + ": " +
+                             compiler.generator_error() + "\n";
+        return result;
+    }
+
+    fout << std::endl;
+    result.ok = static_cast<bool>(fout);
+    if (!result.ok) {
+        result.diagnostics = Colorize("Error -> ", Color::Red) + "cannot write " + job.output + "\n";
+    }
+    return result;
+}
+
+Result Compile(const Job &job) {
+    Result result{job, false, ""};
+    std::stringstream diagnostics;
+
+    // the file is read once, the scanner and the error printer share the bytes
+    std::unique_ptr<SourceBuffer> source;
+    try {
+        source = std::make_unique<SourceBuffer>(job.input);
+    } catch (const std::exception &e) {
+        result.diagnostics = Colorize("Error -> ", Color::Red) + e.what() + "\n";
+        return result;
+    }
+
+    if (job.stream) {
+        return CompileStreaming(job, *source);
+    }
+
+    // >>>>>> lexer & parser <<<<<<
+    std::shared_ptr<ast::Program> program;
+    std::vector<parser::SyntaxErr> syntax_errs;
+    std::shared_ptr<const ast::LineTable> line_table;
+    std::shared_ptr<const ast::Interner> symbols;
+    ast::CacheKey cache_key;
+    std::string cache_path;
+    if (!job.cache_dir.empty()) {
+        cache_key = ast::CacheKey::Of(source->text());
+        cache_path = CachePath(job.cache_dir, cache_key);
+        auto cached_symbols = std::make_shared<ast::Interner>();
+        program = LoadCached(cache_path, cache_key, *cached_symbols);
+        symbols = std::move(cached_symbols);
+    }
+    // a shared node has the place of its first occurrence only, see ast::ExprPool
+    bool shared = false;
+    if (program != nullptr) {
+        // only programs without syntax errors are cached, the source is needed for its lines
+        line_table = std::make_shared<const ast::LineTable>(source->text());
+        // the entry may have been written by a job sharing its expressions
+        shared = true;
+    } else {
+        program = ParseSource(job, *source, job.hash_cons, syntax_errs, line_table, symbols);
+        shared = job.hash_cons;
+        if (!cache_path.empty() && syntax_errs.empty()) {
+            StoreCached(cache_path, *program, cache_key);
+        }
+    }
+
+    // >>>>>> semantic analysis <<<<<<
+    // the nodes only keep offsets, the errors and scopes get their lines from the table
+    analysiser::init(line_table, symbols);
+    analysiser::DoProgram(*program);
+
+    // errors in shared nodes would all point at the first occurrence, so a program
+    // with errors is parsed again without sharing before they are printed
+    if (shared && (!syntax_errs.empty() || !analysiser::GetErrors().empty())) {
+        program = ParseSource(job, *source, false, syntax_errs, line_table, symbols);
+        analysiser::init(line_table, symbols);
+        analysiser::DoProgram(*program);
+    }
+
+    // print errors
+    if (PrintErrors(diagnostics, job, *source, syntax_errs)) {
+        remove(job.output.c_str());
+        result.diagnostics = diagnostics.str();
+        return result;
+    }
+
+    // >>>>>> code generation <<<<<<
+    try {
+        code_generation::Transformer trans(program, line_table);
+        auto cg_program = trans.GetASTRoot();
+
+        auto code_generator = code_generation::CodeGenerator();
+        code_generator.Interpret(cg_program);
+
+        std::ofstream fout(job.output);
+        fout << code_generator.GetCCode() << std::endl;
+        result.ok = static_cast<bool>(fout);
+        if (!result.ok) {
+            result.diagnostics = Colorize("Error -> ", Color::Red) + "cannot write " + job.output + "\n";
+        }
+    } catch (const std::exception &e) {
+        remove(job.output.c_str());
+        result.diagnostics = Colorize("Error (Generator) -> ", Color::Red) + job.input + ": " + e.what() + "\n";
+    }
+    return result;
+}
+
+std::vector<Result> CompileAll(const std::vector<Job> &jobs, size_t threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    if (threads > jobs.size()) threads = jobs.size();
+
+    std::vector<Result> results;
+    results.reserve(jobs.size());
+    if (threads <= 1) {
+        for (auto &job : jobs) results.push_back(Compile(job));
+        return results;
+    }
+
+    ThreadPool pool(threads);
+    std::vector<std::future<Result>> futures;
+    futures.reserve(jobs.size());
+    for (auto &job : jobs) {
+        futures.push_back(pool.Submit([&job] { return Compile(job); }));
+    }
+    for (auto &future : futures) results.push_back(future.get());
+    return results;
+}
+
+std::vector<Job> ReadManifest(const std::string &path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("cannot open manifest " + path);
+    }
+    std::vector<Job> jobs;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::stringstream fields(line);
+        Job job;
+        if (!(fields >> job.input) || job.input[0] == '#') continue;
+        if (!(fields >> job.output)) job.output = DefaultOutput(job.input);
+        jobs.push_back(std::move(job));
+    }
+    return jobs;
+}
+
+std::string DefaultOutput(const std::string &input) {
+    auto slash = input.find_last_of('/');
+    auto dot = input.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return input + ".c";
+    }
+    return input.substr(0, dot) + ".c";
+}
+
+}  // namespace pascal2c::driver
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace pascal2c::driver {
+
+// one input file and where its C code goes
+struct Job {
+    std::string input;
+    std::string output;
+    bool stream = false;     // analyse and generate each subprogram as soon as it is parsed
+    size_t parse_threads = 1; // threads scanning the file and parsing its subprograms,
+                              // 0 means one per hardware thread
+    bool pipeline = false;   // scan on a thread of its own while the parser takes the tokens,
+                             // parse_threads is not used then
+    std::string cache_dir;   // directory of parsed programs by source, a source parsed before is
+                             // loaded from there instead of parsed again, empty means no cache,
+                             // streamed jobs do not use it
+    bool hash_cons = false;  // share structurally equal expressions of a scope, see ast::ExprPool,
+                             // a file with errors is parsed again without sharing so they are
+                             // reported where they are, streamed jobs do not use it
+};
+
+// outcome of compiling one Job
+struct Result {
+    Job job;
+    bool ok = false;         // true if the C code has been written
+    std::string diagnostics; // errors formatted for the terminal, empty on success
+};
+
+// run lexer, parser, semantic analysis and code generation on one file
+// the compilation only touches state of the calling thread,
+// so different threads may compile different files at the same time
+// a streamed job hands every subprogram to the later stages as soon as it is
+// parsed and frees it once its C code is written, so the output starts early
+// and only the largest subprogram needs to be in memory at once
+// param:
+//     job is the file to compile
+// return:
+//     the result, the output file is removed if there are errors
+Result Compile(const Job &job);
+
+// compile every job on a pool of worker threads
+// param:
+//     jobs are the files to compile
+//     threads is the number of workers, 0 means one per hardware thread
+// return:
+//     the results in the order of jobs, whatever order they finish in
+std::vector<Result> CompileAll(const std::vector<Job> &jobs, size_t threads);
+
+// read a batch manifest, one job per line: <input_file> [output_file]
+// blank lines and lines starting with # are skipped
+// param:
+//     path is the manifest file
+// return:
+//     the jobs, a missing output defaults to the input with a .c extension
+// throw:
+//     std::runtime_error if the manifest cannot be read
+std::vector<Job> ReadManifest(const std::string &path);
+
+// param:
+//     input is a Pascal source file
+// return:
+//     the path of input with its extension replaced by .c
+std::string DefaultOutput(const std::string &input);
+
+}  // namespace pascal2c::driver
@@ -0,0 +1,68 @@
+#include "driver/source_buffer.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pascal2c::driver {
+
+SourceBuffer::SourceBuffer(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    struct stat st {};
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            data_ = static_cast<const char *>(p);
+            size_ = st.st_size;
+            mapped_ = true;
+        }
+    }
+    if (!mapped_) {
+        // pipes, empty files and file systems without mmap
+        char chunk[1 << 16];
+        ssize_t n;
+        while ((n = read(fd, chunk, sizeof(chunk))) > 0) {
+            fallback_.append(chunk, n);
+        }
+        if (n < 0) {
+            close(fd);
+            throw std::runtime_error("cannot read " + path);
+        }
+        data_ = fallback_.data();
+        size_ = fallback_.size();
+    }
+    close(fd);
+    IndexLines();
+}
+
+SourceBuffer::~SourceBuffer() {
+    if (mapped_) {
+        munmap(const_cast<char *>(data_), size_);
+    }
+}
+
+std::string_view SourceBuffer::Line(int line) const {
+    size_t begin = line_starts_[line - 1];
+    size_t end = line < line_count() ? line_starts_[line] : size_;
+    return {data_ + begin, end - begin};
+}
+
+void SourceBuffer::IndexLines() {
+    line_starts_.clear();
+    if (size_ == 0) return;
+    line_starts_.push_back(0);
+    const char *end = data_ + size_;
+    for (const char *p = data_; (p = static_cast<const char *>(memchr(p, '\n', end - p))) != nullptr;) {
+        ++p;
+        if (p == end) break;
+        line_starts_.push_back(p - data_);
+    }
+}
+
+}  // namespace pascal2c::driver
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pascal2c::driver {
+
+// the bytes of one source file, read from disk exactly once
+// the file is memory mapped when possible and read in one go otherwise,
+// the scanner runs over data() and diagnostics slice their context lines
+// out of it through the line index, so no per-line strings are made
+class SourceBuffer {
+public:
+    // param:
+    //     path is the file to load
+    // throw:
+    //     std::runtime_error if the file cannot be read
+    explicit SourceBuffer(const std::string &path);
+    ~SourceBuffer();
+
+    SourceBuffer(const SourceBuffer &) = delete;
+    SourceBuffer &operator=(const SourceBuffer &) = delete;
+
+    const char *data() const { return data_; }
+    size_t size() const { return size_; }
+    std::string_view text() const { return {data_, size_}; }
+
+    // return:
+    //     the number of lines, a last line without '\n' counts too
+    int line_count() const { return (int) line_starts_.size(); }
+
+    // param:
+    //     line is a 1-based line number, 1 <= line <= line_count()
+    // return:
+    //     the line including its '\n' if it has one
+    std::string_view Line(int line) const;
+
+private:
+    void IndexLines();
+
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;              // data_ is a mapping to unmap, not fallback_
+    std::string fallback_;             // the bytes when mapping is not possible
+    std::vector<size_t> line_starts_;  // offset of the first byte of every line
+};
+
+}  // namespace pascal2c::driver
@@ -1,8 +1,67 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include "lexer.h"
 
+static double Now(void) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/* scan the bytes of stdin from memory several times and print the best run,
+   reading the input and printing the tokens do not count */
+static int Speed(void) {
+    size_t len = 0, cap = 1 << 20;
+    char *bytes = malloc(cap);
+    size_t got;
+    while (bytes != NULL && (got = fread(bytes + len, 1, cap - len, stdin)) > 0) {
+        len += got;
+        if (len == cap) {
+            cap *= 2;
+            bytes = realloc(bytes, cap);
+        }
+    }
+    LexerState *lexer = LexerCreate();
+    if (bytes == NULL || lexer == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    const int runs = 10;
+    double best = 1e30;
+    long tokens = 0;
+    for (int i = 0; i < runs; i++) {
+        double begin = Now();
+        LexerSetBytes(lexer, bytes, len);
+        int token;
+        tokens = 0;
+        while ((token = LexerNext(lexer)) != 0) {
+            if (token == TOK_ERROR) {
+                fprintf(stderr, "%s at line %d, column %d\n", YYERRMSG[LexerErrno(lexer)],
+                        LexerLine(lexer), LexerColumn(lexer));
+                return 1;
+            }
+            tokens++;
+        }
+        double seconds = Now() - begin;
+        if (seconds < best) best = seconds;
+    }
+    printf("%zu bytes, %ld tokens, %.1f MB/s, %.1f Mtokens/s\n", len, tokens,
+           len / best / 1e6, tokens / best / 1e6);
+    LexerDestroy(lexer);
+    free(bytes);
+    return 0;
+}
+
+/* usage: lexer_exe < file.pas       prints the tokens
+          lexer_exe --speed < file.pas   prints the scanner throughput */
 int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--speed") == 0) {
+        return Speed();
+    }
     int token;
     while ((token = yylex()) != 0) {
         printf("%s(%d) at line %d, column %d.", TokenToString(token), token,
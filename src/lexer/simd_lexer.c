@@ -0,0 +1,555 @@
+/* hand-written scanner behind the LexerState interface of lexer.h, built
+   instead of the flex scanner of lexer.lex with the cmake option PASCAL2C_SIMD_LEXER
+
+   it returns the same tokens, values, texts, positions and error numbers as
+   the flex scanner, quirks included, but looks at a whole block of bytes at a
+   time to skip blanks, comments and string characters and to find the end of
+   identifiers and numbers, 16 bytes with SSE2 and 32 with AVX2 (-mavx2),
+   without either the bytes are looked at one by one */
+#define PASCAL2C_LEXER_INTERNAL
+#include "lexer.h"
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define LEXER_SIMD 1
+#define LEXER_BLOCK 32
+typedef __m256i Block;
+#define BlockLoad(p) _mm256_loadu_si256((const __m256i *) (p))
+#define BlockSet(c) _mm256_set1_epi8((char) (c))
+#define BlockEq(a, b) _mm256_cmpeq_epi8(a, b)
+#define BlockGt(a, b) _mm256_cmpgt_epi8(a, b)
+#define BlockOr(a, b) _mm256_or_si256(a, b)
+#define BlockAnd(a, b) _mm256_and_si256(a, b)
+#define BlockMask(a) ((uint32_t) _mm256_movemask_epi8(a))
+#define BlockAll 0xffffffffu /* BlockMask of a block that is all matches */
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define LEXER_SIMD 1
+#define LEXER_BLOCK 16
+typedef __m128i Block;
+#define BlockLoad(p) _mm_loadu_si128((const __m128i *) (p))
+#define BlockSet(c) _mm_set1_epi8((char) (c))
+#define BlockEq(a, b) _mm_cmpeq_epi8(a, b)
+#define BlockGt(a, b) _mm_cmpgt_epi8(a, b)
+#define BlockOr(a, b) _mm_or_si128(a, b)
+#define BlockAnd(a, b) _mm_and_si128(a, b)
+#define BlockMask(a) ((uint32_t) _mm_movemask_epi8(a))
+#define BlockAll 0xffffu
+#else
+#define LEXER_SIMD 0
+#define LEXER_BLOCK 16 /* only the size of the zero padding */
+#endif
+
+char* YYERRMSG[] = {
+    "No error",
+    "Illegal input",
+    "Unterminated string",
+    "EOF in comment",
+    "Integer too large"
+};
+
+/* everything a scan needs, the names follow the flex scanner */
+struct LexerState {
+    char *buf;          /* copy of the input, then LEXER_BLOCK zero bytes so a block
+                           loaded anywhere in the input stays inside the allocation */
+    size_t len;         /* bytes of input in buf */
+    size_t pos;         /* next byte to scan */
+    int from_bytes;     /* the input came from LexerSetBytes, not from a FILE */
+    size_t start;       /* the text of the last match, like yytext and yyleng */
+    size_t leng;
+    size_t str_open;    /* the string of the current token, from its opening quote up to */
+    size_t str_close;   /* str_close, str_open is SIZE_MAX for other tokens */
+    size_t hold_at;     /* the byte after a returned token is '\0' until the next scan, */
+    char hold;          /* like flex's yy_hold_char, this is the byte it replaced */
+    int lineno;         /* line of the next byte */
+    int colno;          /* column of the current token */
+    int colno_next;     /* column of the next byte */
+    int error;          /* ERR_* of the last TOK_ERROR, sticky like the old yyerrno */
+    union YYSTYPE lval; /* value of the current token */
+
+    /* string literals are built here, two buffers take turns so the value
+       of a string token survives while the parser looks one token ahead */
+    struct LexerString {
+        char *data;
+        size_t len, cap;
+    } str[2];
+    int str_cur;        /* the buffer of the string being scanned */
+};
+
+/* length of the run of blanks at p */
+static size_t LexerSpanBlanks(const char *p)
+{
+#if LEXER_SIMD
+    const Block space = BlockSet(' '), tab = BlockSet('\t');
+    for (size_t n = 0;; n += LEXER_BLOCK) {
+        Block v = BlockLoad(p + n);
+        uint32_t stop = BlockMask(BlockOr(BlockEq(v, space), BlockEq(v, tab))) ^ BlockAll;
+        if (stop) return n + __builtin_ctz(stop);
+    }
+#else
+    size_t n = 0;
+    while (p[n] == ' ' || p[n] == '\t') n++;
+    return n;
+#endif
+}
+
+/* length of the run of letters, digits and '_' at p, letters if digits_only is 0 */
+static size_t LexerSpanWord(const char *p, int digits_only)
+{
+#if LEXER_SIMD
+    const Block below_digit = BlockSet('0' - 1), above_digit = BlockSet('9' + 1);
+    const Block below_letter = BlockSet('a' - 1), above_letter = BlockSet('z' + 1);
+    const Block lower = BlockSet(0x20), underscore = BlockSet('_');
+    for (size_t n = 0;; n += LEXER_BLOCK) {
+        Block v = BlockLoad(p + n);
+        /* bytes above 0x7f are negative and fall below every range */
+        Block in = BlockAnd(BlockGt(v, below_digit), BlockGt(above_digit, v));
+        if (!digits_only) {
+            Block folded = BlockOr(v, lower);
+            in = BlockOr(in, BlockAnd(BlockGt(folded, below_letter), BlockGt(above_letter, folded)));
+            in = BlockOr(in, BlockEq(v, underscore));
+        }
+        uint32_t stop = BlockMask(in) ^ BlockAll;
+        if (stop) return n + __builtin_ctz(stop);
+    }
+#else
+    size_t n = 0;
+    for (;; n++) {
+        char c = p[n];
+        int letter = ((c | 0x20) >= 'a' && (c | 0x20) <= 'z') || c == '_';
+        if (!(c >= '0' && c <= '9') && (digits_only || !letter)) return n;
+    }
+#endif
+}
+
+/* offset of the first of the bytes a, b, c or '\0' from p on */
+static size_t LexerFind(const char *p, char a, char b, char c)
+{
+#if LEXER_SIMD
+    const Block va = BlockSet(a), vb = BlockSet(b), vc = BlockSet(c), zero = BlockSet(0);
+    for (size_t n = 0;; n += LEXER_BLOCK) {
+        Block v = BlockLoad(p + n);
+        uint32_t found = BlockMask(BlockOr(BlockOr(BlockEq(v, va), BlockEq(v, vb)),
+                                           BlockOr(BlockEq(v, vc), BlockEq(v, zero))));
+        if (found) return n + __builtin_ctz(found);
+    }
+#else
+    size_t n = 0;
+    while (p[n] != a && p[n] != b && p[n] != c && p[n] != '\0') n++;
+    return n;
+#endif
+}
+
+/* a match of n bytes at the current position, what flex's YY_USER_ACTION and
+   YY_DO_BEFORE_ACTION do for every rule */
+static void LexerMatch(LexerState *lexer, size_t n)
+{
+    lexer->colno = lexer->colno_next;
+    lexer->colno_next += (int) n;
+    lexer->start = lexer->pos;
+    lexer->leng = n;
+    lexer->pos += n;
+}
+
+/* return token with the text of the last match ended by a '\0' */
+static int LexerReturn(LexerState *lexer, int token)
+{
+    lexer->hold_at = lexer->start + lexer->leng;
+    lexer->hold = lexer->buf[lexer->hold_at];
+    lexer->buf[lexer->hold_at] = '\0';
+    return token;
+}
+
+/* flex points yytext at the end of the input when it meets it and leaves yyleng alone */
+static int LexerReturnAtEnd(LexerState *lexer, int token)
+{
+    lexer->pos = lexer->len;
+    lexer->start = lexer->len;
+    lexer->hold_at = lexer->len;
+    lexer->hold = '\0';
+    return token;
+}
+
+/* a string starts in the buffer the previous string did not use */
+static void LexerStrBegin(LexerState *lexer)
+{
+    lexer->str_cur ^= 1;
+    lexer->str[lexer->str_cur].len = 0;
+}
+
+/* the buffer doubles, a literal costs amortised O(1) per byte */
+static void LexerStrAppend(LexerState *lexer, const char *text, size_t len)
+{
+    struct LexerString *str = &lexer->str[lexer->str_cur];
+    if (str->len + len + 1 > str->cap) {
+        size_t cap = str->cap ? str->cap : 64;
+        while (cap < str->len + len + 1) cap *= 2;
+        char *data = realloc(str->data, cap);
+        if (data == NULL) {
+            fprintf(stderr, "out of memory in string literal\n");
+            exit(2);
+        }
+        str->data = data;
+        str->cap = cap;
+    }
+    memcpy(str->data + str->len, text, len);
+    str->len += len;
+}
+
+/* the value points into the buffer, valid until the next string but one */
+static void LexerStrEnd(LexerState *lexer)
+{
+    struct LexerString *str = &lexer->str[lexer->str_cur];
+    LexerStrAppend(lexer, "", 0);  /* an empty string still needs storage */
+    str->data[str->len] = '\0';
+    lexer->lval.strval = str->data;
+    lexer->lval.strsize = str->len;
+}
+
+/* skip a { } comment, the current byte is its '{'
+   return 0 when it is closed, TOK_ERROR when the input ends inside it */
+static int LexerComment(LexerState *lexer)
+{
+    const char *buf = lexer->buf;
+    int level = 1;
+    LexerMatch(lexer, 1);
+    while (level > 0) {
+        size_t n = LexerFind(buf + lexer->pos, '{', '}', '\n');
+        if (lexer->pos + n >= lexer->len) n = lexer->len - lexer->pos;
+        if (n > 0) {
+            /* flex matches the other bytes one by one, the last of them counts */
+            lexer->colno = lexer->colno_next + (int) n - 1;
+            lexer->colno_next += (int) n;
+            lexer->start = lexer->pos + n - 1;
+            lexer->leng = 1;
+            lexer->pos += n;
+        }
+        if (lexer->pos >= lexer->len) {
+            lexer->error = ERR_EOF_IN_COMMENT;
+            return LexerReturnAtEnd(lexer, TOK_ERROR);
+        }
+        char c = buf[lexer->pos];
+        if (c == '\0') {
+            LexerMatch(lexer, 1);  /* a zero byte inside the input */
+        } else if (c == '\n') {
+            LexerMatch(lexer, 1);
+            lexer->colno_next = 1;
+            lexer->lineno++;
+        } else {
+            LexerMatch(lexer, 1);
+            level += c == '{' ? 1 : -1;
+        }
+    }
+    return 0;
+}
+
+/* scan a string literal, the current byte is its opening quote */
+static int LexerString(LexerState *lexer)
+{
+    const char *buf = lexer->buf;
+    lexer->str_open = lexer->pos;
+    LexerMatch(lexer, 1);
+    int str_start_col = lexer->colno;
+    LexerStrBegin(lexer);
+    for (;;) {
+        /* the characters up to a backslash, quote or newline are one match */
+        size_t n = 0;
+        while (lexer->pos + n < lexer->len) {
+            n += LexerFind(buf + lexer->pos + n, '\\', '\'', '\n');
+            if (lexer->pos + n >= lexer->len || buf[lexer->pos + n] != '\0') break;
+            n++;
+        }
+        if (lexer->pos + n > lexer->len) n = lexer->len - lexer->pos;
+        if (n > 0) {
+            LexerMatch(lexer, n);
+            lexer->colno = str_start_col;
+            LexerStrAppend(lexer, buf + lexer->start, n);
+        }
+        if (lexer->pos >= lexer->len) {
+            lexer->str_close = lexer->len;
+            lexer->error = ERR_UNTERMINATED_STRING;
+            return LexerReturnAtEnd(lexer, TOK_ERROR);
+        }
+
+        char c = buf[lexer->pos];
+        if (c == '\'') {
+            LexerMatch(lexer, 1);
+            lexer->colno = str_start_col;
+            lexer->str_close = lexer->pos;
+            LexerStrEnd(lexer);
+            return LexerReturn(lexer, TOK_STRING);
+        }
+        if (c == '\n') {
+            LexerMatch(lexer, 1);
+            lexer->colno = str_start_col;
+            lexer->colno_next = 1;
+            lexer->lineno++;
+            lexer->str_close = lexer->start;
+            lexer->error = ERR_UNTERMINATED_STRING;
+            return LexerReturn(lexer, TOK_ERROR);
+        }
+        /* a backslash escapes the next byte, \' is a quote, the others keep the backslash */
+        if (lexer->pos + 1 < lexer->len && buf[lexer->pos + 1] != '\n') {
+            LexerMatch(lexer, 2);
+            lexer->colno = str_start_col;
+            if (buf[lexer->start + 1] == '\'') {
+                LexerStrAppend(lexer, "'", 1);
+            } else {
+                LexerStrAppend(lexer, buf + lexer->start, 2);
+            }
+        } else {
+            /* no rule takes a backslash before a newline or the end, flex's
+               default rule echoes it, here it is dropped */
+            LexerMatch(lexer, 1);
+        }
+    }
+}
+
+/* scan a number or a token starting with '.', the current byte is a digit or '.'
+   a real needs one more byte after it that is not a '.', like the trailing
+   context {real}/[^\.] of the flex rule, and is cut short to get one */
+static int LexerNumber(LexerState *lexer)
+{
+    const char *p = lexer->buf + lexer->pos;
+    size_t end = lexer->len - lexer->pos;  /* bytes left in the input */
+    size_t int_digits = LexerSpanWord(p, 1);
+    size_t real = 0;                       /* length of the real, 0 if there is none */
+
+#define LEXER_REAL_ENDS_AT(n) ((n) < end && p[n] != '.')
+    if (p[int_digits] == '.' && int_digits < end) {
+        size_t frac = int_digits + 1;
+        size_t frac_digits = LexerSpanWord(p + frac, 1);
+        size_t exp = frac + frac_digits;
+        if (int_digits + frac_digits > 0 && p[exp] == 'e' && exp < end) {
+            size_t exp_digit = exp + 1 + (p[exp + 1] == '+' || p[exp + 1] == '-');
+            size_t exp_digits = LexerSpanWord(p + exp_digit, 1);
+            if (exp_digits > 0 && LEXER_REAL_ENDS_AT(exp_digit + exp_digits)) {
+                real = exp_digit + exp_digits;
+            } else if (exp_digits > 1) {
+                real = exp_digit + exp_digits - 1;
+            }
+        }
+        if (real == 0 && int_digits + frac_digits > 0) {
+            if (LEXER_REAL_ENDS_AT(exp)) {
+                real = exp;
+            } else if (frac_digits > (int_digits ? 0 : 1)) {
+                real = exp - 1;
+            }
+        }
+    }
+#undef LEXER_REAL_ENDS_AT
+
+    if (real > 0) {
+        LexerMatch(lexer, real);
+        LexerReturn(lexer, TOK_REAL);
+        lexer->lval.realval = strtod(lexer->buf + lexer->start, NULL);
+        return TOK_REAL;
+    }
+    if (int_digits > 0) {
+        LexerMatch(lexer, int_digits);
+        LexerReturn(lexer, TOK_INTEGER);
+        if (int_digits > MAX_INT_LEN) {
+            lexer->error = ERR_INTEGER_TOO_LARGE;
+            return TOK_ERROR;
+        }
+        unsigned long int n = strtoul(lexer->buf + lexer->start, NULL, 10);
+        if (n > INT_MAX) {
+            lexer->error = ERR_INTEGER_TOO_LARGE;
+            return TOK_ERROR;
+        }
+        lexer->lval.intval = n;
+        return TOK_INTEGER;
+    }
+    if (p[1] == '.' && end > 1) {
+        LexerMatch(lexer, 2);
+        return LexerReturn(lexer, TOK_DOTDOT);
+    }
+    LexerMatch(lexer, 1);
+    return LexerReturn(lexer, '.');
+}
+
+LexerState *LexerCreate(void)
+{
+    LexerState *lexer = calloc(1, sizeof(LexerState));
+    if (lexer == NULL) return NULL;
+    lexer->lineno = 1;
+    lexer->colno = 1;
+    lexer->colno_next = 1;
+    return lexer;
+}
+
+void LexerDestroy(LexerState *lexer)
+{
+    if (lexer == NULL) return;
+    free(lexer->buf);
+    free(lexer->str[0].data);
+    free(lexer->str[1].data);
+    free(lexer);
+}
+
+/* start over on a new input of len bytes, copied from bytes if it is not NULL,
+   the string buffers are kept for reuse */
+static void LexerReset(LexerState *lexer, const char *bytes, size_t len)
+{
+    char *buf = malloc(len + LEXER_BLOCK);
+    if (buf == NULL) {
+        fprintf(stderr, "out of memory for the input\n");
+        exit(2);
+    }
+    if (bytes != NULL) memcpy(buf, bytes, len);
+    memset(buf + len, 0, LEXER_BLOCK);
+    free(lexer->buf);
+    lexer->buf = buf;
+    lexer->len = len;
+    lexer->pos = 0;
+    lexer->start = 0;
+    lexer->leng = 0;
+    lexer->str_open = SIZE_MAX;
+    lexer->hold_at = len;
+    lexer->hold = '\0';
+    lexer->lineno = 1;
+    lexer->colno = 1;
+    lexer->colno_next = 1;
+    lexer->error = 0;
+    memset(&lexer->lval, 0, sizeof(lexer->lval));
+}
+
+void LexerSetInput(LexerState *lexer, FILE *in)
+{
+    /* the whole file is read up front, the blocks need it in memory */
+    size_t len = 0, cap = 1 << 16;
+    char *bytes = malloc(cap);
+    size_t n;
+    while (bytes != NULL && (n = fread(bytes + len, 1, cap - len, in)) > 0) {
+        len += n;
+        if (len == cap) {
+            cap *= 2;
+            char *grown = realloc(bytes, cap);
+            if (grown == NULL) free(bytes);
+            bytes = grown;
+        }
+    }
+    if (bytes == NULL) {
+        fprintf(stderr, "out of memory for the input\n");
+        exit(2);
+    }
+    LexerReset(lexer, bytes, len);
+    free(bytes);
+    lexer->from_bytes = 0;
+}
+
+void LexerSetBytes(LexerState *lexer, const char *bytes, size_t len)
+{
+    LexerReset(lexer, bytes, len);
+    lexer->from_bytes = 1;
+}
+
+int LexerNext(LexerState *lexer)
+{
+    if (lexer->buf == NULL) LexerSetInput(lexer, stdin);
+    char *buf = lexer->buf;
+    buf[lexer->hold_at] = lexer->hold;
+    lexer->str_open = SIZE_MAX;
+
+    while (lexer->pos < lexer->len) {
+        const char *p = buf + lexer->pos;
+        unsigned char c = (unsigned char) *p;
+        switch (c) {
+            case ' ':
+            case '\t':
+                LexerMatch(lexer, LexerSpanBlanks(p));
+                continue;
+            case '\n':
+                LexerMatch(lexer, 1);
+                lexer->colno_next = 1;
+                lexer->lineno++;
+                continue;
+            case '{':
+                if (LexerComment(lexer) == TOK_ERROR) return TOK_ERROR;
+                continue;
+            case '\'':
+                return LexerString(lexer);
+            case '<':
+                LexerMatch(lexer, p[1] == '>' || p[1] == '=' ? 2 : 1);
+                return LexerReturn(lexer, lexer->leng == 1 ? '<' : p[1] == '>' ? TOK_NEQOP : TOK_LEOP);
+            case '>':
+                LexerMatch(lexer, p[1] == '=' ? 2 : 1);
+                return LexerReturn(lexer, lexer->leng == 1 ? '>' : TOK_GEOP);
+            case ':':
+                LexerMatch(lexer, p[1] == '=' ? 2 : 1);
+                return LexerReturn(lexer, lexer->leng == 1 ? ':' : TOK_ASSIGNOP);
+            case '+': case '-': case '*': case '/': case '=': case '[': case ']':
+            case ',': case ';': case '^': case '(': case ')':
+                LexerMatch(lexer, 1);
+                return LexerReturn(lexer, c);
+            default:
+                break;
+        }
+
+        if (c == '.' || (c >= '0' && c <= '9')) return LexerNumber(lexer);
+        if (((c | 0x20) >= 'a' && (c | 0x20) <= 'z') || c == '_') {
+            /* keywords are no separate rules, one table lookup classifies the word */
+            LexerMatch(lexer, LexerSpanWord(p, 0));
+            int token = KeywordToken(buf + lexer->start, lexer->leng);
+            if (token == TOK_ID) {
+                /* identifiers are case-insensitive, the rest of the compiler sees them lowercased */
+                for (size_t i = lexer->start; i < lexer->start + lexer->leng; i++) {
+                    if (buf[i] >= 'A' && buf[i] <= 'Z') buf[i] += 'a' - 'A';
+                }
+            }
+            return LexerReturn(lexer, token);
+        }
+        LexerMatch(lexer, 1);
+        lexer->error = ERR_ILLEGAL_INPUT;
+        return LexerReturn(lexer, TOK_ERROR);
+    }
+    return LexerReturnAtEnd(lexer, 0);
+}
+
+const union YYSTYPE *LexerValue(const LexerState *lexer)
+{
+    return &lexer->lval;
+}
+
+const char *LexerText(const LexerState *lexer)
+{
+    return lexer->buf ? lexer->buf + lexer->start : "";
+}
+
+const char *LexerBytes(const LexerState *lexer)
+{
+    return lexer->from_bytes ? lexer->buf : NULL;
+}
+
+/* the last match of a string token is its closing quote, the token text is the whole literal */
+size_t LexerOffset(const LexerState *lexer)
+{
+    if (!lexer->from_bytes) return 0;
+    return lexer->str_open != SIZE_MAX ? lexer->str_open : lexer->start;
+}
+
+size_t LexerLength(const LexerState *lexer)
+{
+    if (lexer->from_bytes && lexer->str_open != SIZE_MAX) return lexer->str_close - lexer->str_open;
+    return lexer->leng;
+}
+
+int LexerLine(const LexerState *lexer)
+{
+    return lexer->lineno;
+}
+
+int LexerColumn(const LexerState *lexer)
+{
+    return lexer->colno;
+}
+
+int LexerErrno(const LexerState *lexer)
+{
+    return lexer->error;
+}
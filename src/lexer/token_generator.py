@@ -1,3 +1,5 @@
+import random
+
 tok_list = [
     'ID', 'INTEGER', 'REAL', 'STRING', 'ERROR',
     # KEYWORDS
@@ -7,6 +9,13 @@ tok_list = [
     'NEQOP', 'LEOP', 'GEOP', 'ASSIGNOP', 'DOTDOT','EXIT'
 ]
 
+# reserved words and the token each one is scanned as, matched case-insensitively
+keywords = [(tok.lower(), tok) for tok in tok_list[tok_list.index('AND'):tok_list.index('WITH') + 1]] + [
+    ('exit', 'EXIT'),
+    ('integer', 'INTEGER_TYPE'), ('real', 'REAL_TYPE'), ('boolean', 'BOOLEAN_TYPE'),
+    ('char', 'CHAR_TYPE'), ('string', 'STRING_TYPE'), ('true', 'TRUE'), ('false', 'FALSE'),
+]
+
 PREFIX = 'TOK_'
 START = 257
 FILE = 'lexer.h'
@@ -15,32 +24,128 @@ OTHER_CONTENT = '''#pragma once
 #include <stdint.h>
 #include <stdio.h>
 
-#define MAX_STR_LEN 256
 #define MAX_INT_LEN 10
 
 union YYSTYPE {
     uint32_t intval;
     double realval;
-    char strval[MAX_STR_LEN];
+    struct {
+        const char *strval; /* owned by the lexer, valid until the next string but one */
+        size_t strsize;     /* length of strval without the terminating '\\0' */
+    };
 };
 
-int yylex();
 char* TokenToString(int token);
+extern char* YYERRMSG[];
+
+/* error numbers of LexerErrno */
+#define ERR_NO_ERROR 0
+#define ERR_ILLEGAL_INPUT 1
+#define ERR_UNTERMINATED_STRING 2
+#define ERR_EOF_IN_COMMENT 3
+#define ERR_INTEGER_TOO_LARGE 4
+
+/* reentrant scanner, every LexerState scans its own input */
+typedef struct LexerState LexerState;
+
+/* return a scanner reading stdin, NULL if out of memory */
+LexerState *LexerCreate(void);
+void LexerDestroy(LexerState *lexer);
+/* restart the scanner on in, line and column start over at 1 */
+void LexerSetInput(LexerState *lexer, FILE *in);
+/* restart the scanner on the len bytes at bytes, no file I/O involved */
+void LexerSetBytes(LexerState *lexer, const char *bytes, size_t len);
+/* scan the next token, 0 at the end of the input */
+int LexerNext(LexerState *lexer);
+/* value, text and position of the token LexerNext returned last */
+const union YYSTYPE *LexerValue(const LexerState *lexer);
+const char *LexerText(const LexerState *lexer);
+/* the scanner's copy of the LexerSetBytes input, NULL when scanning a FILE,
+   it stays put until the next LexerSetBytes and identifiers in it are lowercased */
+const char *LexerBytes(const LexerState *lexer);
+/* offset of the token text in LexerBytes and its length in bytes,
+   the text of a string token runs from its opening quote through its closing one */
+size_t LexerOffset(const LexerState *lexer);
+size_t LexerLength(const LexerState *lexer);
+int LexerLine(const LexerState *lexer);
+int LexerColumn(const LexerState *lexer);
+/* error number of the last TOK_ERROR, index into YYERRMSG */
+int LexerErrno(const LexerState *lexer);
+
+#ifndef PASCAL2C_LEXER_INTERNAL
+/* one shared scanner behind the classic flex globals, not thread safe */
+int yylex();
 void yyreset(FILE *in);
 extern int yylineno;
 extern int yycolno;
-extern int yycolno_next;
 extern int yyerrno;
-extern char* YYERRMSG[];
 extern char* yytext;
 extern FILE *yyin;
 extern union YYSTYPE yylval;
 
 inline void SetInput(FILE *fp){yyin = fp;}
+#endif
+
 
 '''
 
+# the scanner matches every word with one identifier rule and looks it up here,
+# the hash only reads the length and the first, second and last letter, the
+# multipliers are searched until no two keywords share a slot
+HASH_SIZE = 128
+KEYWORD_MIN_LEN = min(len(word) for word, _ in keywords)
+KEYWORD_MAX_LEN = max(len(word) for word, _ in keywords)
+
+
+def keyword_hash(word, k):
+    h = len(word) * k[0] + ord(word[0]) * k[1] + ord(word[1]) * k[2] + ord(word[-1]) * k[3]
+    return (h >> 4) & (HASH_SIZE - 1)
+
+
+def find_keyword_hash():
+    rnd = random.Random(0)  # fixed seed, the same header on every build
+    while True:
+        k = tuple(rnd.randrange(1, 1 << 12) for _ in range(4))
+        if len({keyword_hash(word, k) for word, _ in keywords}) == len(keywords):
+            return k
+
+
+def keyword_table():
+    k = find_keyword_hash()
+    slots = sorted((keyword_hash(word, k), word, tok) for word, tok in keywords)
+    entries = ''.join(f'    [{h}] = {{"{word}", {len(word)}, {PREFIX}{tok}}},\n' for h, word, tok in slots)
+    return f'''
+#ifdef PASCAL2C_LEXER_INTERNAL
+/* perfect hash of the reserved words, generated by token_generator.py */
+static const struct {{
+    const char *word;
+    size_t len;
+    int token;
+}} KEYWORDS[{HASH_SIZE}] = {{
+{entries}}};
+
+/* return the keyword token of the len bytes at text, TOK_ID if it is no keyword,
+   letters are compared ignoring case, text is not modified */
+static inline int KeywordToken(const char *text, size_t len)
+{{
+    if (len < {KEYWORD_MIN_LEN} || len > {KEYWORD_MAX_LEN}) return {PREFIX}ID;
+    /* | 0x20 lowercases letters and maps digits and '_' onto no letter */
+    size_t h = (len * {k[0]}u + (text[0] | 0x20) * {k[1]}u + (text[1] | 0x20) * {k[2]}u
+                + (text[len - 1] | 0x20) * {k[3]}u) >> 4 & {HASH_SIZE - 1};
+    if (KEYWORDS[h].len != len) return {PREFIX}ID;
+    for (size_t i = 0; i < len; i++) {{
+        if ((text[i] | 0x20) != KEYWORDS[h].word[i]) return {PREFIX}ID;
+    }}
+    return KEYWORDS[h].token;
+}}
+#endif
+'''
+
+
 with open(FILE, 'w') as f:
     f.write(OTHER_CONTENT)
     for i, tok in enumerate(tok_list, START):
         f.write(f'#define {PREFIX}{tok} {i}\n')
+    f.write(f'/* the largest token id, ascii tokens are below {START} */\n')
+    f.write(f'#define {PREFIX}MAX {START + len(tok_list) - 1}\n')
+    f.write(keyword_table())
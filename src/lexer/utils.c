@@ -3,14 +3,40 @@
 
 #define TOK_EOF 0
 
+/* the classic flex interface, kept for lexer_exe and lexer_test */
+int yylineno = 1;
+int yycolno = 1;
+int yyerrno = 0;
+char* yytext = "";
+FILE* yyin = NULL;
+union YYSTYPE yylval;
+
+static LexerState* shared_lexer = NULL;
+static FILE* shared_in = NULL;
+
 void yyreset(FILE* in) {
+    if (shared_lexer == NULL) shared_lexer = LexerCreate();
+    LexerSetInput(shared_lexer, in);
+    shared_in = in;
     yylineno = 1;
     yycolno = 1;
-    yycolno_next = 1;
     yyerrno = 0;
     yyin = in;
 }
 
+int yylex() {
+    /* like flex, no input set means stdin */
+    if (yyin == NULL) yyin = stdin;
+    if (shared_lexer == NULL || yyin != shared_in) yyreset(yyin);
+    int token = LexerNext(shared_lexer);
+    yylval = *LexerValue(shared_lexer);
+    yytext = (char*) LexerText(shared_lexer);
+    yylineno = LexerLine(shared_lexer);
+    yycolno = LexerColumn(shared_lexer);
+    yyerrno = LexerErrno(shared_lexer);
+    return token;
+}
+
 char* TokenToString(int token) {
     static char *tokenNames[] = {
         [TOK_ID] = "'id'",
@@ -81,6 +107,7 @@ char* TokenToString(int token) {
         [TOK_GEOP] = "'>='",
         [TOK_ASSIGNOP] = "':='",
         [TOK_DOTDOT] = "'..'",
+        [TOK_EXIT] = "'exit'",
         [TOK_EOF] = "end of file",
     };
     return tokenNames[token];
@@ -1,122 +1,109 @@
+#include <cstdlib>
 #include <iostream>
-#include <fstream>
-#include <stdio.h>
-#include <map>
-#include "parser/parser.h"
-#include "semantic_analysis/semantic_analysis.h"
-#include "utils.hpp"
-#include "code_generation/optimizer/transformer.h"
-#include "code_generation/code_generator.h"
-
+#include <string>
+#include <utility>
+#include <vector>
+#include "driver/driver.h"
 
 using namespace pascal2c;
 
-std::string input_filename;
-using ErrorMsg = std::variant<pascal2c::parser::SyntaxErr, analysiser::errorMsg>;
-using Location = std::pair<int, int>;
-std::map<Location, ErrorMsg> errors;
-
-void PrintError(const std::vector<std::string> &lines,
-                std::string module_name,
-                int line, int col, const std::string &msg) {
-    const int context_num = 2;
-    int start = std::max(1, line - context_num);
-    int end = std::min((int) lines.size(), line + context_num);
-
-    std::cerr << Colorize("Error (" + module_name + ") -> ", Color::Red) << input_filename
-              << ":" << line << ":" << col << std::endl;
-
-    int num_width = std::to_string(end).size();
-
-    for (int i = start; i <= end; ++i) {
-        std::string line_num = std::string(num_width - std::to_string(i).size(), ' ') + std::to_string(i);
-        std::cerr << Colorize(line_num + " | ", Color::Blue);
-        if (i == line) {
-            std::cerr << lines[i - 1];
-            if (lines[i - 1].back() != '\n') {
-                std::cerr << std::endl;
-            }
-
-            int offset = num_width + 3 + col - 1;
-            std::cerr << std::string(offset, ' ');
-            std::cerr << Colorize("^", Color::Red);
-            std::cerr << ' ' << Colorize(msg, Color::Red);
-            std::cerr << std::endl;
-        } else {
-            std::cerr << lines[i - 1];
-        }
-    }
-    std::cerr << std::endl;
+static void Usage(const char *argv0) {
+    std::cerr << "Usage: " << argv0 << " [--stream] [--pipeline] [--cache <dir>] [--hash-cons] <input_file> [output_file]"
+              << std::endl
+              << "       " << argv0 << " --batch [-j <threads>] [--stream] [--pipeline] [--cache <dir>] [--hash-cons] <input_file>..."
+              << std::endl
+              << "       " << argv0
+              << " --batch [-j <threads>] [--stream] [--pipeline] [--cache <dir>] [--hash-cons] --manifest <manifest_file>"
+              << std::endl
+              << "--stream generates each subprogram as soon as it is parsed" << std::endl
+              << "--pipeline scans each file on a thread of its own while it is parsed" << std::endl
+              << "--cache keeps the parsed programs in <dir> and loads an unchanged file from there" << std::endl
+              << "--hash-cons shares the structurally equal expressions of each scope" << std::endl;
 }
 
-
 int main(int argc, char *argv[]) {
-    if (argc < 2 || argc > 3) {
-        std::cerr << "Usage: " << argv[0] << " <input_file> [output_file]" << std::endl;
+    if (argc < 2) {
+        Usage(argv[0]);
         return 0;
     }
 
-    input_filename = argv[1];
-    std::string output_filename = argc == 3 ? argv[2] : "a.c";
-    FILE *finp = fopen(input_filename.c_str(), "r");
-    std::ofstream fout(output_filename);
-
-    // read all lines
-    std::vector<std::string> lines;
-    size_t max_len = 1024;
-    char buf[max_len];
-    char *p = buf;
-    int ret;
-    while (getline(&p, &max_len, finp) != -1) {
-        lines.push_back(buf);
-    }
-    // reset finp
-    fseek(finp, 0, SEEK_SET);
-
-    // >>>>>> lexer & parser <<<<<<
-    parser::Parser parser(finp);
-    auto program = parser.Parse();
-
-    auto parser_errs = parser.syntax_errs();
-    for (auto &err : parser_errs) {
-        errors.insert({{err.line(), err.col()}, err});
-    }
-
-    // >>>>>> semantic analysis <<<<<<
-    analysiser::init();
-    analysiser::DoProgram(*program);
-
-    auto analysis_errs = analysiser::GetErrors();
-    for (auto &err : analysis_errs) {
-        errors.insert({{err.line(), err.column()}, err});
-    }
-
-    bool has_error = false;
-    // print errors
-    for (auto &err : errors) {
-        has_error = true;
-        auto [line, col] = err.first;
-        auto msg = err.second;
-        if (auto *p = std::get_if<pascal2c::parser::SyntaxErr>(&msg)) {
-            PrintError(lines, "Parser", line, col, p->err_msg());
-        } else if (auto *p = std::get_if<analysiser::errorMsg>(&msg)) {
-            PrintError(lines, "Semantic", line, col, p->msg());
+    std::vector<driver::Job> jobs;
+    size_t threads = 0;
+    bool stream = false;
+    bool pipeline = false;
+    std::string cache_dir;
+    bool hash_cons = false;
+    bool batch = std::string(argv[1]) == "--batch";
+    if (batch) {
+        // batch mode: every input goes to <input>.c unless the manifest says otherwise
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "-j" && i + 1 < argc) {
+                threads = std::strtoul(argv[++i], nullptr, 10);
+            } else if (arg == "--stream") {
+                stream = true;
+            } else if (arg == "--pipeline") {
+                pipeline = true;
+            } else if (arg == "--cache" && i + 1 < argc) {
+                cache_dir = argv[++i];
+            } else if (arg == "--hash-cons") {
+                hash_cons = true;
+            } else if (arg == "--manifest" && i + 1 < argc) {
+                try {
+                    auto manifest = driver::ReadManifest(argv[++i]);
+                    jobs.insert(jobs.end(), manifest.begin(), manifest.end());
+                } catch (const std::exception &e) {
+                    std::cerr << e.what() << std::endl;
+                    return 1;
+                }
+            } else {
+                driver::Job job;
+                job.input = arg;
+                job.output = driver::DefaultOutput(arg);
+                jobs.push_back(std::move(job));
+            }
+        }
+    } else {
+        int first = 1;
+        for (; first < argc; first++) {
+            std::string arg = argv[first];
+            if (arg == "--stream") {
+                stream = true;
+            } else if (arg == "--pipeline") {
+                pipeline = true;
+            } else if (arg == "--cache" && first + 1 < argc) {
+                cache_dir = argv[++first];
+            } else if (arg == "--hash-cons") {
+                hash_cons = true;
+            } else {
+                break;
+            }
+        }
+        if (argc <= first || argc > first + 2) {
+            Usage(argv[0]);
+            return 0;
         }
+        driver::Job job;
+        job.input = argv[first];
+        job.output = argc == first + 2 ? argv[first + 1] : "a.c";
+        // a single file gets the threads to itself, the lexer and the parser split it up among them
+        job.parse_threads = 0;
+        jobs.push_back(std::move(job));
+        threads = 1;
     }
-
-    if (has_error) {
-        remove(output_filename.c_str());
-        return 0;
+    for (auto &job : jobs) {
+        job.stream = stream;
+        job.pipeline = pipeline;
+        job.cache_dir = cache_dir;
+        job.hash_cons = hash_cons;
     }
 
-    code_generation::Transformer trans(program);
-    auto cg_program = trans.GetASTRoot();
-
-    auto code_generator = code_generation::CodeGenerator();
-
-    code_generator.Interpret(cg_program);
-
-    fout << code_generator.GetCCode() << std::endl;
-
-    return 0;
+    // results come back in input order so the diagnostics are deterministic
+    int failed = 0;
+    for (auto &result : driver::CompileAll(jobs, threads)) {
+        std::cerr << result.diagnostics;
+        if (!result.ok) failed++;
+    }
+    // a single compilation always exits with 0 like it used to
+    return batch && failed ? 1 : 0;
 }
@@ -1,72 +1,68 @@
 //
 // Created by 谢卫凯 on 2023/3/22.
 //
-#include <unordered_map>
 #include "parser.h"
 #include "ast/expr.h"
 
 namespace pascal2c::parser {
 
-    static std::unordered_map<int, int> binary_prec = {
-            {'=', 1},
-            {TOK_NEQOP, 1},
-            {'<', 1},
-            {TOK_LEOP, 1},
-            {'>', 1},
-            {TOK_GEOP, 1},
-            {'+', 2},
-            {'-', 2},
-            {TOK_OR, 2},
-            {TOK_AND, 3},
-            {TOK_DIV, 3},
-            {'*', 3},
-            {'/', 3},
-            {TOK_MOD, 3},
-    };
-
-    static std::unordered_map<int, int> unary_prec = {
-            {TOK_NOT, 4},
-            {'+', 4},
-            {'-', 4},
-    };
+    // unary operators bind tighter than every binary operator, ParseExpr
+    // applies them as soon as their operand is complete
+    static constexpr int kUnaryPrec = 4;
 
-    std::shared_ptr<ast::Expression> Parser::ParsePrimary(){
-        INIT_PARSE(line_, column_);
-        if(prefix_parser_[token_] == nullptr) {
-            throw SyntaxErr("syntax error: parse expression error: no expected token", line_, column_);
-        }
-        auto expr = std::move((this->*prefix_parser_[token_])());
-        expr->SetLineAndColumn(begin_line,begin_column);
-        return std::move(expr);
-    }
+    // one entry per token id, what is not listed is neither an operator nor
+    // the start of an expression, except '(' which ParseExpr handles itself
+    const std::array<Parser::Operator, TokenSet::kCapacity> Parser::kOperators = [] {
+        std::array<Operator, TokenSet::kCapacity> ops{};
 
-    std::shared_ptr<ast::Expression> Parser::ParseParen(){
-        Match('(');
-        auto expr = ParseExpr();
-        Match(')');
-        return std::move(expr);
-    }
+        ops[TOK_ID].prefix = &Parser::ParseVariableAndCall;
+        ops[TOK_INTEGER].prefix = &Parser::ParseNumber;
+        ops[TOK_REAL].prefix = &Parser::ParseNumber;
+        ops[TOK_STRING].prefix = &Parser::ParseStringAndChar;
+        ops[TOK_TRUE].prefix = &Parser::ParseBoolean;
+        ops[TOK_FALSE].prefix = &Parser::ParseBoolean;
 
-    // a := 3 * (4 + 6  ;
-    // if ....
+        auto unary = [&ops](int prec, std::initializer_list<int> tokens) {
+            for (int op : tokens)
+                ops[op].unary_prec = prec;
+        };
+        auto binary = [&ops](int prec, std::initializer_list<int> tokens) {
+            for (int op : tokens)
+                ops[op].binary_prec = prec;
+        };
+        unary(kUnaryPrec, {TOK_NOT, '+', '-'});
+        binary(1, {'=', TOK_NEQOP, '<', TOK_LEOP, '>', TOK_GEOP});
+        binary(2, {'+', '-', TOK_OR});
+        binary(3, {TOK_AND, TOK_DIV, '*', '/', TOK_MOD});
+        return ops;
+    }();
 
-    std::shared_ptr<ast::Expression> Parser::ParsePrefix(){
-        int op = token_;
-        int prec = unary_prec[op];
-        NextToken();
-        auto expr = ParseExpr(prec + 1);
+    std::shared_ptr<ast::Expression> Parser::ParsePrimary(){
+        // no binary operator binds as tight as this, so only one operand is read
+        return ParseExpr(kUnaryPrec + 1);
+    }
 
-        return std::move(std::make_shared<ast::UnaryExpr>(op,expr));
+    std::shared_ptr<ast::Expression> Parser::ParseAtom(){
+        PrefixParser prefix = kOperators[token_.kind].prefix;
+        if(prefix == nullptr) {
+            Fail("syntax error: parse expression error: no expected token");
+            return nullptr;
+        }
+        auto expr = std::move((this->*prefix)());
+        if(failed_)
+            return nullptr;
+        return std::move(expr);
     }
 
     std::shared_ptr<ast::Expression> Parser::ParseNumber() {
+        INIT_PARSE(token_.offset);
         std::shared_ptr<ast::Expression> expr;
-        switch (token_) {
+        switch (token_.kind) {
             case TOK_INTEGER:
-                expr = std::make_shared<ast::IntegerValue>(tok_value_.intval);
+                expr = MAKE_EXPR(ast::IntegerValue, Value().intval);
                 break;
             case TOK_REAL:
-                expr = std::make_shared<ast::RealValue>(tok_value_.realval);
+                expr = MAKE_EXPR(ast::RealValue, Value().realval);
                 break;
             default:
                 break;
@@ -76,48 +72,54 @@ namespace pascal2c::parser {
     }
 
     std::shared_ptr<ast::Expression> Parser::ParseStringAndChar() {
-        size_t len = strlen(tok_value_.strval);
+        INIT_PARSE(token_.offset);
         std::shared_ptr<ast::Expression> res;
-        if(len == 1)
-            res = std::move(std::make_shared<ast::CharValue>(tok_value_.strval[0]));
+        std::string_view value = StringValue();
+        if(value.size() == 1)
+            res = std::move(MAKE_EXPR(ast::CharValue, value[0]));
         else
-            res = std::move(std::make_shared<ast::StringValue>(tok_value_.strval));
+            res = std::move(MAKE_EXPR(ast::StringValue, std::string(value)));
         NextToken();
         return std::move(res);
     }
 
     std::shared_ptr<ast::Expression> Parser::ParseBoolean() {
+        INIT_PARSE(token_.offset);
         std::shared_ptr<ast::Expression> res;
-        if(token_ == TOK_TRUE)
-            res = std::move(std::make_shared<ast::BooleanValue>(true));
+        if(token_.kind == TOK_TRUE)
+            res = std::move(MAKE_EXPR(ast::BooleanValue, true));
         else
-            res = std::move(std::make_shared<ast::BooleanValue>(false));
+            res = std::move(MAKE_EXPR(ast::BooleanValue, false));
         NextToken();
         return std::move(res);
     }
 
     std::shared_ptr<ast::Expression> Parser::ParseVariableAndCall(){
-        std::string id = text_;
+        INIT_PARSE(token_.offset);
+        std::string id(Text());
+        ast::SymbolId symbol = token_.payload;
         NextToken();
         vector<std::shared_ptr<ast::Expression> > expr_list;
-        switch (token_) {
+        switch (token_.kind) {
             case '(':
                 NextToken();
-                if(token_ == ')'){
+                if(token_.kind == ')'){
                     NextToken();
-                    return std::move(std::make_shared<ast::CallValue>(id));
+                    return std::move(MAKE_SHARED(ast::CallValue, id, symbol));
                 } else {
                     expr_list = ParseExprList();
-                    Match(')');
-                    return std::move(std::make_shared<ast::CallValue>(id,expr_list));
+                    if(failed_ || !Match(')'))
+                        return nullptr;
+                    return std::move(MAKE_SHARED(ast::CallValue, id, symbol, expr_list));
                 }
             case '[':
                 NextToken();
                 expr_list = ParseExprList();
-                Match(']');
-                return std::move(std::make_shared<ast::Variable>(id,expr_list));
+                if(failed_ || !Match(']'))
+                    return nullptr;
+                return std::move(MAKE_EXPR(ast::Variable, id, symbol, expr_list));
             default:
-                return std::move(std::make_shared<ast::CallOrVar>(id));
+                return std::move(MAKE_EXPR(ast::CallOrVar, id, symbol));
         }
     }
 
@@ -126,19 +128,89 @@ namespace pascal2c::parser {
     }
 
     std::shared_ptr<ast::Expression> Parser::ParseExpr(int prec) {
-        auto lhs = ParsePrimary();
-        int op = token_;
-        int precedence = binary_prec[op];
-        while(precedence >= prec){
+        // this call owns the stack entries above the bases, they are dropped
+        // again when it returns early on a syntax error
+        struct Frame {
+            Parser &parser;
+            size_t operands, operators;
+            ~Frame() {
+                parser.operand_stack_.resize(operands);
+                parser.operator_stack_.resize(operators);
+            }
+        } frame{*this, operand_stack_.size(), operator_stack_.size()};
+        int open_parens = 0; // '(' of this call on operator_stack_, inside them every binary operator is taken
+
+        while(true){
+            // an operand: unary operators and '(' up to a literal, a variable or a call
+            while(token_.kind == '(' || kOperators[token_.kind].unary_prec != 0){
+                operator_stack_.push_back({token_.kind, true, token_.offset});
+                open_parens += token_.kind == '(';
+                NextToken();
+            }
+            operand_stack_.push_back(ParseAtom());
+            if(failed_)
+                return nullptr;
+
+            // apply the unary operators before the operand and close the parentheses after it
+            while(true){
+                while(operator_stack_.size() > frame.operators && operator_stack_.back().prefix &&
+                      operator_stack_.back().op != '(')
+                    ReduceUnary();
+                if(token_.kind != ')' || open_parens == 0)
+                    break;
+                while(!operator_stack_.back().prefix)
+                    ReduceBinary();
+                // the parenthesized expression starts at the '(', a shared one stays where it was first seen
+                if(!hash_cons_)
+                    operand_stack_.back()->SetOffset(operator_stack_.back().offset);
+                operator_stack_.pop_back();
+                open_parens--;
+                NextToken();
+                if(failed_)
+                    return nullptr;
+            }
+
+            int op = token_.kind;
+            int precedence = kOperators[op].binary_prec;
+            if(precedence == 0 || (open_parens == 0 && precedence < prec)){
+                if(open_parens > 0){
+                    Match(')'); // reports the missing ')'
+                    return nullptr;
+                }
+                break;
+            }
+            // operators binding at least as tight as op have both operands now
+            while(operator_stack_.size() > frame.operators && !operator_stack_.back().prefix){
+                const Operator &top = kOperators[operator_stack_.back().op];
+                if(top.binary_prec < precedence || (top.binary_prec == precedence && top.right_assoc))
+                    break;
+                ReduceBinary();
+            }
+            operator_stack_.push_back({op, false, 0});
             NextToken();
-            auto rhs = ParseExpr(precedence + 1);
-            int tmp_line = lhs->line(), tmp_column = lhs->column();
-            lhs = std::make_shared<ast::BinaryExpr>(op,lhs,rhs);
-            lhs->SetLineAndColumn(tmp_line, tmp_column);
-            op = token_;
-            precedence = binary_prec[op];
         }
-        return std::move(lhs);
+        while(operator_stack_.size() > frame.operators)
+            ReduceBinary();
+
+        auto expr = std::move(operand_stack_.back());
+        operand_stack_.pop_back();
+        return expr;
+    }
+
+    void Parser::ReduceBinary() {
+        int op = operator_stack_.back().op;
+        operator_stack_.pop_back();
+        auto rhs = std::move(operand_stack_.back());
+        operand_stack_.pop_back();
+        auto &lhs = operand_stack_.back();
+        lhs = NewExpr<ast::BinaryExpr>(lhs->offset(),op,lhs,rhs);
+    }
+
+    void Parser::ReduceUnary() {
+        PendingOperator op = operator_stack_.back();
+        operator_stack_.pop_back();
+        auto &factor = operand_stack_.back();
+        factor = NewExpr<ast::UnaryExpr>(op.offset,op.op,factor);
     }
 
     vector<std::shared_ptr<ast::Expression> > Parser::ParseExprList() {
@@ -146,8 +218,10 @@ namespace pascal2c::parser {
         vector<std::shared_ptr<ast::Expression> > res;
         while(true){
             expr = ParseExpr();
+            if(!expr)
+                break; // the caller sees the pending error
             res.push_back(std::move(expr));
-            if(token_ == ',')
+            if(token_.kind == ',')
                 NextToken();
             else
                 break;
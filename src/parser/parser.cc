@@ -3,9 +3,7 @@
 #include <sstream>
 #include <memory>
 #include <vector>
-#include <set>
 #include <cstdio>
-#include <exception>
 
 #include "parser.h"
 
@@ -16,142 +14,202 @@ extern "C" {
 namespace pascal2c::parser
 {
 
-    Parser::Parser(FILE *in)
+    // return:
+    //     everything left in the file
+    static std::string ReadAll(FILE *in)
     {
-        for (auto &i : prefix_parser_)
-            i = nullptr;
+        std::string source;
+        char chunk[1 << 16];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0)
+            source.append(chunk, n);
+        return source;
+    }
 
-        prefix_parser_[TOK_ID] = &Parser::ParseVariableAndCall;
-        prefix_parser_[TOK_INTEGER] = &Parser::ParseNumber;
-        prefix_parser_[TOK_REAL] = &Parser::ParseNumber;
+    // return:
+    //     the name of token for the error messages, empty if it has none
+    static const char *TokenName(int token)
+    {
+        const char *name = TokenToString(token);
+        return name ? name : "";
+    }
 
-        prefix_parser_['+'] = &Parser::ParsePrefix;
-        prefix_parser_['-'] = &Parser::ParsePrefix;
-        prefix_parser_[TOK_NOT] = &Parser::ParsePrefix;
+    Parser::Parser(FILE *in) : tokens_(std::make_shared<TokenStream>(ReadAll(in)))
+    {
+        Start();
+    }
 
-        prefix_parser_['('] = &Parser::ParseParen;
-        prefix_parser_[TOK_STRING] = &Parser::ParseStringAndChar;
-        prefix_parser_[TOK_TRUE] = &Parser::ParseBoolean;
-        prefix_parser_[TOK_FALSE] = &Parser::ParseBoolean;
+    Parser::Parser(const char *source, size_t size)
+        : tokens_(std::make_shared<TokenStream>(std::string_view(source, size)))
+    {
+        Start();
+    }
 
-        yyreset(in);  // reset input file
+    Parser::Parser(std::shared_ptr<const TokenStream> tokens, size_t pos)
+        : tokens_(std::move(tokens)), pos_(pos)
+    {
+        Start();
+    }
 
-        next_token_ = yylex();
-        next_tok_value_ = yylval;
-        next_line_ = yylineno;
-        next_column_ = yycolno;
-        next_text_ = yytext;
+    Parser::Parser(std::unique_ptr<TokenQueue> queue) : queue_(std::move(queue))
+    {
+        Start();
+    }
 
-        NextToken();
+    void Parser::Start()
+    {
+        // most inputs have no error at all, a bad one rarely has more than this
+        syntax_errs_.reserve(64);
+        err_msg_.reserve(64);
+
+        if (queue_)
+        {
+            queue_->Next();
+            token_ = queue_->token();
+        }
+        else
+            token_ = (*tokens_)[pos_];
+        line_table_ = queue_ ? queue_->line_table() : tokens_->line_table();
+        symbols_ = queue_ ? queue_->symbols() : tokens_->symbols();
+        if(token_.kind == TOK_ERROR) {
+            Fail(GetLexerErrMsg());
+        }
     }
 
     int Parser::NextToken()
     {
-        token_ = next_token_;
-        tok_value_ = next_tok_value_;
-        line_ = next_line_;
-        column_ = next_column_;
-        text_ = next_text_;
-        lexer_errno_ = yyerrno;
-
-        next_token_ = yylex();
-        next_tok_value_ = yylval;
-        next_line_ = yylineno;
-        next_column_ = yycolno;
-        next_text_ = yytext;
-
-        if(token_ == TOK_ERROR) {
-            throw SyntaxErr(GetLexerErrMsg(), line_, column_);
+        if (failed_)
+            return token_.kind; // stay at the error until it is taken
+
+        if (queue_)
+        {
+            if (token_.kind != 0)
+            {
+                queue_->Next();
+                pos_++;
+            }
+            token_ = queue_->token();
+        }
+        else
+        {
+            if (pos_ + 1 < tokens_->size())
+                pos_++;
+            token_ = (*tokens_)[pos_];
+        }
+
+        if(token_.kind == TOK_ERROR) {
+            Fail(GetLexerErrMsg());
         }
 
-        return token_;
+        return token_.kind;
+    }
+
+    void Parser::Fail(std::string err_msg)
+    {
+        if (failed_)
+            return;
+        failed_ = true;
+        pending_err_ = SyntaxErr(std::move(err_msg), token_.line, token_.column);
+    }
+
+    bool Parser::TakeSyntaxErr()
+    {
+        if (!failed_)
+            return false;
+        failed_ = false;
+        AddSyntaxErr(pending_err_);
+        return true;
+    }
+
+    void Parser::SkipToken()
+    {
+        NextToken();
+        TakeSyntaxErr();
     }
 
     std::string Parser::GetLexerErrMsg() const
     {
-        return {YYERRMSG[lexer_errno_]};
+        return {YYERRMSG[token_.payload]};
     }
 
-    void Parser::Match(int token)
+    bool Parser::Match(int token)
     {
-        if (token_ != token)
+        if (failed_)
+            return false;
+        if (token_.kind != token)
         {
-            std::ostringstream err;
-            err << "syntax err:expected " << TokenToString(token) << " before " << TokenToString(token_);
-            throw SyntaxErr( err.str(),line_,column_);
+            Fail(std::string("syntax err:expected ") + TokenName(token) + " before " + TokenName(token_.kind));
+            return false;
         }
         NextToken(); // only skip current token if it matches
+        return !failed_;
     }
 
-    int Parser::Match(const std::set<int> &tokens, const std::string &expected_token)
+    int Parser::Match(const TokenSet &tokens, const std::string &expected_token)
     {
-        int tok = token_;
-        if (tokens.find(token_) == tokens.end())
+        int tok = token_.kind;
+        if (failed_)
+            return tok;
+        if (!tokens.Contains(token_.kind))
         {
-            std::ostringstream err;
-            err << "syntax err:expected " << expected_token << " before " << TokenToString(token_);
-            throw SyntaxErr(err.str(), line_, column_);
+            Fail("syntax err:expected " + expected_token + " before " + TokenName(token_.kind));
+            return tok;
         }
         NextToken(); // only skip current token if it matches
         return tok;
     }
 
-    void Parser::Match(int token, const std::string &err_msg)
+    bool Parser::Match(int token, const std::string &err_msg)
     {
-        if (token_ != token)
+        if (failed_)
+            return false;
+        if (token_.kind != token)
         {
-            throw SyntaxErr(err_msg, line_, column_);
+            Fail(err_msg);
+            return false;
         }
         NextToken(); // only skip current token if it matches
+        return !failed_;
     }
 
-    int Parser::CheckMatch(const int token, const std::set<int> &delimiters)
+    int Parser::CheckMatch(const int token, const TokenSet &delimiters)
     {
-        try
-        {
-            Match(token);
+        if (Match(token))
             return token;
+
+        TakeSyntaxErr();
+        // skip to the next token until the expected token or delimiters or EOF is met
+        while (token_.kind != token && !delimiters.Contains(token_.kind) && token_.kind != TOK_EOF)
+        {
+            SkipToken();
         }
-        catch (SyntaxErr &err)
+        if (token_.kind == token)
         {
-            AddSyntaxErr(err);
-            // skip to the next token until the expected token or delimiters or EOF is met
-            while (token_ != token && delimiters.find(token_) == delimiters.end() && token_ != TOK_EOF)
-            {
-                NextToken();
-            }
-            if (token_ == token)
-            {
-                NextToken(); // skip to the next token when the expected token is met
-                return token;
-            }
-            return token_;
+            NextToken(); // skip to the next token when the expected token is met
+            return token;
         }
+        return token_.kind;
     }
 
-    int Parser::CheckMatch(const std::set<int> &tokens, const std::string &expected_token, const std::set<int> &delimiters)
+    int Parser::CheckMatch(const TokenSet &tokens, const std::string &expected_token, const TokenSet &delimiters)
     {
-        try
-        {
-            int ret = Match(tokens, expected_token);
+        int ret = Match(tokens, expected_token);
+        if (!TakeSyntaxErr())
             return ret;
+
+        // skip to the next token until the expected tokens or delimiters or EOF is met
+        const TokenSet stop = tokens | delimiters;
+        while (!stop.Contains(token_.kind) && token_.kind != TOK_EOF)
+        {
+            SkipToken();
         }
-        catch (SyntaxErr &err)
+        if (tokens.Contains(token_.kind))
         {
-            AddSyntaxErr(err);
-            // skip to the next token until the expected tokens or delimiters or EOF is met
-            while (tokens.find(token_) == tokens.end() && delimiters.find(token_) == delimiters.end() && token_ != TOK_EOF)
-            {
-                NextToken();
-            }
-            if (tokens.find(token_) != tokens.end())
-            {
-                int tok = token_;
-                NextToken(); // skip to the next token when the token is one of the expected tokens
-                return tok;
-            }
-            return token_;
+            int tok = token_.kind;
+            NextToken(); // skip to the next token when the token is one of the expected tokens
+            return tok;
         }
+        return token_.kind;
     }
 
     SyntaxErr::SyntaxErr(const std::string& err_msg) {
@@ -161,9 +219,7 @@ namespace pascal2c::parser
         std::string msg;
         ss >> line >> colon >> col ;
         std::getline(ss >> std::ws, msg);
-        err_msg_ = std::move(msg);
-        line_ = line;
-        col_ = col;
+        *this = SyntaxErr(std::move(msg), line, col);
     }
 
     void Parser::AddSyntaxErr(SyntaxErr &err) {
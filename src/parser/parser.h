@@ -1,17 +1,25 @@
 #ifndef PASCAL2C_SRC_PARSER_PARSER_H_
 #define PASCAL2C_SRC_PARSER_PARSER_H_
 
+#include <array>
 #include <memory>
 #include <utility>
 #include <vector>
 #include <cstdio>
 #include <string>
+#include <string_view>
 #include <sstream>
 
 #include "gtest/gtest.h"
+#include "ast/arena.h"
 #include "ast/ast.h"
 #include "ast/expr.h"
+#include "ast/expr_pool.h"
 #include "ast/program.h"
+#include "parser/token.h"
+#include "parser/token_queue.h"
+#include "parser/token_stream.h"
+#include "parser/token_set.h"
 
 extern "C"
 {
@@ -20,16 +28,18 @@ extern "C"
 
 #define TOK_EOF 0
 
-// init the begin line and the begin column before parsing
-#define INIT_PARSE(line, column) \
-    int begin_line = line;       \
-    int begin_column = column;
+// init the begin offset from the offset of the first token before parsing
+#define INIT_PARSE(offset) \
+    uint32_t begin_offset = offset;
 
-// make the shared pointer of Ast node
-#define MAKE_SHARED(constructor, ...) std::make_shared<constructor>(begin_line, begin_column, __VA_ARGS__)
+// make the shared pointer of Ast node, the node lives in the arena of the parser
+#define MAKE_SHARED(constructor, ...) NewNode<constructor>(begin_offset, __VA_ARGS__)
 
 // make the shared pointer of Ast node with no argument
-#define MAKE_SHARED_WITH_NO_ARGUMENT(constructor) std::make_shared<constructor>(begin_line, begin_column)
+#define MAKE_SHARED_WITH_NO_ARGUMENT(constructor) NewNode<constructor>(begin_offset)
+
+// make the shared pointer of an expression node, an equal one is reused if the parser shares them
+#define MAKE_EXPR(constructor, ...) NewExpr<constructor>(begin_offset, __VA_ARGS__)
 
 // make and move the shared pointer of Ast node
 #define MAKE_AND_MOVE_SHARED(constructor, ...) \
@@ -40,23 +50,26 @@ namespace pascal2c::parser
     template <typename Tp>
     using vector = ::std::vector<Tp>;
 
-    // exception class for syntax error
+    // a syntax error found by the parser
+    // the parser records them instead of throwing, see Parser::syntax_errs
     class SyntaxErr : public ::std::exception
     {
     public:
+        SyntaxErr() = default;
+
         // param:
-        //     err_msg is the error message
+        //     err_msg is the error message in the form of "line:col message"
         explicit SyntaxErr(const std::string& err_msg);
-        SyntaxErr(std::string err_msg, int line, int col) : err_msg_(std::move(err_msg)), line_(line), col_(col) {}
+        SyntaxErr(std::string err_msg, int line, int col)
+            : err_msg_(std::move(err_msg)), line_(line), col_(col),
+              what_(std::to_string(line) + ":" + std::to_string(col) + " " + err_msg_) {}
 
         // get the error message
         // return:
-        //     the error message
+        //     the error message with its position, "line:col message"
         inline const char *what() const noexcept override
         {
-            static char buff[1024];
-            sprintf(buff, "%d:%d %s", line_, col_, err_msg_.c_str());
-            return buff;
+            return what_.c_str();
         }
 
         GETTER(std::string, err_msg);
@@ -64,30 +77,127 @@ namespace pascal2c::parser
         GETTER(int, col);
     private:
         std::string err_msg_; // error message
-        int line_, col_;      // line and column number
+        int line_ = 0, col_ = 0; // line and column number
+        std::string what_;    // the message what() returns, formatted once
+    };
+
+    // receives a program piece by piece while Parser::Parse(ProgramHandler &) reads it
+    // so later stages can work on each subprogram as soon as it is complete
+    // and drop it before the next one is parsed
+    class ProgramHandler
+    {
+    public:
+        virtual ~ProgramHandler() = default;
+
+        // called first with the program head
+        virtual void OnProgramHead(const std::shared_ptr<ast::ProgramHead> &head) = 0;
+
+        // called before the first subprogram, body holds the global const and var declarations
+        virtual void OnGlobals(const std::shared_ptr<ast::ProgramBody> &body) = 0;
+
+        // called with every subprogram once it and the ';' after it are parsed,
+        // the syntax errors in it are in Parser::syntax_errs by then
+        // the parser keeps no reference to it, the nodes of its body live in
+        // an arena of their own that is released together with subprogram,
+        // a node of the body kept on its own must not outlive it
+        virtual void OnSubprogram(std::shared_ptr<ast::Subprogram> subprogram) = 0;
     };
 
     // parser class
     // parse the pascal program
     // usage:
-    //     Parser parser = new Parser(file_ptr);
+    //     Parser parser(file_ptr);
     //     std::shared_ptr<ast::Program> program = std::move(parser.Parse());
     class Parser
     {
     public:
         // param:
-        //     in is the input file
+        //     in is the input file, it is read to the end before parsing starts
         explicit Parser(FILE *in);
 
+        // param:
+        //     source points to the whole program text, size bytes long
+        //     it is only read while the parser is constructed
+        Parser(const char *source, size_t size);
+
+        // param:
+        //     tokens are the tokens of the whole input, scanned already, eg. in parallel
+        //     pos is the index of the token to start at, the parsers of
+        //     ParseSubprogramsInParallel start at a subprogram
+        explicit Parser(std::shared_ptr<const TokenStream> tokens, size_t pos = 0);
+
+        // param:
+        //     queue hands out the tokens while its thread is still scanning the input,
+        //     the subprograms are then parsed on the calling thread
+        explicit Parser(std::unique_ptr<TokenQueue> queue);
+
+        // the parser owns its place in the token stream
+        Parser(const Parser &) = delete;
+        Parser &operator=(const Parser &) = delete;
+
+        // the tokens of the whole input, only for a parser whose tokens were scanned up front
+        const TokenStream &tokens() const { return *tokens_; }
+
+        // where the lines of the input start, the nodes keep byte offsets into the input,
+        // pass it to whatever prints their lines and columns, eg. analysiser::init
+        const std::shared_ptr<const ast::LineTable> &line_table() const { return line_table_; }
+
+        // the identifiers of the input, the nodes keep the ids of their names in here,
+        // pass it to whatever compares them, eg. analysiser::init
+        // a parser reading a TokenQueue adds to it until the end of the input is taken
+        const std::shared_ptr<const ast::Interner> &symbols() const { return symbols_; }
+
+        // the queue the tokens come from, nullptr if they were scanned up front
+        const TokenQueue *token_queue() const { return queue_.get(); }
+
         GETTER(vector<std::string>, err_msg);
         GETTER(vector<SyntaxErr>, syntax_errs);
 
+        // the arena holding every node this parser creates
+        // it is released with the parser or the root Parse returned, whichever goes last
+        GETTER(std::shared_ptr<ast::Arena>, arena);
+
         // parse the whole program
         // return:
         //     the ast of the program
         inline std::shared_ptr<ast::Program> Parse()
         {
-            return ParseProgram();
+            auto program = ParseProgram();
+            TakeSyntaxErr(); // a lexer error after the final '.'
+            return ast::Root(std::move(program), arena_);
+        }
+
+        // param:
+        //     threads is the number of threads parsing subprograms at the same time,
+        //     0 means one per hardware thread
+        //     small programs, streamed ones and ones read from a TokenQueue are always parsed
+        //     on the calling thread
+        void set_parse_threads(size_t threads) { parse_threads_ = threads; }
+
+        // share structurally equal expressions, see ast::ExprPool
+        // the pool is emptied for every subprogram, whose names are its own, a shared
+        // node keeps the place of its first occurrence and a parenthesized expression
+        // starts at its first operand instead of the '('
+        // so sharing is only for sources without errors, the errors of two occurrences
+        // of a shared node are reported at one place, parse again without it to report them
+        // param:
+        //     on turns hash-consing on for the expressions parsed from now on
+        void set_hash_cons(bool on) { hash_cons_ = on; }
+
+        // the expressions shared so far, empty unless set_hash_cons was called
+        const ast::ExprPool &expr_pool() const { return expr_pool_; }
+
+        // parse the whole program, handing each part to handler as soon as it is parsed
+        // param:
+        //     handler receives the program head, the global declarations and every subprogram
+        // return:
+        //     the ast of the program without its subprograms
+        std::shared_ptr<ast::Program> Parse(ProgramHandler &handler)
+        {
+            handler_ = &handler;
+            auto program = Parse();
+            handler_ = nullptr;
+            return program;
         }
 
     private:
@@ -113,54 +223,163 @@ namespace pascal2c::parser
         FRIEND_TEST(StatementParserTest, TestErrorHandle);
         FRIEND_TEST(StatementParserTest, TestCompoundStatement);
         FRIEND_TEST(ExprParserTest, TestParserErr);
+        FRIEND_TEST(ExprParserTest, TestLongExpr);
+        FRIEND_TEST(ExprParserTest, TestStringPosition);
+        FRIEND_TEST(ExprParserTest, TestHashCons);
+        FRIEND_TEST(ProgramParserTest, TestFindSubprograms);
+
+        std::shared_ptr<const TokenStream> tokens_; // every token of the input, shared with the
+                                                    // parsers of the subprograms, see ParseSubprogramsInParallel
+        std::unique_ptr<TokenQueue> queue_; // or the tokens come one at a time from here, tokens_ is null
+        size_t pos_ = 0;     // index of the current token in tokens_, the count of tokens taken from queue_
+        Token token_;        // tokens_[pos_]
+        std::shared_ptr<const ast::LineTable> line_table_; // of the input, handed out by line_table()
+        std::shared_ptr<const ast::Interner> symbols_;     // of the input, the payloads of the TOK_IDs
 
-            int token_, next_token_; // current token and next token
+        vector<std::string> err_msg_; // error massages
+        vector<SyntaxErr>   syntax_errs_; // syntax error
 
-        // if a lex error occur, error number will be stored in this variable
-        int lexer_errno_;
+        // a syntax error that has been found but not recorded yet
+        // while it is set, the parse functions return at once (nullptr or false)
+        // without reading further, until a recovery point records it with
+        // TakeSyntaxErr and skips to a token it can go on from
+        bool failed_ = false;
+        SyntaxErr pending_err_;
 
-        // token value
-        YYSTYPE tok_value_, next_tok_value_;
-        int line_, next_line_;     // line number of token in the input file
-        int column_, next_column_; // column number of token in the input file
-        std::string text_, next_text_;
+        // parses the expression a literal or an identifier starts, see ParseAtom
+        using PrefixParser = std::shared_ptr<ast::Expression> (Parser::*)();
 
-        vector<std::string> err_msg_; // error massages
-        vector<SyntaxErr>   syntax_errs_; // syntax error
+        // what the expression parser knows about one token
+        struct Operator
+        {
+            PrefixParser prefix = nullptr; // parser of an atom starting with the token
+            int binary_prec = 0;           // precedence as a binary operator, 0 if it is none
+            bool right_assoc = false;      // a op b op c is a op (b op c)
+            int unary_prec = 0;            // precedence as a prefix operator, 0 if it is none
+        };
 
-        std::shared_ptr<ast::Expression> (Parser::*prefix_parser_[500])();
+        // indexed by token id, built at compile time in expr.cc and shared by every parser
+        static const std::array<Operator, TokenSet::kCapacity> kOperators;
+
+        // an operator waiting for its operands
+        struct PendingOperator
+        {
+            int op;             // the token of the operator
+            bool prefix;        // a unary operator or '(', the others are binary
+            uint32_t offset;    // position of a prefix operator, its node starts there
+        };
+
+        // owner of the ast nodes, declared before every member holding nodes so it goes after them
+        std::shared_ptr<ast::Arena> arena_ = std::make_shared<ast::Arena>();
+
+        // operands and pending operators of the expressions being parsed, '('
+        // and unary operators are kept here too so nesting depth costs no
+        // call stack, nested ParseExpr calls work on top of the entries of their callers
+        vector<std::shared_ptr<ast::Expression>> operand_stack_;
+        vector<PendingOperator> operator_stack_;
+
+        ProgramHandler *handler_ = nullptr; // receiver of the parts of a streamed program
+        size_t parse_threads_ = 1;          // see set_parse_threads
+        bool hash_cons_ = false;            // see set_hash_cons
+        ast::ExprPool expr_pool_;           // the shared expressions of the scope being parsed
+
+        // allocate an ast node from the arena instead of the heap
+        // param:
+        //     args are passed to the constructor of Tp
+        // return:
+        //     the shared pointer of the new node
+        template <typename Tp, typename... Args>
+        std::shared_ptr<Tp> NewNode(Args &&...args)
+        {
+            return std::allocate_shared<Tp>(ast::ArenaAllocator<Tp>(arena_.get()), std::forward<Args>(args)...);
+        }
+
+        // make an expression node, with set_hash_cons on an equal one parsed before
+        // is handed out instead and nothing is allocated
+        // param:
+        //     offset and args are passed to the constructor of Tp
+        // return:
+        //     the shared pointer of the node
+        template <typename Tp, typename... Args>
+        std::shared_ptr<ast::Expression> NewExpr(uint32_t offset, Args &&...args)
+        {
+            if (hash_cons_)
+            {
+                if (auto shared = expr_pool_.Find(ast::ExprPool::Shape::Of<Tp>(args...)))
+                    return shared;
+                return expr_pool_.Intern(NewNode<Tp>(offset, std::forward<Args>(args)...));
+            }
+            return NewNode<Tp>(offset, std::forward<Args>(args)...);
+        }
 
         void AddSyntaxErr(SyntaxErr &err);
 
-        // get next token
+        // make err_msg at the current token the pending syntax error
+        // only the first error is kept until it is taken, the later ones follow from it
+        void Fail(std::string err_msg);
+
+        // record the pending syntax error, if any, and clear it
+        // return:
+        //     true if there was one
+        bool TakeSyntaxErr();
+
+        // get the next token while resynchronizing after a syntax error,
+        // a lexer error met on the way is recorded at once
+        void SkipToken();
+
+        // make tokens_[pos_] or the first token of queue_ the current one
+        void Start();
+
+        // get next token, a lexer error becomes the pending syntax error
+        // the current token does not change while an error is pending
         // return:
         //     the next token
         int NextToken();
 
+        // return:
+        //     the text of the current token, identifiers lowercased
+        std::string_view Text() const
+        {
+            return queue_ ? queue_->text() : tokens_->text(pos_);
+        }
+
+        // return:
+        //     the value of the current token if it is a literal
+        const Literal &Value() const
+        {
+            return queue_ ? queue_->value() : tokens_->value(pos_);
+        }
+
+        // return:
+        //     the characters of the current token if it is a string literal
+        std::string_view StringValue() const
+        {
+            return queue_ ? queue_->string_value() : tokens_->string_value(pos_);
+        }
+
         // match token and get next token (only skip current token if it matches)
         // param:
         //     token is the token to match
-        // throw:
-        //     SyntaxErr if token not match
-        void Match(int token);
+        // return:
+        //     false if token not match or an error is pending, see Fail
+        bool Match(int token);
 
         // match token and get next token (only skip current token if it matches)
         // param:
         //     token is the token to match
-        //     err_msg is the error message that is going to be thrown if token not match
-        // throw:
-        //     SyntaxErr if token not match
-        void Match(int token,const std::string& err_msg);
+        //     err_msg is the error message that is recorded if token not match
+        // return:
+        //     false if token not match or an error is pending, see Fail
+        bool Match(int token,const std::string& err_msg);
 
         // match tokens and get next token (only skip current token if it matches)
+        // if token not match, it becomes the pending error, see Fail
         // param:
         //     tokens are the tokens to match
         //     expected_token is the primary expected token in the err_msg
         // return:
         //     the matched token or the unexpected token
-        // throw:
-        //     SyntaxErr if token not match
-        int Match(const std::set<int> &tokens, const std::string &expected_token);
+        int Match(const TokenSet &tokens, const std::string &expected_token);
 
         // Check if the token is matched,
         // if not, get next token until either the expected token or the delimiters or the end of the file is found
@@ -172,7 +391,7 @@ namespace pascal2c::parser
         //     delimiters is the end symbols to stop finding the expected token, that is the expected token of the next part
         // return:
         //     the matched token or the delimiters or end of the file
-        int CheckMatch(const int token, const std::set<int> &delimiters);
+        int CheckMatch(const int token, const TokenSet &delimiters);
 
         // Check if the token is matched,
         // if not, get next token until either the expected tokens or the delimiters or the end of the file is found
@@ -185,7 +404,7 @@ namespace pascal2c::parser
         //     delimiters is the end symbols to stop finding the expected token, that is the expected token of the next part
         // return:
         //     the matched token or the delimiters or end of the file
-        int CheckMatch(const std::set<int> &tokens, const std::string &expected_token, const std::set<int> &delimiters);
+        int CheckMatch(const TokenSet &tokens, const std::string &expected_token, const TokenSet &delimiters);
 
         // get the error message of lexer
         // return:
@@ -229,6 +448,35 @@ namespace pascal2c::parser
         //     the ast of the subprogram declaration
         std::shared_ptr<ast::Subprogram> ParseSubprogram();
 
+        // find where the subprograms of a program start from the begin/end nesting alone,
+        // without parsing them, each runs from the token after the ';' following
+        // the end that closes its first begin
+        // param:
+        //     tokens are the tokens of the program
+        //     first is the index of the first procedure or function token
+        // return:
+        //     the index of the first token of every subprogram and, last, the index of
+        //     the first token after them
+        static vector<size_t> FindSubprograms(const TokenStream &tokens, size_t first);
+
+        // parse the subprograms from the current token on in groups on a pool of
+        // threads, then add them to program_body in source order
+        // a group is only used if its parser stops exactly where the next group starts
+        // without a pending error, so the ast and the syntax errors are the ones the
+        // serial loop would produce, the current token ends up at the first
+        // subprogram that is left for the serial loop or after the last one
+        // param:
+        //     program_body is the body the subprograms are added to
+        void ParseSubprogramsInParallel(ast::ProgramBody &program_body);
+
+        // parse subprograms with the ';' after each until the current token is
+        // none or its index reaches end
+        // param:
+        //     end is the index of the token to stop at
+        // return:
+        //     the subprograms
+        vector<std::shared_ptr<ast::Subprogram>> ParseSubprograms(size_t end);
+
         // parse the subprogram head
         // eg. function f(a : integer) : integer;
         // eg. procedure p(a : integer);
@@ -274,32 +522,36 @@ namespace pascal2c::parser
         //     the ast of the expression
         std::shared_ptr<ast::Expression> ParseExpr();
 
-        // parse the expression
+        // parse the expression, operators and parentheses are handled in a
+        // loop with an operator stack, no recursion per precedence level or
+        // nesting level, only the arguments of calls and indexes recurse
         // param:
-        //     prec is the precedence of the operator
+        //     prec is the lowest precedence of a binary operator that may be consumed
         // return:
         //     the ast of the expression
         std::shared_ptr<ast::Expression> ParseExpr(int prec);
 
+        // replace the two topmost operands by the binary expression of the topmost operator
+        void ReduceBinary();
+
+        // replace the topmost operand by the unary expression of the topmost operator
+        void ReduceUnary();
+
         // parse the expression list
         // return:
         //     the ast of the expression list
         vector<std::shared_ptr<ast::Expression>> ParseExprList();
 
-        // parse the primary unit of expression
+        // parse the primary unit of expression, an atom, a parenthesized
+        // expression or a unary operator applied to a primary unit
         // return:
         //     the ast of the primary unit of expression
         std::shared_ptr<ast::Expression> ParsePrimary();
 
-        // parse the parenthesis
-        // return:
-        //     the ast of the parenthesis
-        std::shared_ptr<ast::Expression> ParseParen();
-
-        // parse the prefix
+        // parse a literal, a variable or a call
         // return:
-        //     the ast of the prefix
-        std::shared_ptr<ast::Expression> ParsePrefix();
+        //     the ast of the atom
+        std::shared_ptr<ast::Expression> ParseAtom();
 
         // parse integer or real number
         // return:
@@ -341,9 +593,8 @@ namespace pascal2c::parser
         std::shared_ptr<ast::Statement> ParseForStatement();
 
         // parse the compound statement
-        // this function will not throw exception
-        // all the exception occur when parsing statement
-        // will be handled in this function
+        // this function never fails, all the syntax errors
+        // met when parsing its statements are recorded here
         // return:
         //     the ast of the compound statement
         std::shared_ptr<ast::Statement> ParseCompoundStatement() noexcept;
@@ -1,7 +1,11 @@
+#include <algorithm>
+#include <future>
+#include <thread>
 #include <vector>
 
 #include "parser.h"
 #include "ast/program.h"
+#include "thread_pool.hpp"
 
 extern "C"
 {
@@ -16,9 +20,13 @@ namespace pascal2c::parser
     // ProgramHead ; ProgramBody .
     std::shared_ptr<ast::Program> Parser::ParseProgram()
     {
-        INIT_PARSE(line_, column_);
+        INIT_PARSE(token_.offset);
 
         auto program_head = ParseProgramHead();
+        if (handler_ != nullptr)
+        {
+            handler_->OnProgramHead(ast::Root(program_head, arena_));
+        }
         CheckMatch(';', {TOK_CONST, TOK_VAR, TOK_PROCEDURE, TOK_FUNCTION, TOK_BEGIN});
         auto program_body = ParseProgramBody();
         CheckMatch('.', {});
@@ -28,10 +36,10 @@ namespace pascal2c::parser
     // TOK_PROGRAM TOK_ID [(IdList)] ;
     std::shared_ptr<ast::ProgramHead> Parser::ParseProgramHead()
     {
-        INIT_PARSE(line_, column_);
+        INIT_PARSE(token_.offset);
 
         CheckMatch(TOK_PROGRAM, {TOK_ID, '(', ';'});
-        auto name = text_;
+        std::string name(Text());
 
         // Parse the program id
         int ret = CheckMatch(TOK_ID, {'(', ';'});
@@ -45,7 +53,7 @@ namespace pascal2c::parser
         }
 
         // If the program has a parameter list, parse it
-        if (token_ == '(')
+        if (token_.kind == '(')
         {
             NextToken();
             auto id_list = ParseIdList();
@@ -61,15 +69,15 @@ namespace pascal2c::parser
     // CompoundStatement
     std::shared_ptr<ast::ProgramBody> Parser::ParseProgramBody()
     {
-        INIT_PARSE(line_, column_);
+        INIT_PARSE(token_.offset);
 
         auto program_body = MAKE_SHARED_WITH_NO_ARGUMENT(ast::ProgramBody);
 
         // Parse const declarations
-        if (token_ == TOK_CONST)
+        if (token_.kind == TOK_CONST)
         {
             NextToken();
-            while (token_ == TOK_ID)
+            while (token_.kind == TOK_ID)
             {
                 program_body->AddConstDeclaration(std::move(ParseConstDeclaration()));
                 CheckMatch(';', {TOK_ID, TOK_VAR, TOK_PROCEDURE, TOK_FUNCTION, TOK_BEGIN});
@@ -77,21 +85,39 @@ namespace pascal2c::parser
         }
 
         // Parse var declarations
-        if (token_ == TOK_VAR)
+        if (token_.kind == TOK_VAR)
         {
             NextToken();
-            while (token_ == TOK_ID)
+            while (token_.kind == TOK_ID)
             {
                 program_body->AddVarDeclaration(std::move(ParseVarDeclaration()));
                 CheckMatch(';', {TOK_ID, TOK_PROCEDURE, TOK_FUNCTION, TOK_BEGIN});
             }
         }
 
-        // Parse subprograms
-        while (token_ == TOK_PROCEDURE || token_ == TOK_FUNCTION)
+        // Parse subprograms, a streamed one goes to the handler instead of the body
+        if (handler_ != nullptr)
+        {
+            handler_->OnGlobals(ast::Root(program_body, arena_));
+        }
+        else if (parse_threads_ != 1 && tokens_ != nullptr)
+        {
+            // the loop below goes on with whatever is left
+            ParseSubprogramsInParallel(*program_body);
+        }
+        while (token_.kind == TOK_PROCEDURE || token_.kind == TOK_FUNCTION)
         {
-            program_body->AddSubprogram(std::move(ParseSubprogram()));
+            auto subprogram = ParseSubprogram();
+            // the ';' records any syntax error still pending in the subprogram
             CheckMatch(';', {TOK_PROCEDURE, TOK_FUNCTION, TOK_BEGIN});
+            if (handler_ != nullptr)
+            {
+                handler_->OnSubprogram(std::move(subprogram));
+            }
+            else
+            {
+                program_body->AddSubprogram(std::move(subprogram));
+            }
         }
 
         // Parse compound statement
@@ -103,14 +129,16 @@ namespace pascal2c::parser
     // TOK_ID = PrimaryExpression
     std::shared_ptr<ast::ConstDeclaration> Parser::ParseConstDeclaration()
     {
-        INIT_PARSE(line_, column_);
+        INIT_PARSE(token_.offset);
 
         // Parse id
-        auto name = text_;
+        std::string name(Text());
+        ast::SymbolId symbol = token_.payload;
         int ret = CheckMatch(TOK_ID, {'=', TOK_INTEGER, TOK_REAL, '+', '-', TOK_STRING, ';'});
         if (ret != TOK_ID)
         {
             name = "";
+            symbol = 0;
         }
 
         CheckMatch('=', {TOK_INTEGER, TOK_REAL, '+', '-', TOK_STRING, ';'});
@@ -119,38 +147,35 @@ namespace pascal2c::parser
         std::shared_ptr<ast::Expression> const_value;
         while (true)
         {
-            try
+            const_value = std::move(ParsePrimary());
+            if (!TakeSyntaxErr())
             {
-                const_value = std::move(ParsePrimary());
                 break;
             }
-            catch (SyntaxErr &err)
-            {
-                AddSyntaxErr(err);
-                std::set<int> tokens({TOK_INTEGER, TOK_REAL, '-', '+', TOK_STRING});
-                int delimiter = ';';
 
-                // Skip token until finding the expected tokens or the delimiter or EOF
-                while (tokens.find(token_) == tokens.end() && delimiter != token_ && token_ != TOK_EOF)
-                {
-                    NextToken();
-                }
-                // If the delimiter or EOF is found, break the loop and return a const declaration with default value 0
-                if (tokens.find(token_) == tokens.end())
-                {
-                    const_value = MAKE_AND_MOVE_SHARED(ast::IntegerValue, 0);
-                    break;
-                }
+            static constexpr TokenSet tokens = {TOK_INTEGER, TOK_REAL, '-', '+', TOK_STRING};
+            int delimiter = ';';
+
+            // Skip token until finding the expected tokens or the delimiter or EOF
+            while (!tokens.Contains(token_.kind) && delimiter != token_.kind && token_.kind != TOK_EOF)
+            {
+                SkipToken();
+            }
+            // If the delimiter or EOF is found, break the loop and return a const declaration with default value 0
+            if (!tokens.Contains(token_.kind))
+            {
+                const_value = MAKE_AND_MOVE_SHARED(ast::IntegerValue, 0);
+                break;
             }
         }
 
-        return MAKE_AND_MOVE_SHARED(ast::ConstDeclaration, name, std::move(const_value));
+        return MAKE_AND_MOVE_SHARED(ast::ConstDeclaration, name, std::move(const_value), symbol);
     }
 
     // IdList : Type
     std::shared_ptr<ast::VarDeclaration> Parser::ParseVarDeclaration()
     {
-        INIT_PARSE(line_, column_);
+        INIT_PARSE(token_.offset);
 
         auto id_list = ParseIdList();
         CheckMatch(':', {TOK_ARRAY, TOK_INTEGER_TYPE, TOK_REAL_TYPE, TOK_CHAR_TYPE, TOK_BOOLEAN_TYPE, ';'});
@@ -161,27 +186,181 @@ namespace pascal2c::parser
     // SubprogramHead ; SubprogramBody
     std::shared_ptr<ast::Subprogram> Parser::ParseSubprogram()
     {
-        INIT_PARSE(line_, column_);
+        INIT_PARSE(token_.offset);
 
         auto subprogram_head = ParseSubprogramHead();
         CheckMatch(';', {TOK_CONST, TOK_VAR, TOK_BEGIN});
+
+        // The head stays in the arena of the program, later stages look it up
+        // when the subprogram is called. A streamed body gets an arena of its own
+        // that is released once the handler has dropped the subprogram.
+        std::shared_ptr<ast::Arena> program_arena;
+        if (handler_ != nullptr)
+        {
+            program_arena = std::exchange(arena_, std::make_shared<ast::Arena>());
+        }
+        // The names in the body are the subprogram's own, its expressions share
+        // nothing with the ones around it
+        expr_pool_.Clear();
         auto subprogram_body = ParseSubprogramBody();
-        return MAKE_AND_MOVE_SHARED(ast::Subprogram, std::move(subprogram_head), std::move(subprogram_body));
+        auto subprogram = MAKE_SHARED(ast::Subprogram, std::move(subprogram_head), std::move(subprogram_body));
+        expr_pool_.Clear();
+        if (program_arena != nullptr)
+        {
+            // the streamed subprogram is the only owner of the arena of its body
+            subprogram = ast::Root(std::move(subprogram), std::exchange(arena_, std::move(program_arena)));
+        }
+        return std::move(subprogram);
+    }
+
+    vector<size_t> Parser::FindSubprograms(const TokenStream &tokens, size_t first)
+    {
+        vector<size_t> bounds;
+        size_t i = first;
+        while (tokens.kind(i) == TOK_PROCEDURE || tokens.kind(i) == TOK_FUNCTION)
+        {
+            // The head and the declarations have no begin,
+            // the scan ends at a subprogram without one
+            size_t body = i + 1;
+            while (tokens.kind(body) != TOK_BEGIN && tokens.kind(body) != TOK_PROCEDURE &&
+                   tokens.kind(body) != TOK_FUNCTION && tokens.kind(body) != TOK_EOF)
+            {
+                body++;
+            }
+            if (tokens.kind(body) != TOK_BEGIN)
+            {
+                break;
+            }
+            bounds.push_back(i);
+
+            // Skip to the end closing the first begin, case and record have an end too
+            int depth = 0;
+            for (i = body; tokens.kind(i) != TOK_EOF; i++)
+            {
+                int kind = tokens.kind(i);
+                if (kind == TOK_BEGIN || kind == TOK_CASE || kind == TOK_RECORD)
+                {
+                    depth++;
+                }
+                else if (kind == TOK_END && --depth == 0)
+                {
+                    i++;
+                    break;
+                }
+            }
+            if (tokens.kind(i) == ';')
+            {
+                i++;
+            }
+        }
+        bounds.push_back(i);
+        return bounds;
+    }
+
+    void Parser::ParseSubprogramsInParallel(ast::ProgramBody &program_body)
+    {
+        // below this many tokens starting the threads costs more than it saves
+        static constexpr size_t kMinTokens = 1 << 14;
+
+        if (failed_)
+        {
+            return;
+        }
+        vector<size_t> bounds = FindSubprograms(*tokens_, pos_);
+        size_t count = bounds.size() - 1;
+        size_t threads = parse_threads_ != 0 ? parse_threads_ : std::max(1u, std::thread::hardware_concurrency());
+        if (count < 2 || threads < 2 || bounds.back() - bounds.front() < kMinTokens)
+        {
+            return;
+        }
+
+        // A few groups per thread even out subprograms of different sizes,
+        // starts holds the first token of every group and then the end of the last one
+        size_t group_tokens = (bounds.back() - bounds.front()) / std::min(count, threads * 4);
+        vector<size_t> starts = {bounds.front()};
+        for (size_t i = 1; i < count; i++)
+        {
+            if (bounds[i] - starts.back() >= group_tokens)
+            {
+                starts.push_back(bounds[i]);
+            }
+        }
+        starts.push_back(bounds.back());
+
+        struct Group
+        {
+            std::unique_ptr<Parser> parser;
+            vector<std::shared_ptr<ast::Subprogram>> subprograms;
+        };
+        vector<Group> groups(starts.size() - 1);
+        {
+            ThreadPool pool(std::min(threads, groups.size()));
+            vector<std::future<void>> done;
+            done.reserve(groups.size());
+            for (size_t i = 0; i < groups.size(); i++)
+            {
+                done.push_back(pool.Submit([this, &starts, &groups, i] {
+                    groups[i].parser.reset(new Parser(tokens_, starts[i]));
+                    groups[i].parser->set_hash_cons(hash_cons_);
+                    groups[i].subprograms = groups[i].parser->ParseSubprograms(starts[i + 1]);
+                }));
+            }
+            for (auto &group : done)
+            {
+                group.get();
+            }
+        }
+
+        // Take the groups up to the first one that does not stop where the next starts,
+        // the serial loop parses the rest again
+        for (size_t i = 0; i < groups.size(); i++)
+        {
+            Parser &parser = *groups[i].parser;
+            if (parser.pos_ != starts[i + 1] || parser.failed_)
+            {
+                break;
+            }
+            for (auto &subprogram : groups[i].subprograms)
+            {
+                program_body.AddSubprogram(std::move(subprogram));
+            }
+            // the group's nodes are part of the tree now
+            arena_->Adopt(parser.arena_);
+            for (auto &err : parser.syntax_errs_)
+            {
+                AddSyntaxErr(err);
+            }
+            pos_ = parser.pos_;
+            token_ = parser.token_;
+        }
+    }
+
+    vector<std::shared_ptr<ast::Subprogram>> Parser::ParseSubprograms(size_t end)
+    {
+        // the same steps as the subprogram loop of ParseProgramBody
+        vector<std::shared_ptr<ast::Subprogram>> subprograms;
+        while ((token_.kind == TOK_PROCEDURE || token_.kind == TOK_FUNCTION) && pos_ < end)
+        {
+            subprograms.push_back(ParseSubprogram());
+            CheckMatch(';', {TOK_PROCEDURE, TOK_FUNCTION, TOK_BEGIN});
+        }
+        return subprograms;
     }
 
     // TOK_PROCEDURE TOK_ID [(Parameter {; Parameter})]
     // TOK_FUNCTION TOK_ID [(Parameter {; Parameter})] : TOK_INTEGER_TYPE | TOK_REAL_TYPE | TOK_CHAR_TYPE | TOK_BOOLEAN_TYPE
     std::shared_ptr<ast::SubprogramHead> Parser::ParseSubprogramHead()
     {
-        INIT_PARSE(line_, column_);
+        INIT_PARSE(token_.offset);
 
-        if (token_ == TOK_PROCEDURE)
+        if (token_.kind == TOK_PROCEDURE)
         {
             // Parse procedure head
             NextToken();
 
             // Parse procedure id
-            auto name = text_;
+            std::string name(Text());
+            ast::SymbolId symbol = token_.payload;
             int ret = CheckMatch(TOK_ID, {'(', ';'});
             if (ret == ';' || ret == TOK_EOF)
             {
@@ -190,19 +369,20 @@ namespace pascal2c::parser
             else if (ret == '(')
             {
                 name = "";
+                symbol = 0;
             }
 
             // If the procedure has a parameter list, parse it
-            auto subprogram_head = MAKE_SHARED(ast::SubprogramHead, name);
-            if (token_ == '(')
+            auto subprogram_head = MAKE_SHARED(ast::SubprogramHead, name, -1, symbol);
+            if (token_.kind == '(')
             {
                 NextToken();
-                if (token_ != ')')
+                if (token_.kind != ')')
                 {
                     while (true)
                     {
                         subprogram_head->AddParameter(std::move(ParseParameter()));
-                        if (token_ == ';')
+                        if (token_.kind == ';')
                         {
                             NextToken();
                         }
@@ -222,7 +402,8 @@ namespace pascal2c::parser
             NextToken();
 
             // Parse function id
-            auto name = text_;
+            std::string name(Text());
+            ast::SymbolId symbol = token_.payload;
             int ret = CheckMatch(TOK_ID, {'(', ':', TOK_INTEGER_TYPE, TOK_REAL_TYPE, TOK_CHAR_TYPE, TOK_BOOLEAN_TYPE, ';'});
             if (ret == ';' || ret == TOK_EOF)
             {
@@ -231,19 +412,20 @@ namespace pascal2c::parser
             else if (ret == '(')
             {
                 name = "";
+                symbol = 0;
             }
 
             // If the function has a parameter list, parse it
-            auto subprogram_head = MAKE_SHARED(ast::SubprogramHead, name);
-            if (token_ == '(')
+            auto subprogram_head = MAKE_SHARED(ast::SubprogramHead, name, -1, symbol);
+            if (token_.kind == '(')
             {
                 NextToken();
-                if (token_ != ')')
+                if (token_.kind != ')')
                 {
                     while (true)
                     {
                         subprogram_head->AddParameter(std::move(ParseParameter()));
-                        if (token_ == ';')
+                        if (token_.kind == ';')
                         {
                             NextToken();
                         }
@@ -278,15 +460,15 @@ namespace pascal2c::parser
     // CompoundStatement
     std::shared_ptr<ast::SubprogramBody> Parser::ParseSubprogramBody()
     {
-        INIT_PARSE(line_, column_);
+        INIT_PARSE(token_.offset);
 
         auto subprogram_body = MAKE_SHARED_WITH_NO_ARGUMENT(ast::SubprogramBody);
 
         // Parse const declarations
-        if (token_ == TOK_CONST)
+        if (token_.kind == TOK_CONST)
         {
             NextToken();
-            while (token_ == TOK_ID)
+            while (token_.kind == TOK_ID)
             {
                 subprogram_body->AddConstDeclaration(std::move(ParseConstDeclaration()));
                 CheckMatch(';', {TOK_ID, TOK_VAR, TOK_BEGIN});
@@ -294,10 +476,10 @@ namespace pascal2c::parser
         }
 
         // Parse var declarations
-        if (token_ == TOK_VAR)
+        if (token_.kind == TOK_VAR)
         {
             NextToken();
-            while (token_ == TOK_ID)
+            while (token_.kind == TOK_ID)
             {
                 subprogram_body->AddVarDeclaration(std::move(ParseVarDeclaration()));
                 CheckMatch(';', {TOK_ID, TOK_BEGIN});
@@ -313,16 +495,17 @@ namespace pascal2c::parser
     // TOK_ID {, TOK_ID}
     std::shared_ptr<ast::IdList> Parser::ParseIdList()
     {
-        INIT_PARSE(line_, column_);
+        INIT_PARSE(token_.offset);
 
         auto id_list = MAKE_SHARED_WITH_NO_ARGUMENT(ast::IdList);
 
         // Parse the first id
-        std::string id = text_;
+        std::string id(Text());
+        ast::SymbolId symbol = token_.payload;
         int ret = CheckMatch(TOK_ID, {',', ':', ')', ';'});
         if (ret == TOK_ID)
         {
-            id_list->AddId(id);
+            id_list->AddId(id, symbol);
         }
         else if (ret != ',')
         {
@@ -330,14 +513,15 @@ namespace pascal2c::parser
         }
 
         // Parse the following ids, like , id2, id3, ...
-        while (token_ == ',')
+        while (token_.kind == ',')
         {
             NextToken();
-            std::string id = text_;
+            std::string id(Text());
+            ast::SymbolId symbol = token_.payload;
             int ret = CheckMatch(TOK_ID, {',', ':', ')', ';'});
             if (ret == TOK_ID)
             {
-                id_list->AddId(id);
+                id_list->AddId(id, symbol);
             }
             else if (ret != ',')
             {
@@ -351,7 +535,7 @@ namespace pascal2c::parser
     // TOK_ARRAY \[ Period {, Period} \] TOK_OF TOK_INTEGER_TYPE | TOK_REAL_TYPE | TOK_CHAR_TYPE | TOK_BOOLEAN_TYPE
     std::shared_ptr<ast::Type> Parser::ParseType()
     {
-        INIT_PARSE(line_, column_);
+        INIT_PARSE(token_.offset);
 
         int ret = CheckMatch({TOK_ARRAY, TOK_INTEGER_TYPE, TOK_REAL_TYPE, TOK_CHAR_TYPE, TOK_BOOLEAN_TYPE}, "basic type(integer, real, bool, char) or array", {'[', ';'});
 
@@ -365,12 +549,12 @@ namespace pascal2c::parser
             ret = CheckMatch('[', {TOK_INTEGER, TOK_DOTDOT, ']', TOK_OF, TOK_INTEGER_TYPE, TOK_REAL_TYPE, TOK_CHAR_TYPE, TOK_BOOLEAN_TYPE, ';'});
 
             // If the array has a period list, parse it
-            if ((ret == '[' || ret == TOK_INTEGER || ret == TOK_DOTDOT) && token_ != ']')
+            if ((ret == '[' || ret == TOK_INTEGER || ret == TOK_DOTDOT) && token_.kind != ']')
             {
                 while (true)
                 {
                     type->AddPeriod(ParsePeriod());
-                    if (token_ == ',')
+                    if (token_.kind == ',')
                     {
                         NextToken();
                     }
@@ -401,7 +585,7 @@ namespace pascal2c::parser
     // TOK_INTEGER TOK_DOTDOT TOK_INTEGER
     ast::Type::Period Parser::ParsePeriod()
     {
-        int value1 = tok_value_.intval;
+        int value1 = Value().intval;
         if (CheckMatch(TOK_INTEGER, {TOK_DOTDOT, ',', ']', ';'}) != TOK_INTEGER)
         {
             value1 = 0;
@@ -409,7 +593,7 @@ namespace pascal2c::parser
 
         CheckMatch(TOK_DOTDOT, {TOK_INTEGER, ';'});
 
-        int value2 = tok_value_.intval;
+        int value2 = Value().intval;
         if (CheckMatch(TOK_INTEGER, {',', ']', ';'}) != TOK_INTEGER)
         {
             value2 = 0;
@@ -421,11 +605,11 @@ namespace pascal2c::parser
     // [TOK_VAR] IdList : TOK_INTEGER_TYPE | TOK_REAL_TYPE | TOK_CHAR_TYPE | TOK_BOOLEAN_TYPE
     std::shared_ptr<ast::Parameter> Parser::ParseParameter()
     {
-        INIT_PARSE(line_, column_);
+        INIT_PARSE(token_.offset);
 
         // Check if the parameter is a var parameter
         bool is_var;
-        if (token_ == TOK_VAR)
+        if (token_.kind == TOK_VAR)
         {
             is_var = true;
             NextToken();
@@ -1,7 +1,6 @@
 //
 // Created by 谢卫凯 on 2023/3/24.
 //
-#include <set>
 
 #include "parser.h"
 #include "ast/statement.h"
@@ -14,17 +13,14 @@ namespace pascal2c::parser {
     template<typename Tp> using vector = ::std::vector<Tp>;
 
     static bool isStatementStartTok(int tok){
-        static std::set<int> tokens = {TOK_IF,TOK_ID,TOK_BEGIN,TOK_FOR,TOK_EXIT,TOK_WHILE};
-        auto it = tokens.find(tok);
-        if(it != tokens.end())
-            return true;
-        return false;
+        static constexpr TokenSet tokens = {TOK_IF,TOK_ID,TOK_BEGIN,TOK_FOR,TOK_EXIT,TOK_WHILE};
+        return tokens.Contains(tok);
     }
 
     std::shared_ptr<ast::Statement> Parser::ParseStatement(){
-        INIT_PARSE(line_,column_);
+        INIT_PARSE(token_.offset);
         std::shared_ptr<ast::Statement> statement;
-        switch (token_) {
+        switch (token_.kind) {
             case TOK_IF:
                 statement = std::move(ParseIFStatement());
                 break;
@@ -40,7 +36,7 @@ namespace pascal2c::parser {
 
             case TOK_EXIT:
                 NextToken(); // eat exit
-                statement = std::make_shared<ast::ExitStatement>();
+                statement = NewNode<ast::ExitStatement>();
                 break;
 
             case TOK_WHILE:
@@ -48,117 +44,142 @@ namespace pascal2c::parser {
                 break;
 
             default:
-                if(token_ == TOK_PROCEDURE || token_ == TOK_FUNCTION || token_ == TOK_VAR || token_ == TOK_CONST)
-                    throw(SyntaxErr("syntax error: declaration is not part of statement",line_,column_));
+                if(token_.kind == TOK_PROCEDURE || token_.kind == TOK_FUNCTION || token_.kind == TOK_VAR || token_.kind == TOK_CONST)
+                    Fail("syntax error: declaration is not part of statement");
                 else
-                    throw(SyntaxErr("syntax error: not expected token to parse statement",line_,column_));
+                    Fail("syntax error: not expected token to parse statement");
+                return nullptr;
         }
-        statement->SetLineAndColumn(begin_line,begin_column);
+        if(failed_)
+            return nullptr;
+        statement->SetOffset(begin_offset);
         return std::move(statement);
     }
 
     std::shared_ptr<ast::Statement> Parser::ParseWhileStatement() {
-        Match(TOK_WHILE);
+        if(!Match(TOK_WHILE))
+            return nullptr;
         auto cond = ParseExpr();
-        Match(TOK_DO);
+        if(!cond || !Match(TOK_DO))
+            return nullptr;
         auto statement = ParseStatement();
-        return std::move(std::make_shared<ast::WhileStatement>(cond,statement));
+        if(!statement)
+            return nullptr;
+        return std::move(NewNode<ast::WhileStatement>(cond,statement));
     }
 
     std::shared_ptr<ast::Statement> Parser::ParseIFStatement(){
-        Match(TOK_IF);
+        if(!Match(TOK_IF))
+            return nullptr;
         auto cond = ParseExpr();
-        Match(TOK_THEN);
+        if(!cond || !Match(TOK_THEN))
+            return nullptr;
         auto statement = ParseStatement();
-        if(token_ == TOK_ELSE){
-            Match(TOK_ELSE);
+        if(!statement)
+            return nullptr;
+        if(token_.kind == TOK_ELSE){
+            if(!Match(TOK_ELSE))
+                return nullptr;
             auto else_part = ParseStatement();
-            return std::move(std::make_shared<ast::IfStatement>(cond,statement,else_part));
+            if(!else_part)
+                return nullptr;
+            return std::move(NewNode<ast::IfStatement>(cond,statement,else_part));
         }
-        return std::move(std::make_shared<ast::IfStatement>(cond,statement,nullptr));
+        return std::move(NewNode<ast::IfStatement>(cond,statement,nullptr));
     }
 
     std::shared_ptr<ast::Statement> Parser::ParseForStatement(){
-        Match(TOK_FOR);
-        auto id = text_;
-        Match(TOK_ID,"syntax error: missing id in for statement");
-        Match(TOK_ASSIGNOP,"syntax error: missing ':=' in for statement");
+        if(!Match(TOK_FOR))
+            return nullptr;
+        std::string id(Text());
+        ast::SymbolId symbol = token_.payload;
+        if(!Match(TOK_ID,"syntax error: missing id in for statement") ||
+           !Match(TOK_ASSIGNOP,"syntax error: missing ':=' in for statement"))
+            return nullptr;
         auto from = ParseExpr();
-        Match(TOK_TO, "syntax error: missing 'to' in for statement");
+        if(!from || !Match(TOK_TO, "syntax error: missing 'to' in for statement"))
+            return nullptr;
         auto to = ParseExpr();
-        Match(TOK_DO, "missing 'do' in for statement");
+        if(!to || !Match(TOK_DO, "missing 'do' in for statement"))
+            return nullptr;
         auto statement = ParseStatement();
-        return std::move(std::make_shared<ast::ForStatement>(id,from,to,statement));
+        if(!statement)
+            return nullptr;
+        return std::move(NewNode<ast::ForStatement>(id,symbol,from,to,statement));
     }
 
     std::shared_ptr<ast::Statement> Parser::ParseCompoundStatement() noexcept{
-        INIT_PARSE(line_,column_);
-        try {
-            Match(TOK_BEGIN, "syntax error: missing begin when parsing compound statement");
-        }catch (SyntaxErr &e){
-            AddSyntaxErr(e);
-        }
+        INIT_PARSE(token_.offset);
+        if(!Match(TOK_BEGIN, "syntax error: missing begin when parsing compound statement"))
+            TakeSyntaxErr();
         vector<std::shared_ptr<ast::Statement> > statements;
         std::shared_ptr<ast::Statement> statement;
 
-        while(token_ != 0 && token_ != TOK_END){
-            try {
-                statement = ParseStatement();
+        while(token_.kind != 0 && token_.kind != TOK_END){
+            statement = ParseStatement();
+            if(statement) {
                 statements.push_back(std::move(statement));
-                if(token_ != TOK_END) {
+                if(token_.kind != TOK_END) {
                     Match(';', "syntax error: missing ';' at the end of statement");
-//                    if(token_ == TOK_END) {
-//                        throw SyntaxErr("last statement should not end with ;", line_, column_);
+//                    if(token_.kind == TOK_END) {
+//                        Fail("last statement should not end with ;");
 //                    }
                 }
-            }catch (SyntaxErr &e){
-                AddSyntaxErr(e);
-                while(token_ != 0 && !isStatementStartTok(token_) && token_ != ';' && token_ != TOK_END){
-                    NextToken();
+            }
+            if(TakeSyntaxErr()){
+                while(token_.kind != 0 && !isStatementStartTok(token_.kind) && token_.kind != ';' && token_.kind != TOK_END){
+                    SkipToken();
                 }
-                if(token_ == ';')
+                if(token_.kind == ';')
                     NextToken();
             }
         }
-        try {
-            Match(TOK_END, "syntax error: missing end when parsing compound statement");
-        }catch (SyntaxErr &e){
-            AddSyntaxErr(e);
-        }
+        if(!Match(TOK_END, "syntax error: missing end when parsing compound statement"))
+            TakeSyntaxErr();
         return MAKE_AND_MOVE_SHARED(ast::CompoundStatement,statements);
     }
 
     std::shared_ptr<ast::Statement> Parser::ParseAssignAndCallStatement(){
-        std::string id = text_;
-        INIT_PARSE(line_, column_);
-        Match(TOK_ID);
+        std::string id(Text());
+        ast::SymbolId symbol = token_.payload;
+        INIT_PARSE(token_.offset);
+        if(!Match(TOK_ID))
+            return nullptr;
         vector<std::shared_ptr<ast::Expression> > expr_list;
-        auto var = std::make_shared<ast::Variable>(id);
+        std::shared_ptr<ast::Variable> var;
 
-        switch (token_) {
+        switch (token_.kind) {
             case '(':
                 NextToken();
-                if(token_ == ')'){
+                if(token_.kind == ')'){
                     NextToken();
-                    return std::make_shared<ast::CallStatement>(id);
+                    return NewNode<ast::CallStatement>(begin_offset,id,symbol);
                 }
                 expr_list = ParseExprList();
-                Match(')',"syntax error: unclosed parentheses");
-                return std::make_shared<ast::CallStatement>(id,expr_list);
+                if(failed_ || !Match(')',"syntax error: unclosed parentheses"))
+                    return nullptr;
+                return NewNode<ast::CallStatement>(begin_offset,id,symbol,expr_list);
             case '[':
                 NextToken();
                 expr_list = ParseExprList();
-                Match(']',"syntax error: unclosed brackets");
-                var = std::make_shared<ast::Variable>(id,expr_list);
+                if(failed_ || !Match(']',"syntax error: unclosed brackets"))
+                    return nullptr;
+                var = NewNode<ast::Variable>(begin_offset,id,symbol,expr_list);
                 break;
             case TOK_END: // a subprogram call without parameters
             case ';':
-                return std::make_shared<ast::CallStatement>(id);
+                return NewNode<ast::CallStatement>(begin_offset,id,symbol);
+            default:
+                var = NewNode<ast::Variable>(begin_offset,id,symbol);
+                break;
         }
 
-        Match(TOK_ASSIGNOP,"syntax error: lost ':=' when parsing assign statement");
+        if(!Match(TOK_ASSIGNOP,"syntax error: lost ':=' when parsing assign statement"))
+            return nullptr;
         auto expr = ParseExpr();
-        var->SetLineAndColumn(begin_line,begin_column);
-        return std::make_shared<ast::AssignStatement>(var,expr);
+        if(!expr)
+            return nullptr;
+        var->SetOffset(begin_offset);
+        return NewNode<ast::AssignStatement>(var,expr);
     }
 }
@@ -0,0 +1,35 @@
+#ifndef PASCAL2C_SRC_PARSER_TOKEN_H_
+#define PASCAL2C_SRC_PARSER_TOKEN_H_
+
+#include <cstdint>
+
+namespace pascal2c::parser
+{
+    // one scanned token, small enough to be copied around by value
+    // the text is not stored, offset and length locate it in the scanned bytes
+    struct Token
+    {
+        int kind = 0;         // TOK_* or an ascii character, 0 at the end of the input
+        uint32_t offset = 0;  // byte offset of the token text in the scanned bytes
+        uint32_t length = 0;  // length of the token text in bytes
+        int line = 1;         // position of the first character, 1-based
+        int column = 1;
+        uint32_t payload = 0; // index of the literal value of TOK_INTEGER, TOK_REAL and TOK_STRING,
+                              // the interned name of TOK_ID, an ast::SymbolId,
+                              // the lexer error number of TOK_ERROR, 0 for everything else
+    };
+
+    // value of a literal token, Token::payload is the index in the parser's table
+    union Literal
+    {
+        uint32_t intval;
+        double realval;
+        struct
+        {
+            uint32_t offset;  // the characters of a string literal in the parser's string pool
+            uint32_t size;
+        } str;
+    };
+}
+
+#endif // !PASCAL2C_SRC_PARSER_TOKEN_H_
@@ -0,0 +1,171 @@
+#include "parser/token_queue.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace pascal2c::parser
+{
+    // the string literal characters are kept in blocks of this many bytes, a longer
+    // literal gets a block of its own
+    static constexpr size_t kStringBlock = 1 << 16;
+
+    TokenQueue::TokenQueue(std::string_view source, size_t capacity)
+    {
+        lexer_.reset(LexerCreate());
+        if (lexer_ == nullptr)
+            throw std::bad_alloc();
+        LexerSetBytes(lexer_.get(), source.data(), source.size());
+        bytes_ = LexerBytes(lexer_.get());
+        line_table_ = std::make_shared<const ast::LineTable>(source);
+
+        size_t size = 2;
+        while (size < capacity)
+            size *= 2;
+        slots_.resize(size);
+        mask_ = size - 1;
+
+        producer_ = std::thread(&TokenQueue::Produce, this);
+    }
+
+    TokenQueue::~TokenQueue()
+    {
+        stop_.store(true, std::memory_order_relaxed);
+        producer_.join();
+    }
+
+    void TokenQueue::Produce()
+    {
+        try
+        {
+            while (true)
+            {
+                int kind = LexerNext(lexer_.get());
+                Slot slot;
+                switch (kind)
+                {
+                    case TOK_ERROR:
+                        slot.token.payload = LexerErrno(lexer_.get());
+                        break;
+                    case TOK_INTEGER:
+                        slot.value.intval = LexerValue(lexer_.get())->intval;
+                        break;
+                    case TOK_REAL:
+                        slot.value.realval = LexerValue(lexer_.get())->realval;
+                        break;
+                    case TOK_STRING:
+                        slot.value.str.size = LexerValue(lexer_.get())->strsize;
+                        slot.string = KeepString(LexerValue(lexer_.get())->strval, slot.value.str.size);
+                        break;
+                    default:
+                        break;
+                }
+
+                slot.token.kind = kind;
+                slot.token.line = LexerLine(lexer_.get());
+                slot.token.column = LexerColumn(lexer_.get());
+                if (kind != 0)
+                {
+                    slot.token.offset = LexerOffset(lexer_.get());
+                    slot.token.length = LexerLength(lexer_.get());
+                }
+                else
+                {
+                    // the end has no text, it is where the scanner left off
+                    slot.token.offset = line_table_->Offset(slot.token.line, slot.token.column);
+                }
+                if (!Push(slot) || kind == 0)
+                    return;
+            }
+        }
+        catch (...)
+        {
+            error_ = std::current_exception();
+            failed_.store(true, std::memory_order_release);
+        }
+    }
+
+    bool TokenQueue::Push(const Slot &slot)
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_cache_ > mask_)
+        {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head - tail_cache_ > mask_)
+            {
+                producer_stalls_.fetch_add(1, std::memory_order_relaxed);
+                do
+                {
+                    if (stop_.load(std::memory_order_relaxed))
+                        return false;
+                    std::this_thread::yield();
+                    tail_cache_ = tail_.load(std::memory_order_acquire);
+                } while (head - tail_cache_ > mask_);
+            }
+        }
+        slots_[head & mask_] = slot;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    const char *TokenQueue::KeepString(const char *chars, size_t size)
+    {
+        if (size > block_left_)
+        {
+            // the blocks never move, only the vector holding them does
+            size_t block = std::max(size, kStringBlock);
+            string_blocks_.emplace_back(new char[block]);
+            block_next_ = string_blocks_.back().get();
+            block_left_ = block;
+        }
+        char *kept = block_next_;
+        std::memcpy(kept, chars, size);
+        block_next_ += size;
+        block_left_ -= size;
+        return kept;
+    }
+
+    void TokenQueue::Next()
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail != 0 && current_.token.kind == 0)
+            return;
+
+        if (tail == head_cache_)
+        {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail == head_cache_)
+            {
+                consumer_stalls_++;
+                while (true)
+                {
+                    // every token pushed before the failure is taken before it is thrown
+                    bool failed = failed_.load(std::memory_order_acquire);
+                    head_cache_ = head_.load(std::memory_order_acquire);
+                    if (tail != head_cache_)
+                        break;
+                    if (failed)
+                        std::rethrow_exception(error_);
+                    std::this_thread::yield();
+                }
+            }
+        }
+        max_depth_ = std::max(max_depth_, head_cache_ - tail);
+
+        current_ = slots_[tail & mask_];
+        tail_.store(tail + 1, std::memory_order_release);
+        if (current_.token.kind == TOK_ID)
+            current_.token.payload = symbols_->Intern(text());
+    }
+
+    TokenQueue::Stats TokenQueue::stats() const
+    {
+        Stats stats;
+        stats.capacity = slots_.size();
+        stats.tokens = tail_.load(std::memory_order_relaxed);
+        stats.max_depth = max_depth_;
+        stats.producer_stalls = producer_stalls_.load(std::memory_order_relaxed);
+        stats.consumer_stalls = consumer_stalls_;
+        return stats;
+    }
+}
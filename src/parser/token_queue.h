@@ -0,0 +1,148 @@
+#ifndef PASCAL2C_SRC_PARSER_TOKEN_QUEUE_H_
+#define PASCAL2C_SRC_PARSER_TOKEN_QUEUE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "ast/interner.h"
+#include "ast/line_table.h"
+#include "parser/token.h"
+
+extern "C"
+{
+#include "lexer.h"
+}
+
+namespace pascal2c::parser
+{
+    // the tokens of one source, scanned on a thread of their own while the parser
+    // takes them one at a time, so scanning overlaps with building the ast
+    // the scanner pushes every token into a bounded ring and the parser pops it,
+    // one producer and one consumer that only meet at two atomic indexes, no lock
+    // a full ring stalls the scanner and an empty one stalls the parser, both wait
+    // by yielding their thread, stats() tells how often that happened
+    // usage:
+    //     TokenQueue queue(source);
+    //     for (queue.Next(); queue.token().kind != 0; queue.Next())
+    //         std::cout << queue.text() << std::endl;
+    class TokenQueue
+    {
+    public:
+        // counters for tuning the capacity, a scanner that stalls often wants a
+        // larger ring, a parser that stalls often is waiting for the scanner anyway
+        struct Stats
+        {
+            size_t capacity = 0;        // tokens the ring holds
+            size_t tokens = 0;          // tokens taken by the consumer so far
+            size_t max_depth = 0;       // most tokens seen waiting in the ring
+            size_t producer_stalls = 0; // times the scanner found the ring full
+            size_t consumer_stalls = 0; // times the consumer found the ring empty
+        };
+
+        static constexpr size_t kDefaultCapacity = 1 << 12;
+
+        // start scanning on a new thread, there is no current token until Next
+        // param:
+        //     source is the whole program text, it is copied before the constructor returns
+        //     capacity is the number of tokens the ring holds, rounded up to a power of two
+        // throw:
+        //     std::bad_alloc if the scanner cannot be created
+        explicit TokenQueue(std::string_view source, size_t capacity = kDefaultCapacity);
+
+        // stop the scanner if the consumer did not read to the end
+        ~TokenQueue();
+
+        TokenQueue(const TokenQueue &) = delete;
+        TokenQueue &operator=(const TokenQueue &) = delete;
+
+        // make the next token the current one, waiting for the scanner if need be
+        // the end of the input stays the current token once it is reached
+        // throw:
+        //     whatever stopped the scanner, eg. std::bad_alloc
+        void Next();
+
+        // the current token, its payload is only set for TOK_ERROR and TOK_ID
+        const Token &token() const { return current_.token; }
+
+        // return:
+        //     the text of the current token as scanned, identifiers lowercased
+        std::string_view text() const { return {bytes_ + current_.token.offset, current_.token.length}; }
+
+        // return:
+        //     the value of the current token if it is a literal, a zero literal otherwise
+        const Literal &value() const { return current_.value; }
+
+        // return:
+        //     the characters of the current token if it is a string literal
+        std::string_view string_value() const { return {current_.string, current_.value.str.size}; }
+
+        // return:
+        //     the counters so far, the consumer thread reads them
+        Stats stats() const;
+
+        // return:
+        //     where the lines of the source start, built before the scanner starts
+        const std::shared_ptr<const ast::LineTable> &line_table() const { return line_table_; }
+
+        // return:
+        //     the identifiers taken so far, the payload of a TOK_ID is its id in here
+        //     they are interned by Next, on the consumer thread, the scanner never sees them
+        std::shared_ptr<const ast::Interner> symbols() const { return symbols_; }
+
+    private:
+        // one token in the ring, string literal characters live in string_blocks_
+        struct Slot
+        {
+            Token token;
+            Literal value{};
+            const char *string = nullptr;
+        };
+
+        // the scanner thread
+        void Produce();
+
+        // param:
+        //     slot goes in the ring once there is room
+        // return:
+        //     false if the queue is being destroyed
+        bool Push(const Slot &slot);
+
+        // return:
+        //     a copy of the string literal characters the consumer can read until the queue is gone
+        const char *KeepString(const char *chars, size_t size);
+
+        std::unique_ptr<LexerState, void (*)(LexerState *)> lexer_{nullptr, LexerDestroy};
+        const char *bytes_ = nullptr; // the scanner's copy of the source, the token texts point into it
+        std::shared_ptr<const ast::LineTable> line_table_;
+        std::shared_ptr<ast::Interner> symbols_ = std::make_shared<ast::Interner>();
+        std::vector<Slot> slots_;
+        size_t mask_ = 0;             // slots_.size() - 1
+
+        // the producer's side, head_ is the count of tokens pushed
+        alignas(64) std::atomic<size_t> head_{0};
+        size_t tail_cache_ = 0;       // tail_ as last read, refreshed only when the ring looks full
+        std::vector<std::unique_ptr<char[]>> string_blocks_;
+        char *block_next_ = nullptr;  // the free bytes at the end of string_blocks_.back()
+        size_t block_left_ = 0;
+        std::atomic<size_t> producer_stalls_{0};
+        std::exception_ptr error_;
+        std::atomic<bool> failed_{false}; // error_ is set, nothing more will be pushed
+        std::atomic<bool> stop_{false};
+
+        // the consumer's side, tail_ is the count of tokens popped
+        alignas(64) std::atomic<size_t> tail_{0};
+        size_t head_cache_ = 0;       // head_ as last read, refreshed only when the ring looks empty
+        Slot current_;
+        size_t max_depth_ = 0;
+        size_t consumer_stalls_ = 0;
+
+        std::thread producer_;
+    };
+}
+
+#endif // !PASCAL2C_SRC_PARSER_TOKEN_QUEUE_H_
@@ -0,0 +1,61 @@
+#ifndef PASCAL2C_SRC_PARSER_TOKEN_SET_H_
+#define PASCAL2C_SRC_PARSER_TOKEN_SET_H_
+
+#include <cstdint>
+#include <initializer_list>
+
+extern "C"
+{
+#include "lexer.h"
+}
+
+namespace pascal2c::parser
+{
+    // fixed size set of tokens, one bit per token id
+    // covers the ascii tokens and everything token_generator.py emits, so a
+    // braced list like {';', TOK_END} is a handful of constant words and
+    // membership is a shift and a mask, no allocation anywhere
+    // usage:
+    //     static constexpr TokenSet kStatementEnd = {';', TOK_END, TOK_ELSE};
+    //     if (kStatementEnd.Contains(token_)) ...
+    class TokenSet
+    {
+    public:
+        // the largest token id plus one, TOK_MAX is the last generated token
+        static constexpr int kCapacity = TOK_MAX + 1;
+
+        constexpr TokenSet() = default;
+
+        // param:
+        //     tokens are the members of the set, each in [0, kCapacity)
+        constexpr TokenSet(std::initializer_list<int> tokens)
+        {
+            for (int token : tokens)
+                bits_[token / 64] |= uint64_t(1) << (token % 64);
+        }
+
+        // return:
+        //     true if token is in the set, false for ids out of range
+        constexpr bool Contains(int token) const
+        {
+            return token >= 0 && token < kCapacity && (bits_[token / 64] >> (token % 64) & 1);
+        }
+
+        // return:
+        //     the union of both sets
+        constexpr TokenSet operator|(const TokenSet &other) const
+        {
+            TokenSet res;
+            for (int i = 0; i < kWords; i++)
+                res.bits_[i] = bits_[i] | other.bits_[i];
+            return res;
+        }
+
+    private:
+        static constexpr int kWords = (kCapacity + 63) / 64;
+
+        uint64_t bits_[kWords] = {};
+    };
+}
+
+#endif // !PASCAL2C_SRC_PARSER_TOKEN_SET_H_
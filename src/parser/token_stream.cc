@@ -0,0 +1,243 @@
+#include "parser/token_stream.h"
+
+#include <algorithm>
+#include <future>
+#include <new>
+#include <thread>
+
+#include "thread_pool.hpp"
+
+namespace pascal2c::parser
+{
+    TokenStream::TokenStream(std::string_view source)
+    {
+        line_table_ = std::make_shared<const ast::LineTable>(source);
+        Scan(source);
+    }
+
+    TokenStream::TokenStream(std::string_view source, size_t threads, size_t min_chunk)
+    {
+        line_table_ = std::make_shared<const ast::LineTable>(source);
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        size_t chunks = std::min(threads, source.size() / std::max<size_t>(min_chunk, 1));
+
+        // every chunk starts after a newline, at column 1 and outside a string literal,
+        // only a comment can be open there
+        std::vector<size_t> starts = {0};
+        for (size_t i = 1; i < chunks; i++)
+        {
+            size_t newline = source.find('\n', std::max(starts.back(), source.size() / chunks * i));
+            if (newline == std::string_view::npos || newline + 1 == source.size())
+                break;
+            starts.push_back(newline + 1);
+        }
+        starts.push_back(source.size());
+
+        if (starts.size() < 3)
+            Scan(source);
+        else
+            ScanChunks(source, starts, threads);
+    }
+
+    std::unique_ptr<TokenStream> TokenStream::ScanChunk(std::string_view chunk)
+    {
+        std::unique_ptr<TokenStream> scan(new TokenStream());
+        scan->Scan(chunk);
+        return scan;
+    }
+
+    void TokenStream::Scan(std::string_view source)
+    {
+        lexer_.reset(LexerCreate());
+        if (lexer_ == nullptr)
+            throw std::bad_alloc();
+        LexerSetBytes(lexer_.get(), source.data(), source.size());
+        bytes_ = LexerBytes(lexer_.get());
+
+        // a rough guess of one token per five bytes saves most of the regrowth
+        size_t guess = source.size() / 5 + 1;
+        kinds_.reserve(guess);
+        offsets_.reserve(guess);
+        lengths_.reserve(guess);
+        lines_.reserve(guess);
+        columns_.reserve(guess);
+        payloads_.reserve(guess);
+        literals_.push_back(Literal{});
+
+        while (true)
+        {
+            int kind = LexerNext(lexer_.get());
+            uint32_t payload = 0;
+            Literal value{};
+            switch (kind)
+            {
+                case TOK_ID:
+                    payload = symbols_->Intern({LexerText(lexer_.get()), LexerLength(lexer_.get())});
+                    break;
+                case TOK_ERROR:
+                    payload = LexerErrno(lexer_.get());
+                    break;
+                case TOK_INTEGER:
+                    value.intval = LexerValue(lexer_.get())->intval;
+                    break;
+                case TOK_REAL:
+                    value.realval = LexerValue(lexer_.get())->realval;
+                    break;
+                case TOK_STRING:
+                    value.str.offset = strings_.size();
+                    value.str.size = LexerValue(lexer_.get())->strsize;
+                    strings_.append(LexerValue(lexer_.get())->strval, value.str.size);
+                    break;
+                default:
+                    break;
+            }
+            if (kind == TOK_INTEGER || kind == TOK_REAL || kind == TOK_STRING)
+            {
+                payload = literals_.size();
+                literals_.push_back(value);
+            }
+
+            kinds_.push_back(kind);
+            lines_.push_back(LexerLine(lexer_.get()));
+            columns_.push_back(LexerColumn(lexer_.get()));
+            payloads_.push_back(payload);
+            if (kind == 0)
+            {
+                // the end has no text, it is where the scanner left off,
+                // a chunk has no table and its end is dropped anyway
+                offsets_.push_back(line_table_ ? line_table_->Offset(lines_.back(), columns_.back()) : 0);
+                lengths_.push_back(0);
+                break;
+            }
+            offsets_.push_back(LexerOffset(lexer_.get()));
+            lengths_.push_back(LexerLength(lexer_.get()));
+        }
+    }
+
+    void TokenStream::ScanChunks(std::string_view source, const std::vector<size_t> &starts, size_t threads)
+    {
+        size_t count = starts.size() - 1;
+        auto chunk = [&](size_t first, size_t last) {
+            return source.substr(starts[first], starts[last] - starts[first]);
+        };
+        auto ends_in_comment = [](const TokenStream &scan) {
+            size_t last = scan.size() - 1;
+            return last > 0 && scan.kinds_[last - 1] == TOK_ERROR && scan.payloads_[last - 1] == ERR_EOF_IN_COMMENT;
+        };
+
+        ThreadPool pool(std::min(threads, count));
+        std::vector<std::future<std::unique_ptr<TokenStream>>> scans;
+        scans.reserve(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            scans.push_back(pool.Submit([&chunk, i] { return ScanChunk(chunk(i, i + 1)); }));
+        }
+
+        // take the scans in order while the later ones are still running and
+        // work out where each goes in the stitched arrays
+        std::vector<std::unique_ptr<TokenStream>> parts;
+        std::vector<Stitch> places;
+        std::vector<std::vector<ast::SymbolId>> symbols; // of every part, see Place
+        Stitch at{0, 0, 0, 1, 0, 0};
+        for (size_t i = 0, next; i < count; i = next)
+        {
+            std::unique_ptr<TokenStream> scan = scans[i].get();
+            next = i + 1;
+            if (next < count && ends_in_comment(*scan))
+            {
+                // the comment goes on in the next chunk, whose scan started outside of it,
+                // both are scanned again as one, a comment longer than that makes the
+                // rest of the source one chunk so no byte is scanned more than three times
+                next++;
+                scan = ScanChunk(chunk(i, next));
+                if (next < count && ends_in_comment(*scan))
+                {
+                    next = count;
+                    scan = ScanChunk(chunk(i, next));
+                }
+            }
+            at.offset = starts[i];
+            at.bytes = starts[next] - starts[i];
+            places.push_back(at);
+            at.token += scan->size() - 1;
+            at.literal += scan->literals_.size() - 1;
+            at.string += scan->strings_.size();
+            at.lines += scan->lines_.back() - 1;
+            // the names of a chunk are interned in the order of the chunks, so the ids
+            // are the ones a single scan hands out
+            symbols.emplace_back(scan->symbols_->size());
+            for (ast::SymbolId id = 0; id < symbols.back().size(); id++)
+                symbols.back()[id] = symbols_->Intern(scan->symbols_->Name(id));
+            parts.push_back(std::move(scan));
+        }
+
+        // the end of the input is the one of the last chunk
+        kinds_.resize(at.token + 1, 0);
+        offsets_.resize(at.token + 1, 0);
+        lengths_.resize(at.token + 1, 0);
+        lines_.resize(at.token + 1, at.lines + 1);
+        columns_.resize(at.token + 1, parts.back()->columns_.back());
+        payloads_.resize(at.token + 1, 0);
+        offsets_[at.token] = line_table_->Offset(lines_[at.token], columns_[at.token]);
+        literals_.resize(at.literal, Literal{});
+        strings_.resize(at.string);
+        chunks_.resize(source.size());
+        bytes_ = chunks_.data();
+
+        std::vector<std::future<void>> copies;
+        for (size_t i = 0; i < parts.size(); i++)
+        {
+            copies.push_back(pool.Submit([this, &parts, &places, &symbols, i] { Place(*parts[i], places[i], symbols[i]); }));
+        }
+        for (auto &copy : copies)
+        {
+            copy.get();
+        }
+    }
+
+    void TokenStream::Place(const TokenStream &chunk, const Stitch &at, const std::vector<ast::SymbolId> &symbols)
+    {
+        size_t tokens = chunk.size() - 1;
+        std::copy(chunk.bytes_, chunk.bytes_ + at.bytes, chunks_.begin() + at.offset);
+        std::copy(chunk.strings_.begin(), chunk.strings_.end(), strings_.begin() + at.string);
+        for (size_t i = 0; i < tokens; i++)
+        {
+            int kind = chunk.kinds_[i];
+            uint32_t payload = chunk.payloads_[i];
+            if (kind == TOK_INTEGER || kind == TOK_REAL || kind == TOK_STRING)
+            {
+                Literal value = chunk.literals_[payload];
+                if (kind == TOK_STRING)
+                    value.str.offset += at.string;
+                payload += at.literal - 1;
+                literals_[payload] = value;
+            }
+            else if (kind == TOK_ID)
+            {
+                payload = symbols[payload];
+            }
+
+            size_t j = at.token + i;
+            kinds_[j] = kind;
+            offsets_[j] = chunk.offsets_[i] + at.offset;
+            lengths_[j] = chunk.lengths_[i];
+            lines_[j] = chunk.lines_[i] + at.lines;
+            columns_[j] = chunk.columns_[i];
+            payloads_[j] = payload;
+        }
+    }
+
+    Token TokenStream::operator[](size_t i) const
+    {
+        i = Clamp(i);
+        Token token;
+        token.kind = kinds_[i];
+        token.offset = offsets_[i];
+        token.length = lengths_[i];
+        token.line = lines_[i];
+        token.column = columns_[i];
+        token.payload = payloads_[i];
+        return token;
+    }
+}
@@ -0,0 +1,161 @@
+#ifndef PASCAL2C_SRC_PARSER_TOKEN_STREAM_H_
+#define PASCAL2C_SRC_PARSER_TOKEN_STREAM_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ast/interner.h"
+#include "ast/line_table.h"
+#include "parser/token.h"
+
+extern "C"
+{
+#include "lexer.h"
+}
+
+namespace pascal2c::parser
+{
+    // every token of one source, scanned in a single pass before parsing starts
+    // the fields live in parallel arrays (kinds, offsets, lengths, lines, columns,
+    // payloads) so walking the kinds touches nothing else, any token can be
+    // looked at by index, and the stream can be scanned once and handed to
+    // other tools
+    // the last token is always the end of the input (kind 0), indexes past it
+    // read that token again, like the scanner keeps returning 0 at the end
+    // a large source can be scanned by several threads, each scans a chunk of
+    // whole lines as if nothing was open before it and the chunks are stitched
+    // together, giving the same tokens as a single scan
+    // usage:
+    //     TokenStream tokens(source);
+    //     for (size_t i = 0; tokens.kind(i) != 0; i++)
+    //         std::cout << tokens.text(i) << std::endl;
+    class TokenStream
+    {
+    public:
+        // param:
+        //     source is the whole program text, it is copied by the scanner
+        explicit TokenStream(std::string_view source);
+
+        // the default min_chunk, below this starting a thread costs more than it saves
+        static constexpr size_t kMinChunk = 1 << 20;
+
+        // scan source in chunks on several threads
+        // a chunk that ends inside a { } comment is scanned again together with
+        // the next one, whose own scan wrongly started outside the comment,
+        // string literals end at the end of the line so they never reach into the
+        // next chunk
+        // param:
+        //     source is the whole program text, it is copied
+        //     threads is the number of threads scanning chunks at the same time,
+        //     0 means one per hardware thread
+        //     min_chunk is the fewest bytes worth a thread of their own, a source
+        //     smaller than two chunks is scanned on the calling thread
+        TokenStream(std::string_view source, size_t threads, size_t min_chunk = kMinChunk);
+
+        TokenStream(const TokenStream &) = delete;
+        TokenStream &operator=(const TokenStream &) = delete;
+
+        // return:
+        //     the number of tokens including the end of the input
+        size_t size() const { return kinds_.size(); }
+
+        int kind(size_t i) const { return kinds_[Clamp(i)]; }
+        int line(size_t i) const { return lines_[Clamp(i)]; }
+        int column(size_t i) const { return columns_[Clamp(i)]; }
+
+        // return:
+        //     the text of token i as scanned, identifiers lowercased
+        std::string_view text(size_t i) const
+        {
+            i = Clamp(i);
+            return {bytes_ + offsets_[i], lengths_[i]};
+        }
+
+        // return:
+        //     the value of token i if it is a literal, a zero literal otherwise
+        const Literal &value(size_t i) const
+        {
+            i = Clamp(i);
+            return literals_[kinds_[i] == TOK_ERROR || kinds_[i] == TOK_ID ? 0 : payloads_[i]];
+        }
+
+        // return:
+        //     the characters of the string literal i
+        std::string_view string_value(size_t i) const
+        {
+            const Literal &literal = value(i);
+            return {strings_.data() + literal.str.offset, literal.str.size};
+        }
+
+        // return:
+        //     all fields of token i in one record
+        Token operator[](size_t i) const;
+
+        // return:
+        //     where the lines of the source start, the nodes parsed from it keep offsets into it
+        const std::shared_ptr<const ast::LineTable> &line_table() const { return line_table_; }
+
+        // return:
+        //     the identifiers of the source, the payload of a TOK_ID is its id in here
+        std::shared_ptr<const ast::Interner> symbols() const { return symbols_; }
+
+    private:
+        TokenStream() = default;
+
+        // return:
+        //     the tokens of a chunk of the source, without a line table
+        static std::unique_ptr<TokenStream> ScanChunk(std::string_view chunk);
+
+        size_t Clamp(size_t i) const { return i < kinds_.size() ? i : kinds_.size() - 1; }
+
+        // scan the whole source with one scanner
+        void Scan(std::string_view source);
+
+        // scan the chunks of source starting at the offsets in starts on a pool of threads,
+        // starts ends with source.size()
+        void ScanChunks(std::string_view source, const std::vector<size_t> &starts, size_t threads);
+
+        // where the bytes and tokens of a chunk go in a source scanned in chunks
+        struct Stitch
+        {
+            size_t offset;  // byte offset of the chunk in the source
+            size_t bytes;   // its length in bytes
+            size_t token;   // index of its first token
+            size_t literal; // index of its first literal, the zero literal of its scan is dropped
+            size_t string;  // offset of its first string literal character
+            int lines;      // lines before the chunk
+        };
+
+        // copy the bytes and tokens of a chunk but its end of the input to their place,
+        // the arrays have their final size already so the chunks can be copied at the same time
+        // param:
+        //     chunk is the scan of the chunk on its own
+        //     at is where it goes
+        //     symbols are the ids in symbols_ of the ids the chunk interned on its own
+        void Place(const TokenStream &chunk, const Stitch &at, const std::vector<ast::SymbolId> &symbols);
+
+        // the scanner is kept for its copy of the source, the token texts point into it
+        // a source scanned in chunks has the chunks' copies stitched together in chunks_
+        std::unique_ptr<LexerState, void (*)(LexerState *)> lexer_{nullptr, LexerDestroy};
+        std::string chunks_;
+        const char *bytes_ = nullptr;
+
+        std::vector<int> kinds_;
+        std::vector<uint32_t> offsets_;
+        std::vector<uint32_t> lengths_;
+        std::vector<int> lines_;
+        std::vector<int> columns_;
+        std::vector<uint32_t> payloads_;  // see Token::payload
+
+        std::vector<Literal> literals_;   // literals_[0] is the zero of the non-literal tokens
+        std::string strings_;             // characters of the string literals one after another
+
+        std::shared_ptr<const ast::LineTable> line_table_;
+        std::shared_ptr<ast::Interner> symbols_ = std::make_shared<ast::Interner>();
+    };
+}
+
+#endif // !PASCAL2C_SRC_PARSER_TOKEN_STREAM_H_
@@ -3,15 +3,32 @@
 #include "semantic_analysis.h"
 #define LOG(message) \
     do{\
-        errors.push_back(analysiser::errorMsg(x.line(),x.column(),message));\
+        errors.push_back(analysiser::errorMsg(x.line(*lines),x.column(*lines),message));\
     }while(0)
 namespace analysiser{
-    std::vector<std::string> blockNames;//memary name of the latest block
-    std::string nowblockName; 
-    nameTable table;
-    std::vector<errorMsg> errors;
+    //analysis state is per thread so that compilations on different threads never meet,
+    //init() resets it before every compilation
+    thread_local std::vector<std::string> blockNames;//memary name of the latest block
+    thread_local std::string nowblockName; 
+    thread_local std::shared_ptr<symbol_table::SymbolTableBlock> nowBlock;//block named nowblockName
+    thread_local nameTable table;
+    thread_local std::vector<errorMsg> errors;
+    //lines of the source being analysed, the errors and the block names take their positions from it
+    thread_local std::shared_ptr<const pascal2c::ast::LineTable> lines;
+    //identifiers of the source being analysed, the nodes and the items name them by their ids in it
+    thread_local std::shared_ptr<const pascal2c::ast::Interner> symbols;
+    //types of the shared nodes typed in nowBlock, a node the parser
+    //hash-consed is typed once however many expressions it is part of
+    thread_local std::unordered_map<const pascal2c::ast::Expression *,symbol_table::MegaType> sharedTypes;
     std::vector<errorMsg> GetErrors()    {return errors;}
     nameTable* GetTable() {return &table;}
+    const pascal2c::ast::Interner* GetSymbols() {return symbols.get();}
+    //item named by id, its name is the interned one
+    template<typename Type>
+    static symbol_table::SymbolTableItem ItemOf(Type type,pascal2c::ast::SymbolId id,bool is_var,bool is_func,std::vector<symbol_table::SymbolTablePara> para={})
+    {
+        return symbol_table::SymbolTableItem(type,id,symbols->Name(id),is_var,is_func,std::move(para));
+    }
 
     bool nameTable::Add(std::string name)
     {
@@ -21,21 +38,23 @@ namespace analysiser{
         else 
             return false;
     }
+    void nameTable::Clear()
+    {
+        table_.clear();
+    }
     bool nameTable::Query(std::string name, std::shared_ptr<symbol_table::SymbolTableBlock> &ansblock)
     {
         if(table_.find(name)==table_.end())
             return false;
         else 
         {
-            ansblock=table_[name];
+            ansblock=table_.find(name)->second;
             return true;
         }
     }
     saERRORS::ERROR_TYPE Find(symbol_table::SymbolTableItem &x)
     {
-        std::shared_ptr<symbol_table::SymbolTableBlock> ans;
-        table.Query(nowblockName,ans);
-        return ans->Query(x);
+        return nowBlock->Query(x);
     }
     saERRORS::ERROR_TYPE Insert(const symbol_table::SymbolTableItem &x)
     {
@@ -43,30 +62,37 @@ namespace analysiser{
         {
             return saERRORS::ITEM_ERROR;
         }
-        std::shared_ptr<symbol_table::SymbolTableBlock> nowBlock;
-        table.Query(nowblockName,nowBlock);
         return nowBlock->AddItem(x);
     }
-    void init()
+    void init(std::shared_ptr<const pascal2c::ast::LineTable> source_lines,std::shared_ptr<const pascal2c::ast::Interner> source_symbols)
     {
+        lines = std::move(source_lines);
+        symbols = std::move(source_symbols);
+        blockNames.clear();
+        errors.clear();
+        table.Clear();
+        sharedTypes.clear();
         nowblockName = "__main__";
         table.Add(nowblockName);
+        table.Query(nowblockName,nowBlock);
     }
     void BlockExit()
     {
         nowblockName = blockNames[blockNames.size()-1];
         blockNames.pop_back();
+        table.Query(nowblockName,nowBlock);
+        sharedTypes.clear();
     }
     void BlockIn(std::string name)
     {
         blockNames.push_back(nowblockName);
         table.Add(name);
-        std::shared_ptr<symbol_table::SymbolTableBlock> af;
         std::shared_ptr<symbol_table::SymbolTableBlock> as;
-        table.Query(nowblockName,af);
         table.Query(name,as);
-        as->Locate(af);
+        as->Locate(nowBlock);
         nowblockName = name;
+        nowBlock = as;
+        sharedTypes.clear();
     }
     symbol_table::MegaType MaxType(symbol_table::MegaType x, symbol_table::MegaType y)
     {
@@ -89,42 +115,56 @@ namespace analysiser{
                 return symbol_table::MegaType(symbol_table::INT);
         }
     }
-    bool ExprIsVar(std::shared_ptr<pascal2c::ast::Expression> x)
+    bool ExprIsVar(const std::shared_ptr<pascal2c::ast::Expression> &x)
     {
-        switch(x->GetType())
-        {
-            case pascal2c::ast::INT:
-            case pascal2c::ast::REAL:
-            case pascal2c::ast::CHAR:
-            case pascal2c::ast::BOOLEAN:
-            case pascal2c::ast::STRING:
-            case pascal2c::ast::CALL:
-                return false;
-            case pascal2c::ast::VARIABLE:
-                return true;
-            case pascal2c::ast::CALL_OR_VAR:
+        //an expression is a variable if all of its leaves are,
+        //the operands wait on a stack so nesting depth costs no call stack
+        std::vector<const pascal2c::ast::Expression *> pending{x.get()};
+        while(!pending.empty())
+        {
+            const pascal2c::ast::Expression *now=pending.back();
+            pending.pop_back();
+            switch(now->GetType())
             {
-                std::shared_ptr<pascal2c::ast::CallOrVar> now=std::static_pointer_cast<pascal2c::ast::CallOrVar>(x);
-                symbol_table::SymbolTableItem tgt1(symbol_table::ERROR,now->id(),true,false,std::vector<symbol_table::SymbolTablePara>());
-                if(Find(tgt1)==saERRORS::NO_ERROR)
+                case pascal2c::ast::INT:
+                case pascal2c::ast::REAL:
+                case pascal2c::ast::CHAR:
+                case pascal2c::ast::BOOLEAN:
+                case pascal2c::ast::STRING:
+                case pascal2c::ast::CALL:
+                    return false;
+                case pascal2c::ast::VARIABLE:
+                    break;
+                case pascal2c::ast::CALL_OR_VAR:
                 {
-                    return true;
+                    const pascal2c::ast::CallOrVar *var=static_cast<const pascal2c::ast::CallOrVar *>(now);
+                    symbol_table::SymbolTableItem tgt1=ItemOf(symbol_table::ERROR,var->symbol(),true,false);
+                    if(Find(tgt1)!=saERRORS::NO_ERROR)
+                    {
+                        return false;
+                    }
+                    break;
                 }
-                return false;
-            }
-            case pascal2c::ast::BINARY:
-            {
-                std::shared_ptr<pascal2c::ast::BinaryExpr> now=std::static_pointer_cast<pascal2c::ast::BinaryExpr>(x);
-                return ExprIsVar(now->lhs())&&ExprIsVar(now->rhs());
-            }
-            case pascal2c::ast::UNARY:
-            {
-                return ExprIsVar(std::static_pointer_cast<pascal2c::ast::UnaryExpr>(x)->factor());
+                case pascal2c::ast::BINARY:
+                {
+                    const pascal2c::ast::BinaryExpr *bin=static_cast<const pascal2c::ast::BinaryExpr *>(now);
+                    pending.push_back(bin->rhs().get());
+                    pending.push_back(bin->lhs().get());
+                    break;
+                }
+                case pascal2c::ast::UNARY:
+                {
+                    pending.push_back(static_cast<const pascal2c::ast::UnaryExpr *>(now)->factor().get());
+                    break;
+                }
+                default:
+                    return false;
             }
         }
-        return false;
+        return true;
     }
-    symbol_table::MegaType GetExprType(std::shared_ptr<pascal2c::ast::Expression> x)
+    //type of an expression that is neither binary nor unary
+    static symbol_table::MegaType AtomType(const pascal2c::ast::Expression *x)
     {
         symbol_table::MegaType ret(symbol_table::ERROR);
         switch(x->GetType())
@@ -156,9 +196,9 @@ namespace analysiser{
             }
             case pascal2c::ast::VARIABLE:
             {
-                std::shared_ptr<pascal2c::ast::Variable> now=std::static_pointer_cast<pascal2c::ast::Variable>(x);
+                const pascal2c::ast::Variable *now=static_cast<const pascal2c::ast::Variable *>(x);
                 std::vector<symbol_table::SymbolTablePara> para;
-                for(auto i:now->expr_list())
+                for(const auto &i:now->expr_list())
                 {
                     para.push_back(symbol_table::SymbolTablePara(GetExprType(i),ExprIsVar(i),""));
                 }
@@ -169,7 +209,7 @@ namespace analysiser{
                 }
                 else 
                 {
-                    pascal2c::ast::Ast x=(*now);
+                    const pascal2c::ast::Ast &x=*now;
                     std::stringstream ss;
                     ss<<tgt1;
                     LOG("variable "+ss.str()+" not found");
@@ -178,29 +218,29 @@ namespace analysiser{
             }
             case pascal2c::ast::CALL:
             {
-                std::shared_ptr<pascal2c::ast::CallValue> now=std::static_pointer_cast<pascal2c::ast::CallValue>(x);
+                const pascal2c::ast::CallValue *now=static_cast<const pascal2c::ast::CallValue *>(x);
                 std::vector<symbol_table::SymbolTablePara> para;
-                for(auto i:now->params())
+                for(const auto &i:now->params())
                 {
                     para.push_back(symbol_table::SymbolTablePara(GetExprType(i).type(),ExprIsVar(i),""));
                 }
-                symbol_table::SymbolTableItem tgt1(symbol_table::ERROR,now->id(),false,true,para);
+                symbol_table::SymbolTableItem tgt1=ItemOf(symbol_table::ERROR,now->symbol(),false,true,para);
                 if(Find(tgt1)==saERRORS::NO_ERROR)
                 {
                     ret=tgt1.type();
                 }
                 else 
                 {
-                    pascal2c::ast::Ast x=(*now);
+                    const pascal2c::ast::Ast &x=*now;
                     LOG("function "+now->id()+" not found");
                 }
                 break;
             }
             case pascal2c::ast::CALL_OR_VAR:
             {
-                std::shared_ptr<pascal2c::ast::CallOrVar> now=std::static_pointer_cast<pascal2c::ast::CallOrVar>(x);
-                symbol_table::SymbolTableItem tgt1(symbol_table::ERROR,now->id(),true,false,std::vector<symbol_table::SymbolTablePara>());
-                symbol_table::SymbolTableItem tgt2(symbol_table::ERROR,now->id(),false,true,std::vector<symbol_table::SymbolTablePara>());
+                const pascal2c::ast::CallOrVar *now=static_cast<const pascal2c::ast::CallOrVar *>(x);
+                symbol_table::SymbolTableItem tgt1=ItemOf(symbol_table::ERROR,now->symbol(),true,false);
+                symbol_table::SymbolTableItem tgt2=ItemOf(symbol_table::ERROR,now->symbol(),false,true);
                 if(Find(tgt1)==saERRORS::NO_ERROR)
                 {
                     ret=tgt1.type();
@@ -211,168 +251,91 @@ namespace analysiser{
                 }
                 else 
                 {
-                    pascal2c::ast::Ast x=(*now);
+                    const pascal2c::ast::Ast &x=*now;
                     LOG(now->id()+" not found");
                 }
                 break;
             }
-            case pascal2c::ast::BINARY:
+            default:
+                break;
+        }
+        return ret;
+    }
+    //and, or and mod look at the right operand only if the left one has the type they need
+    static bool SkipsRhs(const pascal2c::ast::BinaryExpr *now,const symbol_table::MegaType &lhs)
+    {
+        switch(now->op())
+        {
+            case 262:case 283:
+                return lhs!=symbol_table::BOOL;
+            case 279:
+                return !(lhs==symbol_table::INT);
+        }
+        return false;
+    }
+    //type of a binary expression from the types of its operands,
+    //rhs is ERROR if SkipsRhs
+    static symbol_table::MegaType BinaryExprType(const pascal2c::ast::BinaryExpr *now,const symbol_table::MegaType &lhs,const symbol_table::MegaType &rhs)
+    {
+        symbol_table::MegaType ret(symbol_table::ERROR);
+        switch(now->op())
+        {
+            case '=':case '>':case '<':case 306:case 305:case 304:
             {
-                std::shared_ptr<pascal2c::ast::BinaryExpr> now=std::static_pointer_cast<pascal2c::ast::BinaryExpr>(x);
-                switch(now->op())
+                symbol_table::MegaType tyl=lhs;
+                symbol_table::MegaType tyr=rhs;
+                symbol_table::MegaType ty=MaxType(tyl,tyr);
+                if(ty!=symbol_table::ERROR)
                 {
-                    case '=':case '>':case '<':case 306:case 305:case 304:
-                    {
-                        symbol_table::MegaType tyl=GetExprType(now->lhs());
-                        symbol_table::MegaType tyr=GetExprType(now->rhs());
-                        symbol_table::MegaType ty=MaxType(tyl,tyr);
-                        if(ty!=symbol_table::ERROR)
-                        {
-                            ret.settype(symbol_table::BOOL);
-                        }
-                        else 
-                        {
-                            pascal2c::ast::Ast x=(*now);
-                            std::string mes="";
-                            if(tyl!=symbol_table::ERROR&&tyr!=symbol_table::ERROR)
-                            {
-                                std::stringstream ss;
-                                ss<<":left:"<<tyl<<" "<<"right:"<<tyr;
-                                mes=ss.str();
-                            }
-                            LOG("illegal type between comparison expression"+mes);
-                        }
-                        break;
-                    }
-                    case 262:case 283:
-                    {
-                        symbol_table::MegaType ty=GetExprType(now->lhs());
-                        if(ty!=symbol_table::BOOL)
-                        {
-                            pascal2c::ast::Ast x=(*now);
-                            std::stringstream ss;
-                            std::string mes="";
-                            ss<<ty;
-                            mes=ss.str();
-                            LOG("illegal type between boolean expression,got "+mes);
-                            break;
-                        }
-                        ty=GetExprType(now->rhs());
-                        if(ty!=symbol_table::BOOL)
-                        {
-                            pascal2c::ast::Ast x=(*now);
-                            std::stringstream ss;
-                            std::string mes="";
-                            ss<<ty;
-                            mes=ss.str();
-                            LOG("illegal type between boolean expression,got "+mes);
-                            break;
-                        }
-                        ret.settype(symbol_table::BOOL);
-                        break;
-                    }
-                    case '+':case '-':case '*':
-                    {
-                        symbol_table::MegaType ty=MaxType(GetExprType(now->lhs()),GetExprType(now->rhs()));
-                        if(ty.pointer().size()!=0)
-                        {
-                            pascal2c::ast::Ast x=(*now);
-                            std::string mes="";
-                            if(ty.type()!=symbol_table::ERROR)
-                            {
-                                std::stringstream ss;
-                                ss<<":got ";
-                                ss<<ty;
-                                mes=ss.str(); 
-                            }
-                            LOG("illegal type between compute expression"+mes);
-                        }
-                        else if(ty.type()==symbol_table::REAL||ty.type()==symbol_table::INT)
-                        {
-                            ret.settype(ty.type());
-                        }
-                        else 
-                        {
-                            pascal2c::ast::Ast x=(*now);
-                            std::string mes=":type not match";
-                            if(ty.type()!=symbol_table::ERROR)
-                            {
-                                std::stringstream ss;
-                                ss<<":got "<<ty.type();
-                                mes=ss.str();
-                            }
-                            LOG("illegal type between compute expression"+mes);
-                        }
-                        break;
-                    }
-                    case 267:
-                    {
-                        symbol_table::MegaType lty=GetExprType(now->lhs()),rty=GetExprType(now->rhs());
-                        if(lty.type()==symbol_table::INT&&rty.type()==symbol_table::INT)
-                        {
-                            ret.settype(symbol_table::INT);
-                        }
-                        else 
-                        {
-                            pascal2c::ast::Ast x=(*now);
-                            std::stringstream ss;
-                            ss<<":got ";
-                            ss<<lty<<" "<<rty;
-                            LOG("illegal type between compute expression"+ss.str());
-                        }
-                        break;
-                    }
-                    case 279:
-                    {
-                        if(GetExprType(now->lhs())==symbol_table::INT&&GetExprType(now->rhs())==symbol_table::INT)
-                        {
-                            ret.settype(symbol_table::INT);
-                        }
-                        else 
-                        {
-                            pascal2c::ast::Ast x=(*now);
-                            LOG("illegal type in mod expression");
-                        }
-                        break;
-                    }
-                    case '/':
+                    ret.settype(symbol_table::BOOL);
+                }
+                else 
+                {
+                    const pascal2c::ast::Ast &x=*now;
+                    std::string mes="";
+                    if(tyl!=symbol_table::ERROR&&tyr!=symbol_table::ERROR)
                     {
-                        symbol_table::MegaType ty=MaxType(GetExprType(now->lhs()),GetExprType(now->rhs()));
-                        if(ty.pointer().size()!=0)
-                        {
-                            pascal2c::ast::Ast x=(*now);
-                            std::string mes="";
-                            if(ty.type()!=symbol_table::ERROR)
-                            {
-                                std::stringstream ss;
-                                ss<<":got ";
-                                ss<<ty;
-                                mes=ss.str(); 
-                            }
-                            LOG("illegal type between compute expression"+mes);
-                        }
-                        else if(ty.type()==symbol_table::REAL||ty.type()==symbol_table::INT)
-                        {
-                            ret.settype(symbol_table::REAL);
-                        }
-                        else 
-                        {
-                            pascal2c::ast::Ast x=(*now);
-                            std::stringstream ss;ss<<GetExprType(now->lhs());
-                            LOG("illegal type in '/' expression"+ss.str());
-                        }
-                        break;
+                        std::stringstream ss;
+                        ss<<":left:"<<tyl<<" "<<"right:"<<tyr;
+                        mes=ss.str();
                     }
+                    LOG("illegal type between comparison expression"+mes);
+                }
+                break;
+            }
+            case 262:case 283:
+            {
+                symbol_table::MegaType ty=lhs;
+                if(ty!=symbol_table::BOOL)
+                {
+                    const pascal2c::ast::Ast &x=*now;
+                    std::stringstream ss;
+                    std::string mes="";
+                    ss<<ty;
+                    mes=ss.str();
+                    LOG("illegal type between boolean expression,got "+mes);
+                    break;
                 }
+                ty=rhs;
+                if(ty!=symbol_table::BOOL)
+                {
+                    const pascal2c::ast::Ast &x=*now;
+                    std::stringstream ss;
+                    std::string mes="";
+                    ss<<ty;
+                    mes=ss.str();
+                    LOG("illegal type between boolean expression,got "+mes);
+                    break;
+                }
+                ret.settype(symbol_table::BOOL);
                 break;
             }
-            case pascal2c::ast::UNARY: 
+            case '+':case '-':case '*':
             {
-                std::shared_ptr<pascal2c::ast::UnaryExpr> now=std::static_pointer_cast<pascal2c::ast::UnaryExpr>(x);
-                symbol_table::MegaType ty=GetExprType(now->factor());
+                symbol_table::MegaType ty=MaxType(lhs,rhs);
                 if(ty.pointer().size()!=0)
                 {
-                    pascal2c::ast::Ast x=(*now);
+                    const pascal2c::ast::Ast &x=*now;
                     std::string mes="";
                     if(ty.type()!=symbol_table::ERROR)
                     {
@@ -381,37 +344,209 @@ namespace analysiser{
                         ss<<ty;
                         mes=ss.str(); 
                     }
-                    LOG("illegal type in unary expression"+mes);
+                    LOG("illegal type between compute expression"+mes);
                 }
-                else if(now->op()==281)
+                else if(ty.type()==symbol_table::REAL||ty.type()==symbol_table::INT)
                 {
-                    if(ty.type()!=symbol_table::BOOL)
+                    ret.settype(ty.type());
+                }
+                else 
+                {
+                    const pascal2c::ast::Ast &x=*now;
+                    std::string mes=":type not match";
+                    if(ty.type()!=symbol_table::ERROR)
                     {
-                        pascal2c::ast::Ast x=(*now);
                         std::stringstream ss;
-                        ss<<ty.type();
-                        LOG("illegal type in unary expression:got "+ss.str());
+                        ss<<":got "<<ty.type();
+                        mes=ss.str();
                     }
-                    else
+                    LOG("illegal type between compute expression"+mes);
+                }
+                break;
+            }
+            case 267:
+            {
+                symbol_table::MegaType lty=lhs,rty=rhs;
+                if(lty.type()==symbol_table::INT&&rty.type()==symbol_table::INT)
+                {
+                    ret.settype(symbol_table::INT);
+                }
+                else 
+                {
+                    const pascal2c::ast::Ast &x=*now;
+                    std::stringstream ss;
+                    ss<<":got ";
+                    ss<<lty<<" "<<rty;
+                    LOG("illegal type between compute expression"+ss.str());
+                }
+                break;
+            }
+            case 279:
+            {
+                if(lhs==symbol_table::INT&&rhs==symbol_table::INT)
+                {
+                    ret.settype(symbol_table::INT);
+                }
+                else 
+                {
+                    const pascal2c::ast::Ast &x=*now;
+                    LOG("illegal type in mod expression");
+                }
+                break;
+            }
+            case '/':
+            {
+                symbol_table::MegaType ty=MaxType(lhs,rhs);
+                if(ty.pointer().size()!=0)
+                {
+                    const pascal2c::ast::Ast &x=*now;
+                    std::string mes="";
+                    if(ty.type()!=symbol_table::ERROR)
                     {
-                        ret.settype(symbol_table::BOOL);
+                        std::stringstream ss;
+                        ss<<":got ";
+                        ss<<ty;
+                        mes=ss.str(); 
                     }
-                    break;
+                    LOG("illegal type between compute expression"+mes);
                 }
-                if(ty.type()==symbol_table::REAL||ty.type()==symbol_table::INT)
+                else if(ty.type()==symbol_table::REAL||ty.type()==symbol_table::INT)
                 {
-                    ret.settype(ty.type());
+                    ret.settype(symbol_table::REAL);
                 }
                 else 
                 {
-                    pascal2c::ast::Ast x=(*now);
-                    LOG("illegal type in unary expression");
+                    const pascal2c::ast::Ast &x=*now;
+                    std::stringstream ss;ss<<lhs;
+                    LOG("illegal type in '/' expression"+ss.str());
                 }
                 break;
             }
         }
         return ret;
     }
+    //type of a unary expression from the type of its operand
+    static symbol_table::MegaType UnaryExprType(const pascal2c::ast::UnaryExpr *now,const symbol_table::MegaType &ty)
+    {
+        symbol_table::MegaType ret(symbol_table::ERROR);
+        if(ty.pointer().size()!=0)
+        {
+            const pascal2c::ast::Ast &x=*now;
+            std::string mes="";
+            if(ty.type()!=symbol_table::ERROR)
+            {
+                std::stringstream ss;
+                ss<<":got ";
+                ss<<ty;
+                mes=ss.str(); 
+            }
+            LOG("illegal type in unary expression"+mes);
+        }
+        else if(now->op()==281)
+        {
+            if(ty.type()!=symbol_table::BOOL)
+            {
+                const pascal2c::ast::Ast &x=*now;
+                std::stringstream ss;
+                ss<<ty.type();
+                LOG("illegal type in unary expression:got "+ss.str());
+            }
+            else
+            {
+                ret.settype(symbol_table::BOOL);
+            }
+            return ret;
+        }
+        if(ty.type()==symbol_table::REAL||ty.type()==symbol_table::INT)
+        {
+            ret.settype(ty.type());
+        }
+        else 
+        {
+            const pascal2c::ast::Ast &x=*now;
+            LOG("illegal type in unary expression");
+        }
+        return ret;
+    }
+    symbol_table::MegaType GetExprType(const std::shared_ptr<pascal2c::ast::Expression> &x)
+    {
+        //operators are typed after their operands, the walk keeps its own
+        //stack so deeply nested expressions don't use up the call stack
+        struct Frame
+        {
+            const pascal2c::ast::Expression *expr;
+            int typed;//operands typed so far
+            bool shared;//more than one parent holds expr, its type goes to sharedTypes
+        };
+        //only the operands are looked up, whoever passed x may hold a copy of it
+        auto operand=[](const std::shared_ptr<pascal2c::ast::Expression> &e)
+        {
+            return Frame{e.get(),0,e.use_count()>1};
+        };
+        std::vector<Frame> frames{{x.get(),0,false}};
+        std::vector<symbol_table::MegaType> types;//types of the finished operands
+        while(!frames.empty())
+        {
+            Frame &top=frames.back();
+            const pascal2c::ast::Expression *now=top.expr;
+            if(top.shared&&top.typed==0)
+            {
+                auto it=sharedTypes.find(now);
+                if(it!=sharedTypes.end())
+                {
+                    frames.pop_back();
+                    types.push_back(it->second);
+                    continue;
+                }
+            }
+            if(now->GetType()==pascal2c::ast::BINARY)
+            {
+                const pascal2c::ast::BinaryExpr *bin=static_cast<const pascal2c::ast::BinaryExpr *>(now);
+                if(top.typed==0)
+                {
+                    top.typed=1;
+                    frames.push_back(operand(bin->lhs()));
+                    continue;
+                }
+                if(top.typed==1&&!SkipsRhs(bin,types.back()))
+                {
+                    top.typed=2;
+                    frames.push_back(operand(bin->rhs()));
+                    continue;
+                }
+                symbol_table::MegaType rhs(symbol_table::ERROR);
+                if(top.typed==2)
+                {
+                    rhs=types.back();
+                    types.pop_back();
+                }
+                symbol_table::MegaType lhs=types.back();
+                types.pop_back();
+                types.push_back(BinaryExprType(bin,lhs,rhs));
+            }
+            else if(now->GetType()==pascal2c::ast::UNARY)
+            {
+                const pascal2c::ast::UnaryExpr *un=static_cast<const pascal2c::ast::UnaryExpr *>(now);
+                if(top.typed==0)
+                {
+                    top.typed=1;
+                    frames.push_back(operand(un->factor()));
+                    continue;
+                }
+                symbol_table::MegaType ty=types.back();
+                types.pop_back();
+                types.push_back(UnaryExprType(un,ty));
+            }
+            else
+            {
+                types.push_back(AtomType(now));
+            }
+            if(top.shared)
+                sharedTypes.emplace(now,types.back());
+            frames.pop_back();
+        }
+        return types.back();
+    }
     symbol_table::ItemType BasicToType(int basic_type)
     {
         if(basic_type==297)
@@ -426,18 +561,18 @@ namespace analysiser{
             return symbol_table::VOID;
         return symbol_table::ERROR;
     }
-    symbol_table::SymbolTableItem ExprToItem(std::string name, std::shared_ptr<pascal2c::ast::Expression> x)
+    symbol_table::SymbolTableItem ExprToItem(pascal2c::ast::SymbolId id, const std::shared_ptr<pascal2c::ast::Expression> &x)
     {
         symbol_table::MegaType itemtype=GetExprType(x);
-        symbol_table::SymbolTableItem ret(itemtype,name,false,false,std::vector<symbol_table::SymbolTablePara>());
+        symbol_table::SymbolTableItem ret=ItemOf(itemtype,id,false,false);
         return ret;
     }
-    std::vector<symbol_table::SymbolTablePara> TypeToPara(pascal2c::ast::Type type)
+    std::vector<symbol_table::SymbolTablePara> TypeToPara(const pascal2c::ast::Type &type)
     {
         std::vector<symbol_table::SymbolTablePara> ret;
         if(type.is_array())
         {
-            for(auto i : type.periods())
+            for(const auto &i : type.periods())
             {
                 ret.push_back(symbol_table::SymbolTablePara(symbol_table::INT,false,std::to_string(i.digits_1)+".."+std::to_string(i.digits_2)));
             }
@@ -446,88 +581,93 @@ namespace analysiser{
     }
     bool ParameterToPara(
         std::vector<symbol_table::SymbolTablePara> &ret,
-        pascal2c::ast::Parameter inpara)
+        const pascal2c::ast::Parameter &inpara)
     {
         for(int i=0;i<inpara.id_list()->Size();i++)
         {
-            Insert(symbol_table::SymbolTableItem(
+            Insert(ItemOf(
                 BasicToType(inpara.type()) ,
-                    (*inpara.id_list())[i] ,
-                    true ,false ,
-                    std::vector<symbol_table::SymbolTablePara>{}));
+                    inpara.id_list()->symbol(i) ,
+                    true ,false));
             ret.push_back(symbol_table::SymbolTablePara(BasicToType(inpara.type()),inpara.is_var(),""));
         }
         return true;
     }
-    symbol_table::SymbolTableItem SubprogramToItem(pascal2c::ast::SubprogramHead x)
+    symbol_table::SymbolTableItem SubprogramToItem(const pascal2c::ast::SubprogramHead &x)
     {
         std::vector<symbol_table::SymbolTablePara> para;
         symbol_table::ItemType itemtype=BasicToType(x.return_type());
-        for(auto i : x.parameters())
+        for(const auto &i : x.parameters())
         {
             if(!ParameterToPara(para,*i))
             {
                 itemtype=symbol_table::ERROR;
             }
         }
-        return symbol_table::SymbolTableItem(itemtype,x.id(),false,true,para);
+        return ItemOf(itemtype,x.symbol(),false,true,para);
     }
-    symbol_table::SymbolTableItem VarToItem(pascal2c::ast::Variable x)
+    symbol_table::SymbolTableItem VarToItem(const pascal2c::ast::Variable &x)
     {
         std::vector<symbol_table::SymbolTablePara> para;
-        for(auto i:x.expr_list())
+        for(const auto &i:x.expr_list())
         {
             para.push_back(symbol_table::SymbolTablePara(GetExprType(i),ExprIsVar(i),""));
         }
-        return symbol_table::SymbolTableItem(symbol_table::ERROR,x.id(),true,false,para);
+        return ItemOf(symbol_table::ERROR,x.symbol(),true,false,para);
     }
 
-    void DoProgram(pascal2c::ast::Program x)
+    void DoProgram(const pascal2c::ast::Program &x)
     {
         DoProgramHead(*x.program_head());
         DoProgramBody(*x.program_body());
     }
-    void DoProgramHead(pascal2c::ast::ProgramHead x)
+    void DoProgramHead(const pascal2c::ast::ProgramHead &x)
     {
-        BlockIn(std::to_string(x.line()));
+        BlockIn(std::to_string(x.line(*lines)));
     }
-    void DoProgramBody(pascal2c::ast::ProgramBody x)
+    void DoProgramBody(const pascal2c::ast::ProgramBody &x)
     {
-        for(auto i:x.const_declarations())
+        DoProgramDeclarations(x);
+        for(const auto &i:x.subprogram_declarations())
         {
-            DoConstDeclaration(*i);
+            DoSubprogram(*i);
         }
-        for(auto i:x.var_declarations())
+        DoProgramStatements(x);
+    }
+    void DoProgramDeclarations(const pascal2c::ast::ProgramBody &x)
+    {
+        for(const auto &i:x.const_declarations())
         {
-            DoVarDeclaration(*i);
+            DoConstDeclaration(*i);
         }
-        for(auto i:x.subprogram_declarations())
+        for(const auto &i:x.var_declarations())
         {
-            DoSubprogram(*i);
+            DoVarDeclaration(*i);
         }
+    }
+    void DoProgramStatements(const pascal2c::ast::ProgramBody &x)
+    {
         if(x.statements())
         {
-            std::vector<std::shared_ptr<pascal2c::ast::Statement>> inp;
-            inp.push_back(x.statements());
-            DoAllStatement(inp);
+            DoStatement(*x.statements());
         }
         BlockExit();
     }
-    void DoConstDeclaration(pascal2c::ast::ConstDeclaration x)
+    void DoConstDeclaration(const pascal2c::ast::ConstDeclaration &x)
     {
-        symbol_table::SymbolTableItem itemA = ExprToItem(x.id(),x.const_value());
+        symbol_table::SymbolTableItem itemA = ExprToItem(x.symbol(),x.const_value());
         saERRORS::ERROR_TYPE err=Insert(itemA);
         if(err!=saERRORS::NO_ERROR)
         {
             LOG("Const Declaration failure("+saERRORS::toString(err)+")");
         }
     }
-    void DoVarDeclaration(pascal2c::ast::VarDeclaration x)
+    void DoVarDeclaration(const pascal2c::ast::VarDeclaration &x)
     {
         std::vector<symbol_table::SymbolTablePara> para = TypeToPara(*x.type());
         for(int i=0;i<x.id_list()->Size();i++)
         {
-            symbol_table::SymbolTableItem now(BasicToType(x.type()->basic_type()),(*x.id_list())[i],true,false,para);
+            symbol_table::SymbolTableItem now=ItemOf(BasicToType(x.type()->basic_type()),x.id_list()->symbol(i),true,false,para);
             saERRORS::ERROR_TYPE err=Insert(now);
             if(err!=saERRORS::NO_ERROR)
             {
@@ -535,7 +675,7 @@ namespace analysiser{
             }
         }
     }
-    void DoSubprogram(pascal2c::ast::Subprogram x)
+    void DoSubprogram(const pascal2c::ast::Subprogram &x)
     {
         std::string nameTmp=nowblockName;
         symbol_table::SymbolTableItem now=DoSubprogramHead(*x.subprogram_head());
@@ -555,13 +695,13 @@ namespace analysiser{
 
         DoSubprogramBody(*x.subprogram_body());
     }
-    symbol_table::SymbolTableItem DoSubprogramHead(pascal2c::ast::SubprogramHead x)
+    symbol_table::SymbolTableItem DoSubprogramHead(const pascal2c::ast::SubprogramHead &x)
     {
-        BlockIn(std::to_string(x.line()));
+        BlockIn(std::to_string(x.line(*lines)));
         symbol_table::SymbolTableItem now=SubprogramToItem(x);
         if(now.type()!=symbol_table::VOID)
         {
-            symbol_table::SymbolTableItem nownext(now.type(),x.id(),true,true,std::vector<symbol_table::SymbolTablePara>());
+            symbol_table::SymbolTableItem nownext=ItemOf(now.type(),x.symbol(),true,true);
             saERRORS::ERROR_TYPE err=Insert(nownext);
             if(err!=saERRORS::NO_ERROR)
             {
@@ -572,46 +712,50 @@ namespace analysiser{
         }
         return now;
     }
-    void DoSubprogramBody(pascal2c::ast::SubprogramBody x)
+    void DoSubprogramBody(const pascal2c::ast::SubprogramBody &x)
     {
-        for(auto i:x.const_declarations())
+        for(const auto &i:x.const_declarations())
         {
             DoConstDeclaration(*i);
         }
-        for(auto i:x.var_declarations())
+        for(const auto &i:x.var_declarations())
         {
             DoVarDeclaration(*i);
         }
         if(x.statement_list())
         {
-            std::vector<std::shared_ptr<pascal2c::ast::Statement>> inp;
-            inp.push_back(x.statement_list());
-            DoAllStatement(inp);
+            DoStatement(*x.statement_list());
         }
         BlockExit();
     }
-    void DoAllStatement(std::vector<std::shared_ptr<pascal2c::ast::Statement>> x)
+    void DoAllStatement(const std::vector<std::shared_ptr<pascal2c::ast::Statement>> &x)
     {
-        for(auto i:x)
+        for(const auto &i:x)
         {
-            switch(i->GetType())
-            {
-                case pascal2c::ast::ASSIGN_STATEMENT: 
-                    DoAssignStatement(*(std::static_pointer_cast<pascal2c::ast::AssignStatement>(i)));break;
-                case pascal2c::ast::CALL_STATEMENT: 
-                    DoCallStatement(*(std::static_pointer_cast<pascal2c::ast::CallStatement>(i)));break;
-                case pascal2c::ast::COMPOUND_STATEMENT: 
-                    DoCompoundStatement(*(std::static_pointer_cast<pascal2c::ast::CompoundStatement>(i)));break;
-                case pascal2c::ast::IF_STATEMENT:
-                    DoIfStatement(*(std::static_pointer_cast<pascal2c::ast::IfStatement>(i)));break;
-                case pascal2c::ast::FOR_STATEMENT: 
-                    DoForStatement(*(std::static_pointer_cast<pascal2c::ast::ForStatement>(i)));break;
-                case pascal2c::ast::WHILE_STATEMENT:
-                    DoWhileStatement(*(std::static_pointer_cast<pascal2c::ast::WhileStatement>(i)));break;
-            }
+            DoStatement(*i);
+        }
+    }
+    void DoStatement(const pascal2c::ast::Statement &x)
+    {
+        switch(x.GetType())
+        {
+            case pascal2c::ast::ASSIGN_STATEMENT: 
+                DoAssignStatement(static_cast<const pascal2c::ast::AssignStatement &>(x));break;
+            case pascal2c::ast::CALL_STATEMENT: 
+                DoCallStatement(static_cast<const pascal2c::ast::CallStatement &>(x));break;
+            case pascal2c::ast::COMPOUND_STATEMENT: 
+                DoCompoundStatement(static_cast<const pascal2c::ast::CompoundStatement &>(x));break;
+            case pascal2c::ast::IF_STATEMENT:
+                DoIfStatement(static_cast<const pascal2c::ast::IfStatement &>(x));break;
+            case pascal2c::ast::FOR_STATEMENT: 
+                DoForStatement(static_cast<const pascal2c::ast::ForStatement &>(x));break;
+            case pascal2c::ast::WHILE_STATEMENT:
+                DoWhileStatement(static_cast<const pascal2c::ast::WhileStatement &>(x));break;
+            default:
+                break;
         }
     }
-    void DoAssignStatement(pascal2c::ast::AssignStatement x)
+    void DoAssignStatement(const pascal2c::ast::AssignStatement &x)
     {
         symbol_table::SymbolTableItem l=VarToItem(*x.var());
         symbol_table::MegaType ltype;
@@ -643,14 +787,14 @@ namespace analysiser{
             return;
         }
     }
-    void DoCallStatement(pascal2c::ast::CallStatement x)
+    void DoCallStatement(const pascal2c::ast::CallStatement &x)
     {
         std::vector<symbol_table::SymbolTablePara> para;
-        for(auto i:x.expr_list())
+        for(const auto &i:x.expr_list())
         {
             para.push_back(symbol_table::SymbolTablePara(GetExprType(i),ExprIsVar(i),""));
         }
-        symbol_table::SymbolTableItem tgt1(symbol_table::ERROR,x.name(),false,true,para);
+        symbol_table::SymbolTableItem tgt1=ItemOf(symbol_table::ERROR,x.symbol(),false,true,para);
         saERRORS::ERROR_TYPE err = Find(tgt1);
         if(err!=saERRORS::NO_ERROR)
         {
@@ -660,11 +804,11 @@ namespace analysiser{
             return;
         }
     }
-    void DoCompoundStatement(pascal2c::ast::CompoundStatement x)
+    void DoCompoundStatement(const pascal2c::ast::CompoundStatement &x)
     {
         DoAllStatement(x.statements());
     }
-    void DoIfStatement(pascal2c::ast::IfStatement x)
+    void DoIfStatement(const pascal2c::ast::IfStatement &x)
     {
         symbol_table::MegaType ty=GetExprType(x.condition());
         if(ty!=symbol_table::BOOL)
@@ -674,22 +818,18 @@ namespace analysiser{
             LOG("If Statement failure(condition error:received type "+ss.str()+")");
             return;
         }
-        std::vector<std::shared_ptr<pascal2c::ast::Statement>> inp;
         if(x.then())
         {
-            inp.push_back(x.then());
-            DoAllStatement(inp);//then_
-            inp.pop_back();
+            DoStatement(*x.then());//then_
         }
         if(x.else_part())
         {
-            inp.push_back(x.else_part());
-            DoAllStatement(inp);//else_
+            DoStatement(*x.else_part());//else_
         }
     }
-    void DoForStatement(pascal2c::ast::ForStatement x)
+    void DoForStatement(const pascal2c::ast::ForStatement &x)
     {
-        symbol_table::SymbolTableItem tgt(symbol_table::ERROR,x.id(),true,false,std::vector<symbol_table::SymbolTablePara>());
+        symbol_table::SymbolTableItem tgt=ItemOf(symbol_table::ERROR,x.symbol(),true,false);
         if(Find(tgt)!=saERRORS::NO_ERROR)
         {
             LOG("For Statement failure(id: "+x.id()+" not found)");
@@ -706,12 +846,10 @@ namespace analysiser{
         }
         if(x.statement())
         {
-            std::vector<std::shared_ptr<pascal2c::ast::Statement>> inp;
-            inp.push_back(x.statement());
-            DoAllStatement(inp);
+            DoStatement(*x.statement());
         }
     }
-    void DoWhileStatement(pascal2c::ast::WhileStatement x)
+    void DoWhileStatement(const pascal2c::ast::WhileStatement &x)
     {
         symbol_table::MegaType ty=GetExprType(x.condition());
         if(ty!=symbol_table::BOOL)
@@ -723,9 +861,7 @@ namespace analysiser{
         }
         if(x.statement())
         {
-            std::vector<std::shared_ptr<pascal2c::ast::Statement>> inp;
-            inp.push_back(x.statement());
-            DoAllStatement(inp);
+            DoStatement(*x.statement());
         }
     }
 }//end namespace analysiser
\ No newline at end of file
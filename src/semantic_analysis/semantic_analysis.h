@@ -1,5 +1,6 @@
 #ifndef TEST_H
 #define TEST_H
+#include <unordered_map>
 #include "symbol_table.h"
 #include "../ast/program.h"
 #include "errors.h"
@@ -26,40 +27,54 @@ namespace analysiser{
         //find SymbolTableBlock named name
         //return success or failure. if success, put target on ansblock
         bool Query(std::string name, std::shared_ptr<symbol_table::SymbolTableBlock> &ansblock);
+        //drop every SymbolTableBlock
+        void Clear();
     private:
-        std::map<std::string, std::shared_ptr<symbol_table::SymbolTableBlock> > table_;
+        std::unordered_map<std::string, std::shared_ptr<symbol_table::SymbolTableBlock> > table_;
    };
     
 
     nameTable* GetTable();
+    //the identifiers given to init, look a name up in it to query the tables by name
+    const pascal2c::ast::Interner* GetSymbols();
     std::vector<errorMsg> GetErrors();
     saERRORS::ERROR_TYPE Find(symbol_table::SymbolTableItem &x);
     saERRORS::ERROR_TYPE Insert(const symbol_table::SymbolTableItem &x);
-    void init();
+    //reset the analysis state of the calling thread, call before every compilation
+    //lines is the line table of the source to analyse, eg. Parser::line_table,
+    //the nodes only keep offsets and their positions are looked up there
+    //symbols are its identifiers, eg. Parser::symbols, the nodes keep the ids of their names in it
+    void init(std::shared_ptr<const pascal2c::ast::LineTable> lines,std::shared_ptr<const pascal2c::ast::Interner> symbols);
     void BlockExit();
     void BlockIn(std::string name);
-    void DoProgram(pascal2c::ast::Program x);
+    void DoProgram(const pascal2c::ast::Program &x);
     symbol_table::MegaType MaxType(symbol_table::MegaType x,symbol_table::MegaType y);
-    symbol_table::MegaType GetExprType(std::shared_ptr<pascal2c::ast::Expression> x);
+    symbol_table::MegaType GetExprType(const std::shared_ptr<pascal2c::ast::Expression> &x);
     symbol_table::ItemType BasicToType(int basic_type);
-    symbol_table::SymbolTableItem ExprToItem(std::string name, std::shared_ptr<pascal2c::ast::Expression> x);
-    std::vector<symbol_table::SymbolTablePara> TypeToPara(pascal2c::ast::Type type);
-    bool ParameterToPara(std::vector<symbol_table::SymbolTablePara> &ret,pascal2c::ast::Parameter inpara);
-    symbol_table::SymbolTableItem SubprogramToItem(pascal2c::ast::SubprogramHead x);
-    symbol_table::SymbolTableItem VarToItem(pascal2c::ast::Variable x);
-    void DoProgramHead(pascal2c::ast::ProgramHead x);
-    void DoProgramBody(pascal2c::ast::ProgramBody x);
-    void DoConstDeclaration(pascal2c::ast::ConstDeclaration x);
-    void DoVarDeclaration(pascal2c::ast::VarDeclaration x);
-    void DoSubprogram(pascal2c::ast::Subprogram x);
-    symbol_table::SymbolTableItem DoSubprogramHead(pascal2c::ast::SubprogramHead x);
-    void DoSubprogramBody(pascal2c::ast::SubprogramBody x);
-    void DoAllStatement(std::vector<std::shared_ptr<pascal2c::ast::Statement>> x);
-    void DoAssignStatement(pascal2c::ast::AssignStatement x);
-    void DoCallStatement(pascal2c::ast::CallStatement x);
-    void DoCompoundStatement(pascal2c::ast::CompoundStatement x);
-    void DoIfStatement(pascal2c::ast::IfStatement x);
-    void DoForStatement(pascal2c::ast::ForStatement x);
-    void DoWhileStatement(pascal2c::ast::WhileStatement x);
+    symbol_table::SymbolTableItem ExprToItem(pascal2c::ast::SymbolId id, const std::shared_ptr<pascal2c::ast::Expression> &x);
+    std::vector<symbol_table::SymbolTablePara> TypeToPara(const pascal2c::ast::Type &type);
+    bool ParameterToPara(std::vector<symbol_table::SymbolTablePara> &ret,const pascal2c::ast::Parameter &inpara);
+    symbol_table::SymbolTableItem SubprogramToItem(const pascal2c::ast::SubprogramHead &x);
+    symbol_table::SymbolTableItem VarToItem(const pascal2c::ast::Variable &x);
+    void DoProgramHead(const pascal2c::ast::ProgramHead &x);
+    void DoProgramBody(const pascal2c::ast::ProgramBody &x);
+    //DoProgramBody in two halves around the subprograms, for a program analysed
+    //one subprogram at a time: global const and var declarations first,
+    //the main statements and leaving the program block last
+    void DoProgramDeclarations(const pascal2c::ast::ProgramBody &x);
+    void DoProgramStatements(const pascal2c::ast::ProgramBody &x);
+    void DoConstDeclaration(const pascal2c::ast::ConstDeclaration &x);
+    void DoVarDeclaration(const pascal2c::ast::VarDeclaration &x);
+    void DoSubprogram(const pascal2c::ast::Subprogram &x);
+    symbol_table::SymbolTableItem DoSubprogramHead(const pascal2c::ast::SubprogramHead &x);
+    void DoSubprogramBody(const pascal2c::ast::SubprogramBody &x);
+    void DoAllStatement(const std::vector<std::shared_ptr<pascal2c::ast::Statement>> &x);
+    void DoStatement(const pascal2c::ast::Statement &x);
+    void DoAssignStatement(const pascal2c::ast::AssignStatement &x);
+    void DoCallStatement(const pascal2c::ast::CallStatement &x);
+    void DoCompoundStatement(const pascal2c::ast::CompoundStatement &x);
+    void DoIfStatement(const pascal2c::ast::IfStatement &x);
+    void DoForStatement(const pascal2c::ast::ForStatement &x);
+    void DoWhileStatement(const pascal2c::ast::WhileStatement &x);
 }//end namespace analysiser
 #endif
\ No newline at end of file
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <map>
 #include <set>
 #include <assert.h>
@@ -8,22 +9,61 @@ using namespace symbol_table;
 
 
 
+ScopeTable::Entry *ScopeTable::Find(SymbolId id)
+{
+	return const_cast<Entry *>(static_cast<const ScopeTable *>(this)->Find(id));
+}
+
+const ScopeTable::Entry *ScopeTable::Find(SymbolId id)const
+{
+	if (slots_.empty()) return nullptr;
+	for (size_t i=Slot(id);;i=(i+1)&(slots_.size()-1))
+	{
+		if (slots_[i].id==id) return &slots_[i];
+		if (slots_[i].id==kEmpty) return nullptr;
+	}
+}
+
+ScopeTable::Entry &ScopeTable::Insert(SymbolId id,bool is_func)
+{
+	if ((size_+1)*2>slots_.size()) Grow();//keep the load factor under 1/2
+	size_t i=Slot(id);
+	while (slots_[i].id!=kEmpty) i=(i+1)&(slots_.size()-1);
+	slots_[i].id=id;
+	slots_[i].is_func=is_func;
+	size_++;
+	return slots_[i];
+}
+
+void ScopeTable::Grow()
+{
+	std::vector<Entry> old(slots_.empty()?16:slots_.size()*2);
+	old.swap(slots_);
+	for (auto &entry:old)
+	{
+		if (entry.id==kEmpty) continue;
+		size_t i=Slot(entry.id);
+		while (slots_[i].id!=kEmpty) i=(i+1)&(slots_.size()-1);
+		slots_[i]=std::move(entry);
+	}
+}
+
 //add identify with format SymbolTableItem
 //return 0 if success; otherwise failure
 saERRORS::ERROR_TYPE SymbolTableBlock::AddItem(const SymbolTableItem &x)
 {
-	std::string name=x.name();
-	if (this->name_domain.find(name)==this->name_domain.end())
+	bool B=x.is_func()&(!x.is_var());
+	ScopeTable::Entry *entry=this->table.Find(x.id());
+	if (entry==nullptr)
 	{
-		this->name_domain[name]=x.is_func()&(!x.is_var());
-		this->table[name].insert(x);
+		this->table.Insert(x.id(),B).items.push_back(x);
 		return saERRORS::NO_ERROR;
 	}
-	bool A=this->name_domain[name],B=x.is_func()&(!x.is_var());
+	bool A=entry->is_func;
 	if (A!=B) return saERRORS::ITEM_ERROR;//it is a var not func
 	if (!A) return saERRORS::ITEM_EXIST;//var redefinition
-	if (this->table[name].find(x)!=this->table[name].end()) return saERRORS::ITEM_EXIST;//func redefinition
-	this->table[name].insert(x);
+	for (size_t i=0;i<entry->items.size();i++) if (entry->items[i]==x) return saERRORS::ITEM_EXIST;//func redefinition
+	entry->items.push_back(x);
 	return saERRORS::NO_ERROR;
 }
 
@@ -38,15 +78,18 @@ bool isadapt(const std::vector<SymbolTablePara> &A,const std::vector<SymbolTable
 //return if exist
 saERRORS::ERROR_TYPE SymbolTableBlock::Query(SymbolTableItem &x)
 {
-	std::string name=x.name();
-	for (std::shared_ptr<SymbolTableBlock> nw=std::make_shared<SymbolTableBlock>(*this);nw;nw=nw->father)
+	const SymbolId id=x.id();
+	//walk the father chain by pointer, the blocks themselves are never copied
+	for (const SymbolTableBlock *nw=this;nw;nw=nw->father.get())
 	{
-		if (nw->name_domain.find(name)!=nw->name_domain.end())
+		const ScopeTable::Entry *entry=nw->table.Find(id);
+		if (entry!=nullptr)
 		{
-			bool A=nw->name_domain[name],B=x.is_func()&(!x.is_var());
+			const Overloads &items=entry->items;
+			bool A=entry->is_func,B=x.is_func()&(!x.is_var());
 			if (A!=B)
 			{
-				if(!A&&nw->table[name].begin()->is_func()==true)
+				if(!A&&items[0].is_func()==true)
 				{
 					continue;
 				}
@@ -55,27 +98,28 @@ saERRORS::ERROR_TYPE SymbolTableBlock::Query(SymbolTableItem &x)
 			}
 			if (!A)//variable
 			{
-				auto temp=nw->table[name].begin();
-				int P=temp->para().size(),Q=x.para().size();
+				const SymbolTableItem *temp=&items[0];
+				const std::vector<SymbolTablePara> &para=temp->para();
+				int P=para.size(),Q=x.para().size();
 				if (P<Q) return saERRORS::FOUND_BUT_PARA_NOT_MATCH;//variable:too long parameter
 				for (auto &o:x.para()) if (o.type()!=MegaType(ItemType::INT)) return saERRORS::FOUND_BUT_TYPE_NOT_MATCH;//expect int but other
 				MegaType ty=MegaType(temp->type().type());
 				for(int i=Q;i<P;i++)
 				{
-					ty.addpointer(temp->para()[i].info());
+					ty.addpointer(para[i].info());
 				}
-				x=SymbolTableItem(ty,temp->name(),temp->is_var(),temp->is_func(),temp->para());
+				x=SymbolTableItem(ty,temp->id(),temp->name(),temp->is_var(),temp->is_func(),para);
 				return saERRORS::NO_ERROR;
 			}
-			auto temp=nw->table[name].find(x);
-			if (temp!=nw->table[name].end())
+			for (size_t i=0;i<items.size();i++)
 			{
-				if (!isadapt(x.para(),temp->para())) return saERRORS::FOUND_BUT_PARA_NOT_MATCH;
-				x=*temp;
+				if (!(items[i]==x)) continue;
+				if (!isadapt(x.para(),items[i].para())) return saERRORS::FOUND_BUT_PARA_NOT_MATCH;
+				x=items[i];
 				if(x.is_var())	x.setIsVar();
 				return saERRORS::NO_ERROR;
 			}
-			else return saERRORS::FOUND_BUT_NOT_MATCH;
+			return saERRORS::FOUND_BUT_NOT_MATCH;
 		}
 	}
 	if (x.name()=="read" || x.name()=="readln")
@@ -92,4 +136,16 @@ saERRORS::ERROR_TYPE SymbolTableBlock::Query(SymbolTableItem &x)
 	}
 	return saERRORS::NOT_FOUND;
 }
-std::shared_ptr<SymbolTableBlock> SymbolTableBlock::getfather(){return father;}
\ No newline at end of file
+std::shared_ptr<SymbolTableBlock> SymbolTableBlock::getfather(){return father;}
+namespace symbol_table{
+ostream& operator<<(ostream& OUT,const SymbolTableBlock& x)
+{
+	//print in name order like the ordered map used to
+	std::vector<SymbolTableItem> items;
+	for (auto &entry:x.table.slots())
+		for (size_t i=0;i<entry.items.size();i++) items.push_back(entry.items[i]);
+	std::sort(items.begin(),items.end());
+	for (auto &res:items) OUT<<res<<std::endl;
+	return OUT;
+}
+}
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <map>
 #include <set>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include "../ast/ast.h"
@@ -10,6 +11,7 @@
 using std::ostream;
 using std::istream;
 namespace symbol_table{
+    using SymbolId=pascal2c::ast::SymbolId;
 	enum ItemType{
         ERROR,
         VOID,
@@ -138,35 +140,27 @@ namespace symbol_table{
 	};
 	
     //item of symbol table
+    //it is named by the id of its name in the interner of the source,
+    //name must outlive the item, eg. Interner::Name(id)
     class SymbolTableItem{
     public:
         SymbolTableItem(){}
-		SymbolTableItem(MegaType type, std::string name, bool is_var, bool is_func, std::vector<SymbolTablePara> para):
-			type_(type), name_(name), is_var_(is_var), is_func_(is_func), para_(para){}
-		SymbolTableItem(ItemType type, std::string name, bool is_var, bool is_func, std::vector<SymbolTablePara> para):
-			type_(type), name_(name), is_var_(is_var), is_func_(is_func), para_(para){}
+		SymbolTableItem(MegaType type, SymbolId id, std::string_view name, bool is_var, bool is_func, std::vector<SymbolTablePara> para):
+			type_(type), id_(id), name_(name), is_var_(is_var), is_func_(is_func), para_(std::move(para)){}
+		SymbolTableItem(ItemType type, SymbolId id, std::string_view name, bool is_var, bool is_func, std::vector<SymbolTablePara> para):
+			type_(type), id_(id), name_(name), is_var_(is_var), is_func_(is_func), para_(std::move(para)){}
 		
-        std::string name()const{return name_;}
+        std::string_view name()const{return name_;}
+        SymbolId id()const{return id_;}
         MegaType type()const{return type_;}
         void settype(MegaType newtype){type_=newtype;}
         void setIsVar(){is_var_=!is_var_;}
         void setIsFunc(){is_func_=!is_func_;}
         bool is_var()const{return is_var_;}
         bool is_func()const{return is_func_;}
-		std::vector<SymbolTablePara> para()const{return para_;}
+		const std::vector<SymbolTablePara> &para()const{return para_;}
         friend bool operator<(const SymbolTableItem &A,const SymbolTableItem &B){return A.name_==B.name_ ? A.para_<B.para_ : A.name_<B.name_;};
-        friend bool operator==(const SymbolTableItem &A,const SymbolTableItem &B){return A.name_==B.name_ && A.para_==B.para_;};
-        /*
-		input format:
-			is_var is_func type name num_of_paras para1 para2 ... 
-        */
-        friend istream& operator>>(istream& IN,SymbolTableItem& x)
-        {
-        	IN>>x.is_var_>>x.is_func_>>x.type_>>x.name_;
-        	int k;IN>>k;
-        	while (k--){SymbolTablePara temp;IN>>temp;x.para_.push_back(temp);}
-        	return IN;
-        }
+        friend bool operator==(const SymbolTableItem &A,const SymbolTableItem &B){return A.id_==B.id_ && A.para_==B.para_;};
         /*
 		output format:
 			is_var is_func type name[para1][para2]...
@@ -179,11 +173,55 @@ namespace symbol_table{
         }
     private:
 		MegaType type_;
-        std::string name_;
+        SymbolId id_=0;
+        std::string_view name_;//of id_, not owned
         bool is_var_;
         bool is_func_;
 		std::vector<SymbolTablePara> para_;
     };
+
+    //overloads sharing one name, the first one is stored inline
+    //since almost every name has exactly one item
+    class Overloads{
+    public:
+        size_t size()const{return empty_?0:1+rest_.size();}
+        const SymbolTableItem &operator[](size_t i)const{return i==0?first_:rest_[i-1];}
+        void push_back(const SymbolTableItem &x)
+        {
+            if (empty_) {first_=x;empty_=false;}
+            else rest_.push_back(x);
+        }
+    private:
+        bool empty_=true;
+        SymbolTableItem first_;
+        std::vector<SymbolTableItem> rest_;
+    };
+
+    //open addressing hash table from interned name to its overloads
+    //linear probing, the capacity is always a power of two
+    class ScopeTable{
+    public:
+        struct Entry{
+            SymbolId id=kEmpty;
+            bool is_func=false;//mark name belong func or variable
+            Overloads items;
+        };
+        static const SymbolId kEmpty=UINT32_MAX;
+
+        //return the entry of id, nullptr if absent
+        Entry *Find(SymbolId id);
+        const Entry *Find(SymbolId id)const;
+        //add an entry for id which must be absent
+        Entry &Insert(SymbolId id,bool is_func);
+
+        const std::vector<Entry> &slots()const{return slots_;}
+    private:
+        size_t Slot(SymbolId id)const{return (id*2654435769u)&(slots_.size()-1);}
+        void Grow();
+
+        std::vector<Entry> slots_;
+        size_t size_=0;
+    };
 	
     class SymbolTableBlock{
     public:
@@ -193,22 +231,18 @@ namespace symbol_table{
         
         //find identify with format SymbolTableItem
         //do not care about para.info_
+        //walks this block and its fathers in place, nothing is copied
         //return if exist
         saERRORS::ERROR_TYPE Query(SymbolTableItem &x);
         
         std::shared_ptr<SymbolTableBlock> getfather();
-        friend ostream& operator<<(ostream& OUT,const SymbolTableBlock& x)
-        {
-            for (auto &temp:x.table) for(auto &res:temp.second) OUT<<res<<std::endl;
-            return OUT;
-        }
+        friend ostream& operator<<(ostream& OUT,const SymbolTableBlock& x);
         void Locate(std::shared_ptr<SymbolTableBlock> nowfather)
         {
             father=nowfather;
         }
     private:
         std::shared_ptr<SymbolTableBlock> father;
-        std::map<std::string,bool> name_domain;//mark name belong func or variable;
-        std::map<std::string,std::set<SymbolTableItem> > table;
+        ScopeTable table;
     }; 
 }
\ No newline at end of file
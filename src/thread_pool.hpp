@@ -0,0 +1,85 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pascal2c {
+
+// fixed size pool of worker threads running queued tasks in FIFO order
+// usage:
+//     ThreadPool pool(4);
+//     auto result = pool.Submit([] { return 42; });
+//     result.get();
+class ThreadPool {
+public:
+    // param:
+    //     threads is the number of workers, at least one is started
+    explicit ThreadPool(size_t threads) {
+        if (threads == 0) threads = 1;
+        for (size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this] { Work(); });
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // finish every queued task, then join the workers
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cond_.notify_all();
+        for (auto &worker : workers_) worker.join();
+    }
+
+    // param:
+    //     task is run on one of the workers
+    // return:
+    //     the future of the task result, exceptions are rethrown by get()
+    template <typename F>
+    auto Submit(F &&task) -> std::future<std::invoke_result_t<F>> {
+        using Result = std::invoke_result_t<F>;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        auto future = packaged->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.emplace([packaged] { (*packaged)(); });
+        }
+        cond_.notify_one();
+        return future;
+    }
+
+    size_t size() const { return workers_.size(); }
+
+private:
+    void Work() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cond_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+                if (tasks_.empty()) return;
+                task = std::move(tasks_.front());
+                tasks_.pop();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool stop_ = false;
+};
+
+}  // namespace pascal2c
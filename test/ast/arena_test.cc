@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <memory>
+
+#include "ast/arena.h"
+#include "ast/expr.h"
+#include "ast/statement.h"
+
+using namespace pascal2c;
+
+template <typename Tp, typename... Args>
+static std::shared_ptr<Tp> New(const std::shared_ptr<ast::Arena> &arena, Args &&...args)
+{
+    return std::allocate_shared<Tp>(ast::ArenaAllocator<Tp>(arena.get()), std::forward<Args>(args)...);
+}
+
+TEST(ArenaTest, TestNodesShareBlocks) {
+    auto arena = std::make_shared<ast::Arena>();
+    std::vector<std::shared_ptr<ast::Expression>> nodes;
+    for (int i = 0; i < 1000; i++)
+        nodes.push_back(New<ast::IntegerValue>(arena, i));
+
+    EXPECT_LT(arena->block_count(), 10u);
+    EXPECT_EQ(arena->allocation_count(), 1000u);
+    for (int i = 0; i < 1000; i++)
+        EXPECT_EQ(std::dynamic_pointer_cast<ast::IntegerValue>(nodes[i])->value(), i);
+}
+
+TEST(ArenaTest, TestAlignment) {
+    ast::Arena arena(64);
+    arena.Allocate(1, 1);
+    auto p = reinterpret_cast<uintptr_t>(arena.Allocate(sizeof(double), alignof(double)));
+    EXPECT_EQ(p % alignof(double), 0u);
+    // larger than a block gets a block of its own
+    EXPECT_NE(arena.Allocate(1000, 8), nullptr);
+    EXPECT_EQ(arena.bytes_used(), 1 + sizeof(double) + 1000);
+}
+
+TEST(ArenaTest, TestTreeOutlivesParserArena) {
+    std::weak_ptr<ast::Arena> weak;
+    std::shared_ptr<ast::Expression> tree;
+    {
+        auto arena = std::make_shared<ast::Arena>();
+        weak = arena;
+        auto lhs = New<ast::Variable>(arena, "a");
+        auto rhs = New<ast::IntegerValue>(arena, 1);
+        tree = ast::Root<ast::Expression>(New<ast::BinaryExpr>(arena, '+', lhs, rhs), arena);
+    }
+    // the root keeps its arena alive
+    EXPECT_FALSE(weak.expired());
+    EXPECT_EQ(tree->GetType(), ast::BINARY);
+    EXPECT_EQ(std::dynamic_pointer_cast<ast::BinaryExpr>(tree)->lhs()->GetType(), ast::VARIABLE);
+    tree.reset();
+    EXPECT_TRUE(weak.expired());
+}
+
+TEST(ArenaTest, TestAdopt) {
+    std::weak_ptr<ast::Arena> weak;
+    auto arena = std::make_shared<ast::Arena>();
+    {
+        auto other = std::make_shared<ast::Arena>();
+        weak = other;
+        arena->Adopt(other);
+    }
+    EXPECT_FALSE(weak.expired());
+    arena.reset();
+    EXPECT_TRUE(weak.expired());
+}
@@ -0,0 +1,90 @@
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "ast/expr.h"
+#include "ast/expr_pool.h"
+#include "ast/line_table.h"
+
+namespace pascal2c::ast
+{
+    // (l + r) div 2 with fresh nodes everywhere
+    static std::shared_ptr<Expression> Middle(ExprPool *pool)
+    {
+        auto intern = [pool](std::shared_ptr<Expression> expr) {
+            return pool ? pool->Intern(std::move(expr)) : expr;
+        };
+        auto sum = intern(std::make_shared<BinaryExpr>('+', intern(std::make_shared<CallOrVar>("l")),
+                                                       intern(std::make_shared<CallOrVar>("r"))));
+        return intern(std::make_shared<BinaryExpr>('/', sum, intern(std::make_shared<IntegerValue>(2))));
+    }
+
+    TEST(ExprPoolTest, TestIntern)
+    {
+        ExprPool pool;
+        auto a = Middle(&pool);
+        EXPECT_EQ(pool.size(), 5);
+        EXPECT_EQ(pool.hits(), 0);
+
+        auto b = Middle(&pool);
+        EXPECT_EQ(a, b);
+        EXPECT_EQ(pool.size(), 5);
+        EXPECT_EQ(pool.hits(), 5);
+
+        auto lhs = std::static_pointer_cast<BinaryExpr>(a)->lhs();
+        EXPECT_EQ(pool.Find(BinaryExpr('+', std::static_pointer_cast<BinaryExpr>(lhs)->lhs(),
+                                       std::static_pointer_cast<BinaryExpr>(lhs)->rhs())),
+                  lhs);
+        // the same without making the node
+        EXPECT_EQ(pool.Find(ExprPool::Shape::Of<BinaryExpr>('+', std::static_pointer_cast<BinaryExpr>(lhs)->lhs(),
+                                                             std::static_pointer_cast<BinaryExpr>(lhs)->rhs())),
+                  lhs);
+        EXPECT_EQ(pool.Find(ExprPool::Shape::Of<IntegerValue>(2)), std::static_pointer_cast<BinaryExpr>(a)->rhs());
+        EXPECT_EQ(pool.Find(ExprPool::Shape::Of<IntegerValue>(3)), nullptr);
+        EXPECT_EQ(pool.Find(ExprPool::Shape::Of<CallOrVar>(std::string("l"))),
+                  std::static_pointer_cast<BinaryExpr>(lhs)->lhs());
+
+        // a node over children the pool does not hold is not shared
+        auto loose = std::make_shared<BinaryExpr>('+', std::make_shared<CallOrVar>("l"), std::make_shared<CallOrVar>("r"));
+        EXPECT_EQ(pool.Find(*loose), nullptr);
+        EXPECT_EQ(pool.Intern(loose), loose);
+        EXPECT_EQ(pool.size(), 5);
+
+        pool.Clear();
+        EXPECT_EQ(pool.size(), 0);
+        EXPECT_NE(Middle(&pool), a);
+    }
+
+    TEST(ExprPoolTest, TestCallsAreNotShared)
+    {
+        ExprPool pool;
+        auto one = pool.Intern(std::make_shared<IntegerValue>(1));
+        auto f1 = pool.Intern(std::make_shared<CallValue>("f", vector<std::shared_ptr<Expression>>{one}));
+        auto f2 = pool.Intern(std::make_shared<CallValue>("f", vector<std::shared_ptr<Expression>>{one}));
+        EXPECT_NE(f1, f2);
+        LineTable lines("f(1)");
+        EXPECT_EQ(f1->ToString(0, lines), f2->ToString(0, lines));
+
+        // nor is anything above a call
+        auto sum1 = pool.Intern(std::make_shared<BinaryExpr>('+', f1, one));
+        auto sum2 = pool.Intern(std::make_shared<BinaryExpr>('+', f1, one));
+        EXPECT_NE(sum1, sum2);
+        EXPECT_EQ(pool.size(), 1);
+    }
+
+    TEST(ExprPoolTest, TestDeepExpression)
+    {
+        // finding a node costs the same at every depth, a second chain is all hits
+        ExprPool pool;
+        std::shared_ptr<Expression> a = pool.Intern(std::make_shared<IntegerValue>(1));
+        std::shared_ptr<Expression> b = pool.Intern(std::make_shared<IntegerValue>(1));
+        for (int i = 0; i < 100000; i++)
+        {
+            a = pool.Intern(std::make_shared<UnaryExpr>('-', a));
+            b = pool.Intern(std::make_shared<UnaryExpr>('-', b));
+        }
+        EXPECT_EQ(a, b);
+        EXPECT_EQ(pool.size(), 100001);
+        EXPECT_EQ(pool.hits(), 100001);
+    }
+}
@@ -29,3 +29,40 @@ TEST(TestGetType, TestCallOrVar){
     std::shared_ptr<ast::CallOrVar> call = std::make_shared<ast::CallOrVar>("add");
     EXPECT_EQ(call->GetType(),ast::CALL_OR_VAR);
 }
+
+TEST(TestGetType, TestIsA){
+    ast::Variable var("a");
+    const ast::Expression &expr = var;
+    EXPECT_TRUE(ast::IsA<ast::Variable>(expr));
+    EXPECT_TRUE(ast::IsA<ast::CallOrVar>(expr));
+    EXPECT_FALSE(ast::IsA<ast::CallValue>(expr));
+    EXPECT_EQ(&ast::As<ast::CallOrVar>(expr), &var);
+    EXPECT_EQ(ast::As<ast::Variable>(expr).id(), "a");
+
+    ast::ExitStatement exit_statement;
+    const ast::Statement &statement = exit_statement;
+    EXPECT_EQ(statement.GetType(), ast::EXIT_STATEMENT);
+    EXPECT_TRUE(ast::IsA<ast::ExitStatement>(statement));
+    EXPECT_FALSE(ast::IsA<ast::WhileStatement>(statement));
+}
+
+TEST(TestGetType, TestVisit){
+    auto describe = [](const ast::Expression &expr) {
+        return ast::Visit(expr, [](const auto &node) -> std::string {
+            using Node = std::decay_t<decltype(node)>;
+            if constexpr (std::is_same_v<Node, ast::IntegerValue>)
+                return "int " + std::to_string(node.value());
+            else if constexpr (std::is_same_v<Node, ast::BinaryExpr>)
+                return "binary " + std::string(1, static_cast<char>(node.op()));
+            else if constexpr (std::is_base_of_v<ast::CallOrVar, Node>)
+                return "id " + node.id();
+            else
+                return "other";
+        });
+    };
+    EXPECT_EQ(describe(ast::IntegerValue(4)), "int 4");
+    EXPECT_EQ(describe(ast::BinaryExpr('+', nullptr, nullptr)), "binary +");
+    EXPECT_EQ(describe(ast::CallValue("f")), "id f");
+    EXPECT_EQ(describe(ast::CallOrVar("g")), "id g");
+    EXPECT_EQ(describe(ast::RealValue(1.5)), "other");
+}
@@ -0,0 +1,36 @@
+#include <string>
+
+#include "gtest/gtest.h"
+#include "ast/interner.h"
+
+namespace pascal2c::ast
+{
+    TEST(InternerTest, TestIntern)
+    {
+        Interner symbols;
+        EXPECT_EQ(symbols.size(), 1u);
+        EXPECT_EQ(symbols.Name(0), "");
+
+        SymbolId a = symbols.Intern("a");
+        SymbolId b = symbols.Intern(std::string("b"));
+        EXPECT_NE(a, 0u);
+        EXPECT_NE(a, b);
+        EXPECT_EQ(symbols.Intern("a"), a);
+        EXPECT_EQ(symbols.Find("b"), b);
+        EXPECT_EQ(symbols.Find("c"), 0u);
+        EXPECT_EQ(symbols.size(), 3u);
+    }
+
+    TEST(InternerTest, TestNamesStayPut)
+    {
+        // the names handed out stay valid however many more are interned
+        Interner symbols;
+        SymbolId first = symbols.Intern("first");
+        const std::string *name = &symbols.Name(first);
+        for (int i = 0; i < 10000; i++)
+            symbols.Intern("name" + std::to_string(i));
+        EXPECT_EQ(&symbols.Name(first), name);
+        EXPECT_EQ(*name, "first");
+        EXPECT_EQ(symbols.Find("name9999"), symbols.size() - 1);
+    }
+}
@@ -0,0 +1,59 @@
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "ast/expr.h"
+#include "ast/line_table.h"
+
+namespace pascal2c::ast
+{
+    TEST(LineTableTest, TestLineAndColumn)
+    {
+        LineTable lines("program a;\n\nbegin\n  x := 1\nend.");
+        EXPECT_EQ(lines.size(), 5);
+        EXPECT_EQ(lines.Offset(1, 1), 0);
+        EXPECT_EQ(lines.Offset(3, 1), 12);
+        EXPECT_EQ(lines.Offset(4, 3), 20);
+
+        EXPECT_EQ(lines.Line(0), 1);
+        EXPECT_EQ(lines.Column(0), 1);
+        // the newline belongs to the line it ends
+        EXPECT_EQ(lines.Line(10), 1);
+        EXPECT_EQ(lines.Column(10), 11);
+        EXPECT_EQ(lines.Line(11), 2);
+        EXPECT_EQ(lines.Line(20), 4);
+        EXPECT_EQ(lines.Column(20), 3);
+        EXPECT_EQ(lines.Line(27), 5);
+        EXPECT_EQ(lines.Column(27), 1);
+    }
+
+    TEST(LineTableTest, TestEmptySource)
+    {
+        LineTable lines("");
+        EXPECT_EQ(lines.size(), 1);
+        EXPECT_EQ(lines.Offset(1, 4), 3);
+        EXPECT_EQ(lines.Line(3), 1);
+        EXPECT_EQ(lines.Column(3), 4);
+    }
+
+    TEST(LineTableTest, TestNodePosition)
+    {
+        LineTable lines("a\nbb\nccc");
+        LineTable other("abcdefgh");
+        Variable var(lines.Offset(3, 2), "c");
+
+        // the node only knows its offset, the table asked decides the place
+        EXPECT_EQ(var.line(lines), 3);
+        EXPECT_EQ(var.column(lines), 2);
+        EXPECT_EQ(var.line(other), 1);
+        EXPECT_EQ(var.column(other), 7);
+        EXPECT_EQ(var.ToString(0, lines), "3:2 variable:c");
+    }
+
+    TEST(LineTableTest, TestNodeSize)
+    {
+        // the offset and the kind tag share the word after the vtable pointer
+        EXPECT_EQ(sizeof(Expression), sizeof(Ast));
+        EXPECT_LE(sizeof(Expression), 2 * sizeof(void *));
+    }
+}
@@ -0,0 +1,193 @@
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "ast/expr_pool.h"
+#include "ast/line_table.h"
+#include "ast/program.h"
+#include "ast/serialize.h"
+
+namespace pascal2c::ast
+{
+    // program p(input);
+    // const k = -1;
+    // var a : array [1..10] of integer;
+    // function f(var x : integer) : real;
+    // begin f := x * 2.5 end;
+    // begin
+    //     a[k + 1] := (k + 1) * (k + 1);
+    //     if a[1] > 0 then write('s', 'c') else exit;
+    //     for i := 1 to 3 do while true do f(a[1])
+    // end.
+    static std::shared_ptr<Program> Sample()
+    {
+        ExprPool pool;
+        auto intern = [&pool](std::shared_ptr<Expression> expr) { return pool.Intern(std::move(expr)); };
+
+        auto input = std::make_shared<IdList>(10);
+        input->AddId("input");
+        auto head = std::make_shared<ProgramHead>(0, "p", input);
+        auto body = std::make_shared<ProgramBody>(18);
+        body->AddConstDeclaration(std::make_shared<ConstDeclaration>(
+            24, "k", std::make_shared<UnaryExpr>(28, '-', std::make_shared<IntegerValue>(29, 1))));
+
+        auto a = std::make_shared<IdList>(36);
+        a->AddId("a");
+        auto array = std::make_shared<Type>(40, true, 1);
+        array->AddPeriod({1, 10});
+        body->AddVarDeclaration(std::make_shared<VarDeclaration>(36, a, array));
+
+        auto x = std::make_shared<IdList>(80);
+        x->AddId("x");
+        auto f_head = std::make_shared<SubprogramHead>(66, "f", 2);
+        f_head->AddParameter(std::make_shared<Parameter>(76, true, x, 1));
+        auto f_body = std::make_shared<SubprogramBody>(100);
+        f_body->set_statements(std::make_shared<CompoundStatement>(
+            100, vector<std::shared_ptr<Statement>>{std::make_shared<AssignStatement>(
+                     106, std::make_shared<Variable>(106, "f"),
+                     std::make_shared<BinaryExpr>(111, '*', std::make_shared<CallOrVar>(111, "x"),
+                                                  std::make_shared<RealValue>(115, 2.5)))}));
+        body->AddSubprogram(std::make_shared<Subprogram>(66, f_head, f_body));
+
+        // k + 1 is one node used three times
+        auto k1 = intern(std::make_shared<BinaryExpr>(140, '+', intern(std::make_shared<CallOrVar>(140, "k")),
+                                                      intern(std::make_shared<IntegerValue>(144, 1))));
+        auto assign = std::make_shared<AssignStatement>(
+            132, std::make_shared<Variable>(132, "a", vector<std::shared_ptr<Expression>>{k1}),
+            std::make_shared<BinaryExpr>(150, '*', k1, k1));
+        auto a1 = std::make_shared<Variable>(175, "a", vector<std::shared_ptr<Expression>>{
+                                                           std::make_shared<IntegerValue>(177, 1)});
+        auto branch = std::make_shared<IfStatement>(
+            172, std::make_shared<BinaryExpr>(175, '>', a1, std::make_shared<IntegerValue>(182, 0)),
+            std::make_shared<CallStatement>(
+                189, "write",
+                vector<std::shared_ptr<Expression>>{std::make_shared<StringValue>(195, "s"),
+                                                    std::make_shared<CharValue>(200, 'c')}),
+            std::make_shared<ExitStatement>(210));
+        auto loop = std::make_shared<ForStatement>(
+            220, "i", std::make_shared<IntegerValue>(229, 1), std::make_shared<IntegerValue>(234, 3),
+            std::make_shared<WhileStatement>(
+                239, std::make_shared<BooleanValue>(245, true),
+                std::make_shared<CallStatement>(253, "f", vector<std::shared_ptr<Expression>>{
+                                                              std::make_shared<CallValue>(255, "g"), a1})));
+        body->set_statements(std::make_shared<CompoundStatement>(
+            126, vector<std::shared_ptr<Statement>>{assign, branch, loop}));
+        return std::make_shared<Program>(0, head, body);
+    }
+
+    TEST(SerializeTest, TestRoundTrip)
+    {
+        auto program = Sample();
+        CacheKey key = CacheKey::Of("program p(input); ...");
+        std::string bytes = WriteProgram(*program, key);
+        ASSERT_TRUE(CacheMatches(bytes, key));
+
+        Interner symbols;
+        auto loaded = ReadProgram(bytes, symbols);
+        ASSERT_NE(loaded, nullptr);
+        // the sample has no source, every offset is on its one line
+        LineTable lines("");
+        EXPECT_EQ(loaded->ToString(0, lines), program->ToString(0, lines));
+        EXPECT_EQ(WriteProgram(*loaded, key), bytes);
+
+        // the places in the source and the sharing survive
+        const auto &statements = As<CompoundStatement>(*loaded->program_body()->statements()).statements();
+        const auto &assign = As<AssignStatement>(*statements[0]);
+        EXPECT_EQ(assign.offset(), 132);
+        EXPECT_EQ(assign.var()->expr_list()[0]->offset(), 140);
+        const auto &product = As<BinaryExpr>(*assign.expr());
+        EXPECT_EQ(product.lhs(), product.rhs());
+        EXPECT_EQ(product.lhs(), assign.var()->expr_list()[0]);
+        EXPECT_EQ(loaded->program_body()->subprogram_declarations()[0]->subprogram_head()->offset(), 66);
+
+        // the names are interned once, a name has one id wherever it is used
+        SymbolId a = symbols.Find("a");
+        SymbolId f = symbols.Find("f");
+        EXPECT_NE(a, 0u);
+        EXPECT_NE(f, 0u);
+        EXPECT_NE(a, f);
+        EXPECT_EQ(assign.var()->symbol(), a);
+        EXPECT_EQ(loaded->program_body()->var_declarations()[0]->id_list()->symbol(0), a);
+        EXPECT_EQ(loaded->program_body()->subprogram_declarations()[0]->subprogram_head()->symbol(), f);
+        EXPECT_EQ(loaded->program_body()->const_declarations()[0]->symbol(), symbols.Find("k"));
+        EXPECT_EQ(As<ForStatement>(*statements[2]).symbol(), symbols.Find("i"));
+        EXPECT_EQ(As<ForStatement>(*statements[2]).offset(), 220);
+        EXPECT_EQ(As<CallOrVar>(*As<BinaryExpr>(*assign.var()->expr_list()[0]).lhs()).symbol(), symbols.Find("k"));
+    }
+
+    TEST(SerializeTest, TestKeyMismatch)
+    {
+        auto program = Sample();
+        std::string bytes = WriteProgram(*program, CacheKey::Of("begin end."));
+        EXPECT_FALSE(CacheMatches(bytes, CacheKey::Of("begin  end.")));
+        EXPECT_FALSE(CacheMatches(bytes, CacheKey::Of("begin end!")));
+        EXPECT_FALSE(CacheMatches("", CacheKey::Of("begin end.")));
+
+        // nor one written by another build
+        CacheKey other_build = CacheKey::Of("begin end.");
+        EXPECT_TRUE(CacheMatches(bytes, other_build));
+        other_build.build++;
+        EXPECT_FALSE(CacheMatches(bytes, other_build));
+        EXPECT_NE(CacheKey::Of("begin end.").digest[1], CacheKey::Of("begin end!").digest[1]);
+
+        // an entry of another version is not taken even for the same source
+        bytes[4]++;
+        EXPECT_FALSE(CacheMatches(bytes, CacheKey::Of("begin end.")));
+        Interner symbols;
+        EXPECT_THROW(ReadProgram(bytes, symbols), std::runtime_error);
+    }
+
+    TEST(SerializeTest, TestDamagedEntry)
+    {
+        CacheKey key = CacheKey::Of("program p(input); ...");
+        std::string bytes = WriteProgram(*Sample(), key);
+
+        // a byte flipped anywhere in the strings or the program fails the checksum
+        for (size_t pos = 48; pos < bytes.size(); pos++)
+        {
+            std::string damaged = bytes;
+            damaged[pos] ^= 0x10;
+            EXPECT_FALSE(CacheMatches(damaged, key)) << pos;
+        }
+        EXPECT_FALSE(CacheMatches(bytes.substr(0, bytes.size() - 1), key));
+        EXPECT_FALSE(CacheMatches(bytes + '\0', key));
+        EXPECT_TRUE(CacheMatches(bytes, key));
+    }
+
+    TEST(SerializeTest, TestBadBytes)
+    {
+        std::string bytes = WriteProgram(*Sample(), CacheKey::Of(""));
+        Interner symbols;
+        EXPECT_THROW(ReadProgram("P2CA", symbols), std::runtime_error);
+        EXPECT_THROW(ReadProgram(std::string(bytes.size(), 'x'), symbols), std::runtime_error);
+        EXPECT_THROW(ReadProgram(bytes + '\0', symbols), std::runtime_error);
+
+        // every prefix is cut short somewhere
+        for (size_t size = 0; size < bytes.size(); size++)
+            EXPECT_THROW(ReadProgram(std::string_view(bytes).substr(0, size), symbols), std::runtime_error) << size;
+    }
+
+    TEST(SerializeTest, TestDeepExpression)
+    {
+        // long chains are written and loaded without recursion
+        std::shared_ptr<Expression> expr = std::make_shared<IntegerValue>(1);
+        for (int i = 0; i < 100000; i++)
+            expr = std::make_shared<UnaryExpr>('-', expr);
+        auto body = std::make_shared<ProgramBody>(0);
+        body->AddConstDeclaration(std::make_shared<ConstDeclaration>(0, "k", expr));
+        Program program(0, std::make_shared<ProgramHead>(0, "p"), body);
+
+        Interner symbols;
+        auto loaded = ReadProgram(WriteProgram(program, CacheKey::Of("")), symbols);
+        const Expression *node = loaded->program_body()->const_declarations()[0]->const_value().get();
+        int depth = 0;
+        for (; node->GetType() == UNARY; depth++)
+        {
+            ASSERT_EQ(As<UnaryExpr>(*node).op(), '-');
+            node = As<UnaryExpr>(*node).factor().get();
+        }
+        EXPECT_EQ(depth, 100000);
+        EXPECT_EQ(As<IntegerValue>(*node).value(), 1);
+    }
+}
@@ -0,0 +1,74 @@
+#include <pthread.h>
+
+#include <gtest/gtest.h>
+#include <string>
+
+#include "code_generation/code_generator.h"
+#include "code_generation/optimizer/transformer.h"
+#include "parser/parser.h"
+#include "semantic_analysis/semantic_analysis.h"
+
+using namespace pascal2c;
+
+namespace {
+// Each stage must get through the expression on a stack far smaller than
+// one frame per nesting level would need.
+constexpr size_t kStackBudget = 512 * 1024;
+constexpr int kDepth = 100000;
+
+struct Compiled {
+    size_t syntax_errs = 0;
+    size_t semantic_errs = 0;
+    std::string c_code;
+};
+
+// a := 1 - (-(1 - (-(... a ...))))
+std::string DeepProgram() {
+    std::string expr;
+    expr.reserve(kDepth * 8);
+    for (int i = 0; i < kDepth; i++)
+        expr += i % 2 ? "-(" : "1 - (";
+    expr += "a";
+    expr.append(kDepth, ')');
+    return "program deep;\nvar a: integer;\nbegin\n    a := " + expr +
+           "\nend.\n";
+}
+
+void *Compile(void *arg) {
+    auto *res = static_cast<Compiled *>(arg);
+    std::string source = DeepProgram();
+    {
+        parser::Parser par(source.data(), source.size());
+        auto ast = par.Parse();
+        res->syntax_errs = par.syntax_errs().size();
+        if (ast == nullptr)
+            return nullptr;
+
+        analysiser::init(par.line_table(), par.symbols());
+        analysiser::DoProgram(*ast);
+        res->semantic_errs = analysiser::GetErrors().size();
+
+        code_generation::Transformer trans{ast, par.line_table()};
+        code_generation::CodeGenerator code_generator;
+        code_generator.Interpret(trans.GetASTRoot());
+        res->c_code = code_generator.GetCCode();
+    }
+    return nullptr;
+}
+} // namespace
+
+TEST(GeneratorTest, DeepExpressionTest) {
+    pthread_attr_t attr;
+    ASSERT_EQ(pthread_attr_init(&attr), 0);
+    ASSERT_EQ(pthread_attr_setstacksize(&attr, kStackBudget), 0);
+
+    Compiled res;
+    pthread_t thread;
+    ASSERT_EQ(pthread_create(&thread, &attr, Compile, &res), 0);
+    pthread_join(thread, nullptr);
+    pthread_attr_destroy(&attr);
+
+    EXPECT_EQ(res.syntax_errs, 0);
+    EXPECT_EQ(res.semantic_errs, 0);
+    EXPECT_NE(res.c_code.find("a = (1 - -(1 - -("), std::string::npos);
+}
@@ -1,3 +1,4 @@
+#include "ast/line_table.h"
 #include "code_generation/optimizer/calculater.h"
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -38,8 +39,10 @@ TEST(OptimizerTest , CalculatorTest) {
 			break;
 		}
 		default : 
-			std::cerr << "STR" << res->ToString(0) << "\n";
-			EXPECT_EQ(res->ToString(0) , 
+			// the nodes are not parsed, every offset is 0
+			LineTable lines("");
+			std::cerr << "STR" << res->ToString(0, lines) << "\n";
+			EXPECT_EQ(res->ToString(0, lines) , 
 				"1:1 binary_op:'+'\n"
 				"lhs :\n"
 				"    1:1 variable:Aval\n"
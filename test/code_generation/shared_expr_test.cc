@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+#include <string>
+
+#include "parser/parser.h"
+#include "semantic_analysis/semantic_analysis.h"
+
+using namespace pascal2c;
+
+namespace {
+// the number of operands of mismatched types in source, parsed with or without sharing
+size_t TypeMismatches(const std::string &source, bool hash_cons) {
+    parser::Parser par(source.data(), source.size());
+    par.set_hash_cons(hash_cons);
+    auto ast = par.Parse();
+    EXPECT_TRUE(par.syntax_errs().empty());
+    analysiser::init(par.line_table(), par.symbols());
+    analysiser::DoProgram(*ast);
+    size_t mismatches = 0;
+    for (auto &err : analysiser::GetErrors())
+        if (err.msg() == "illegal type between compute expression:type not match")
+            mismatches++;
+    return mismatches;
+}
+} // namespace
+
+TEST(GeneratorTest, SharedExprTypedOnceTest) {
+    // b + 1 is one node in both statements, it is typed once and so is its error,
+    // the products are two nodes with an error each
+    std::string source = "program p;\n"
+                         "var a : integer; b : boolean;\n"
+                         "begin\n"
+                         "    a := (b + 1) * 2;\n"
+                         "    a := (b + 1) * 3\n"
+                         "end.\n";
+    EXPECT_EQ(TypeMismatches(source, false), 4u);
+    EXPECT_EQ(TypeMismatches(source, true), 3u);
+
+    // b is an integer in q, the nodes and the types shared are those of one scope
+    std::string scoped = "program p;\n"
+                         "var a : integer; b : boolean;\n"
+                         "procedure q;\n"
+                         "var b : integer;\n"
+                         "begin\n"
+                         "    a := b + 1\n"
+                         "end;\n"
+                         "begin\n"
+                         "    a := b + 1\n"
+                         "end.\n";
+    EXPECT_EQ(TypeMismatches(scoped, false), 1u);
+    EXPECT_EQ(TypeMismatches(scoped, true), 1u);
+}
@@ -35,7 +35,7 @@ TEST(GeneratorTest, TransformerTest) {
     }
     printf("[Parser] Done\n");
 
-    analysiser::init();
+    analysiser::init(par.line_table(), par.symbols());
     analysiser::DoProgram(*ast);
 
     auto analysis_errs = analysiser::GetErrors();
@@ -44,7 +44,7 @@ TEST(GeneratorTest, TransformerTest) {
     }
 
     printf("[Transformer] Start\n");
-	Transformer trans{ast};
+	Transformer trans{ast, par.line_table()};
 	auto program = trans.GetASTRoot();
     printf("[Transformer] Done\n");
 
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "driver/driver.h"
+
+using namespace pascal2c::driver;
+
+// a Job compiling text from a file of its own in the temp directory
+static Job MakeJob(const std::string &name, const std::string &text) {
+    auto dir = std::filesystem::temp_directory_path() / "pascal2c_driver_test";
+    std::filesystem::create_directories(dir);
+    Job job;
+    job.input = (dir / (name + ".pas")).string();
+    job.output = (dir / (name + ".c")).string();
+    std::ofstream(job.input) << text;
+    return job;
+}
+
+static std::string ReadFile(const std::string &path) {
+    std::ifstream in(path);
+    std::stringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+TEST(DriverTest, TestHashConsErrorsInPlace) {
+    // zz + 1 is one shared node, each of its errors still points at its own line
+    Job job = MakeJob("hash_cons_errors",
+                      "program p;\n"
+                      "var a : integer;\n"
+                      "begin\n"
+                      "    a := zz + 1;\n"
+                      "    a := zz + 1\n"
+                      "end.\n");
+    Result plain = Compile(job);
+    job.hash_cons = true;
+    Result shared = Compile(job);
+
+    EXPECT_FALSE(shared.ok);
+    EXPECT_NE(shared.diagnostics.find(job.input + ":4:10"), std::string::npos) << shared.diagnostics;
+    EXPECT_NE(shared.diagnostics.find(job.input + ":5:10"), std::string::npos) << shared.diagnostics;
+    EXPECT_EQ(shared.diagnostics, plain.diagnostics);
+}
+
+TEST(DriverTest, TestHashConsSameCode) {
+    Job job = MakeJob("hash_cons_code",
+                      "program p;\n"
+                      "var a, i : integer; x : array [1..10] of integer;\n"
+                      "begin\n"
+                      "    i := 2;\n"
+                      "    x[i + 1] := (i + 1) * (i + 1);\n"
+                      "    a := x[i + 1] - (i + 1);\n"
+                      "    write(a)\n"
+                      "end.\n");
+    Result plain = Compile(job);
+    ASSERT_TRUE(plain.ok) << plain.diagnostics;
+    std::string plain_code = ReadFile(job.output);
+
+    job.hash_cons = true;
+    Result shared = Compile(job);
+    ASSERT_TRUE(shared.ok) << shared.diagnostics;
+    EXPECT_EQ(ReadFile(job.output), plain_code);
+}
+
+TEST(DriverTest, TestDamagedCacheEntry) {
+    Job job = MakeJob("cache_entry",
+                      "program p;\n"
+                      "var a : integer;\n"
+                      "begin\n"
+                      "    a := 6 * 7;\n"
+                      "    write(a)\n"
+                      "end.\n");
+    auto cache = std::filesystem::path(job.input).parent_path() / "cache";
+    std::filesystem::remove_all(cache);
+    job.cache_dir = cache.string();
+    Result first = Compile(job);
+    ASSERT_TRUE(first.ok) << first.diagnostics;
+    std::string code = ReadFile(job.output);
+
+    // a damaged entry is parsed again and written anew
+    std::filesystem::path entry = std::filesystem::directory_iterator(cache)->path();
+    std::string bytes = ReadFile(entry.string());
+    bytes[bytes.size() / 2] ^= 0x10;
+    std::ofstream(entry, std::ios::binary) << bytes;
+    Result second = Compile(job);
+    ASSERT_TRUE(second.ok) << second.diagnostics;
+    EXPECT_EQ(ReadFile(job.output), code);
+    EXPECT_NE(ReadFile(entry.string()), bytes);
+}
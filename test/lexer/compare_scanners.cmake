@@ -0,0 +1,11 @@
+# run lexer_exe built on flex and on the SIMD scanner over one input and
+# fail if their token listings differ
+# usage: cmake -DFLEX_LEXER=<exe> -DSIMD_LEXER=<exe> -DINPUT=<file.pas> -P compare_scanners.cmake
+execute_process(COMMAND ${FLEX_LEXER} INPUT_FILE ${INPUT} OUTPUT_VARIABLE flex_tokens RESULT_VARIABLE flex_result)
+execute_process(COMMAND ${SIMD_LEXER} INPUT_FILE ${INPUT} OUTPUT_VARIABLE simd_tokens RESULT_VARIABLE simd_result)
+if(NOT flex_result EQUAL 0 OR NOT simd_result EQUAL 0)
+        message(FATAL_ERROR "${INPUT}: flex scanner exited with ${flex_result}, SIMD scanner with ${simd_result}")
+endif()
+if(NOT flex_tokens STREQUAL simd_tokens)
+        message(FATAL_ERROR "${INPUT}: the scanners disagree\n--- flex\n${flex_tokens}\n--- simd\n${simd_tokens}")
+endif()
@@ -65,9 +65,9 @@ end.
             TOK_END, '.'
     };
     YYSTYPE expected_vals[11] = {{0}};
-    strcpy(expected_vals[1].strval, "hello");
-    strcpy(expected_vals[4].strval, "write");
-    strcpy(expected_vals[6].strval, "Hello, world!\\n");
+    expected_vals[1].strval = "hello";
+    expected_vals[4].strval = "write";
+    expected_vals[6].strval = "Hello, world!\\n";
 
     int expected_lines[] = {
             1, 1, 1,
@@ -158,11 +158,11 @@ end.
             TOK_END, '.',
     };
     YYSTYPE expected_vals[17] = {{0}};
-    strcpy(expected_vals[2].strval, "a");
-    strcpy(expected_vals[4].strval, "a1");
-    strcpy(expected_vals[6].strval, "_a1b2c3d4e5f6g7h8i9j0k1l2m3n4o5p6q_");
-    strcpy(expected_vals[10].strval, "writeln");
-    strcpy(expected_vals[12].strval, "Valid identifiers");
+    expected_vals[2].strval = "a";
+    expected_vals[4].strval = "a1";
+    expected_vals[6].strval = "_a1b2c3d4e5f6g7h8i9j0k1l2m3n4o5p6q_";
+    expected_vals[10].strval = "writeln";
+    expected_vals[12].strval = "Valid identifiers";
 
     int expected_lines[] = {
             1,
@@ -189,10 +189,10 @@ TEST(LexerIdentifierTest, CaseInsensitiveTest) {
     };
 
     YYSTYPE expected_vals[11] = {{0}};
-    strcpy(expected_vals[1].strval, "identifier");
-    strcpy(expected_vals[3].strval, "identifier");
-    strcpy(expected_vals[5].strval, "identifier");
-    strcpy(expected_vals[7].strval, "identifier");
+    expected_vals[1].strval = "identifier";
+    expected_vals[3].strval = "identifier";
+    expected_vals[5].strval = "identifier";
+    expected_vals[7].strval = "identifier";
 
     int expected_lines[] = {
             1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
@@ -206,6 +206,29 @@ TEST(LexerIdentifierTest, CaseInsensitiveTest) {
             expected_lines, expected_columns);
 }
 
+TEST(LexerIdentifierTest, KeywordCaseTest) {
+    string input = R"(BEGIN End wHiLe endx Do_ integer
+)";
+    int expected_tokens[] = {
+            TOK_BEGIN, TOK_END, TOK_WHILE, TOK_ID, TOK_ID, TOK_INTEGER_TYPE,
+    };
+
+    YYSTYPE expected_vals[6] = {{0}};
+    expected_vals[3].strval = "endx";
+    expected_vals[4].strval = "do_";
+
+    int expected_lines[] = {
+            1, 1, 1, 1, 1, 1,
+    };
+
+    int expected_columns[] = {
+            1, 7, 11, 17, 22, 26,
+    };
+
+    RunTest(input, expected_tokens, expected_vals,
+            expected_lines, expected_columns);
+}
+
 TEST(LexerIntegerTest, SimpleInteger) {
     string input = R"(12345, 9494949, 0;
 )";
@@ -302,3 +325,88 @@ TEST(LexerRealTest, RealOmitNumberTest) {
     RunTest(input, expected_tokens, expected_vals,
             expected_lines, expected_columns);
 }
+
+TEST(LexerReentrantTest, InterleavedScanners) {
+    string input_a = R"(begin 1
+end
+)";
+    string input_b = R"(var x: integer;
+)";
+    FILE *file_a = fmemopen((void *) input_a.c_str(), input_a.size(), "r");
+    FILE *file_b = fmemopen((void *) input_b.c_str(), input_b.size(), "r");
+    LexerState *lexer_a = LexerCreate();
+    LexerState *lexer_b = LexerCreate();
+    LexerSetInput(lexer_a, file_a);
+    LexerSetInput(lexer_b, file_b);
+
+    // each scanner keeps its own position and value while the other one runs
+    EXPECT_EQ(LexerNext(lexer_a), TOK_BEGIN);
+    EXPECT_EQ(LexerNext(lexer_b), TOK_VAR);
+    EXPECT_EQ(LexerNext(lexer_a), TOK_INTEGER);
+    EXPECT_EQ(LexerNext(lexer_b), TOK_ID);
+    EXPECT_STREQ(LexerText(lexer_b), "x");
+    EXPECT_EQ(LexerValue(lexer_a)->intval, 1u);
+    EXPECT_EQ(LexerColumn(lexer_a), 7);
+    EXPECT_EQ(LexerColumn(lexer_b), 5);
+    EXPECT_EQ(LexerNext(lexer_a), TOK_END);
+    EXPECT_EQ(LexerLine(lexer_a), 2);
+    EXPECT_EQ(LexerLine(lexer_b), 1);
+    EXPECT_EQ(LexerNext(lexer_a), 0);
+    EXPECT_EQ(LexerNext(lexer_b), ':');
+
+    LexerDestroy(lexer_a);
+    LexerDestroy(lexer_b);
+    fclose(file_a);
+    fclose(file_b);
+}
+
+TEST(LexerStringTest, LongAndAdjacentStrings) {
+    // longer than the old 256 byte cap of a string value
+    string long_str(1000, 'x');
+    string input = "'" + long_str + "' 'a''b' ''\n";
+    LexerState *lexer = LexerCreate();
+    LexerSetBytes(lexer, input.c_str(), input.size());
+
+    EXPECT_EQ(LexerNext(lexer), TOK_STRING);
+    YYSTYPE first = *LexerValue(lexer);
+    EXPECT_EQ(first.strsize, long_str.size());
+    EXPECT_EQ(string(first.strval, first.strsize), long_str);
+
+    // one string of lookahead must not overwrite the previous value
+    EXPECT_EQ(LexerNext(lexer), TOK_STRING);
+    EXPECT_EQ(string(first.strval, first.strsize), long_str);
+    EXPECT_STREQ(LexerValue(lexer)->strval, "a");
+    EXPECT_EQ(LexerNext(lexer), TOK_STRING);
+    EXPECT_STREQ(LexerValue(lexer)->strval, "b");
+    EXPECT_EQ(LexerNext(lexer), TOK_STRING);
+    EXPECT_EQ(LexerValue(lexer)->strsize, 0u);
+    EXPECT_STREQ(LexerValue(lexer)->strval, "");
+    EXPECT_EQ(LexerNext(lexer), 0);
+
+    LexerDestroy(lexer);
+}
+
+TEST(LexerLongRunTest, RunsOverManyBytes) {
+    // runs longer than the 16 and 32 byte blocks of the SIMD scanner
+    string input = "Abcdefghijklmnopqrstuvwxyz_0123456789ABCDEFGHIJ" + string(40, ' ') +
+                   "{" + string(40, 'c') + "{\n}" + string(40, '\t') + "}" +
+                   "'" + string(40, 's') + "' 12345678901234567890\n1..5\n";
+    int expected_tokens[] = {
+            TOK_ID, TOK_STRING, TOK_ERROR, TOK_INTEGER, TOK_DOTDOT, TOK_INTEGER,
+    };
+    YYSTYPE expected_vals[6] = {{0}};
+    string id = "abcdefghijklmnopqrstuvwxyz_0123456789abcdefghij";
+    string str(40, 's');
+    expected_vals[0].strval = id.c_str();
+    expected_vals[1].strval = str.c_str();
+
+    int expected_lines[] = {
+            1, 2, 2, 3, 3, 3,
+    };
+    int expected_columns[] = {
+            1, 43, 86, 1, 2, 4,
+    };
+
+    RunTest(input, expected_tokens, expected_vals,
+            expected_lines, expected_columns);
+}
@@ -6,6 +6,7 @@
 #include <sstream>
 #include<string>
 #include <memory>
+#include <regex>
 #include <cstdio>
 
 #include "gtest/gtest.h"
@@ -40,11 +41,11 @@ namespace pascal2c::parser {
                 1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 22
         };
         for (int i = 0; i < 11; i++) {
-            EXPECT_EQ(par.token_, res_tokens[i]);
+            EXPECT_EQ(par.token_.kind, res_tokens[i]);
             if (vals[i] != -1)
-                EXPECT_EQ(par.tok_value_.intval, vals[i]);
-            EXPECT_EQ(par.line_,1);
-            EXPECT_EQ(par.column_, col[i]);
+                EXPECT_EQ(par.Value().intval, vals[i]);
+            EXPECT_EQ(par.token_.line,1);
+            EXPECT_EQ(par.token_.column, col[i]);
             par.NextToken();
         }
         fclose(input);
@@ -98,10 +99,10 @@ namespace pascal2c::parser {
 
         std::stringstream str_s;
         std::shared_ptr<ast::Expression> expr;
-        while(par.token_ != 0){
+        while(par.token_.kind != 0){
             expr = par.ParsePrimary();
 
-            str_s << expr->ToString(0) << std::endl;
+            str_s << expr->ToString(0, *par.line_table()) << std::endl;
         }
 //        std::cout << str_s.str() << std::endl;
         EXPECT_EQ(str_s.str(),res);
@@ -282,10 +283,10 @@ namespace pascal2c::parser {
                 "    rhs :\n"
                 "        10:20 true\n\n";
         std::stringstream str_s;
-        while(par.token_ != 0){
+        while(par.token_.kind != 0){
             auto expr = par.ParseExpr();
-            str_s << expr->ToString(0) << "\n" << std::endl;
-            if(par.token_ == ';')
+            str_s << expr->ToString(0, *par.line_table()) << "\n" << std::endl;
+            if(par.token_.kind == ';')
                 par.NextToken();
         }
 
@@ -316,15 +317,83 @@ namespace pascal2c::parser {
         for(int i = 0;i < n;i ++){
             auto input = fmemopen((void *)input_strs[i], strlen(input_strs[i]), "r");
             Parser par(input);
-            try {
-                auto ast = par.ParseExpr();
-                std::cout << ast->ToString(0) << std::endl;
-            }catch (SyntaxErr &e){
-//                std::cout << e.err_msg() << std::endl;
-                EXPECT_EQ(e.err_msg(),errs[i]);
-            }
+            auto ast = par.ParseExpr();
+            EXPECT_EQ(ast, nullptr);
+            ASSERT_TRUE(par.TakeSyntaxErr());
+            ASSERT_EQ(par.syntax_errs().size(), 1);
+            EXPECT_EQ(par.syntax_errs()[0].err_msg(),errs[i]);
+            EXPECT_EQ(par.err_msg()[0], par.syntax_errs()[0].what());
             fclose(input);
         }
     }
 
+    TEST(ExprParserTest, TestLongExpr) {
+        // 1 - 2 * 3 - 2 * 3 - ... is a left leaning chain of '-' with a '*' on every right
+        const int terms = 10000;
+        std::string text = "1";
+        for(int i = 1;i < terms;i ++)
+            text += " - 2 * 3";
+        Parser par(text.data(), text.size());
+        auto expr = par.ParseExpr();
+        EXPECT_EQ(par.token_.kind, 0);
+
+        int depth = 0;
+        auto node = expr;
+        while(node->GetType() == ast::BINARY){
+            auto binary = std::static_pointer_cast<ast::BinaryExpr>(node);
+            EXPECT_EQ(binary->op(), '-');
+            EXPECT_EQ(std::static_pointer_cast<ast::BinaryExpr>(binary->rhs())->op(), '*');
+            node = binary->lhs();
+            depth++;
+        }
+        EXPECT_EQ(depth, terms - 1);
+        EXPECT_EQ(node->GetType(), ast::INT);
+        EXPECT_EQ(node->column(*par.line_table()), 1);
+    }
+
+    TEST(ExprParserTest, TestStringPosition) {
+        // a node starts at the offset of its first token, for a string that is the opening quote
+        std::string text = "s +\n  'it\\'s'";
+        Parser par(text.data(), text.size());
+        auto expr = std::static_pointer_cast<ast::BinaryExpr>(par.ParseExpr());
+        EXPECT_EQ(expr->rhs()->GetType(), ast::STRING);
+        EXPECT_EQ(expr->rhs()->line(*par.line_table()), 2);
+        EXPECT_EQ(expr->rhs()->column(*par.line_table()), 3);
+    }
+
+    TEST(ExprParserTest, TestHashCons) {
+        std::string text = "a[(l + r) div 2] + a[(l + r) div 2] * -x + f(1) + f(1)";
+        Parser par(text.data(), text.size());
+        par.set_hash_cons(true);
+        auto expr = par.ParseExpr();
+        ASSERT_NE(expr, nullptr);
+
+        // ((a[..] + a[..] * -x) + f(1)) + f(1)
+        auto outer = std::static_pointer_cast<ast::BinaryExpr>(expr);
+        auto middle = std::static_pointer_cast<ast::BinaryExpr>(outer->lhs());
+        auto inner = std::static_pointer_cast<ast::BinaryExpr>(middle->lhs());
+        auto product = std::static_pointer_cast<ast::BinaryExpr>(inner->rhs());
+        EXPECT_EQ(inner->lhs(), product->lhs());
+        EXPECT_EQ(inner->lhs()->ToString(0, *par.line_table()), product->lhs()->ToString(0, *par.line_table()));
+        EXPECT_EQ(inner->lhs()->column(*par.line_table()), 1);
+
+        // a call may have side effects, only its parameters are shared
+        auto call1 = std::static_pointer_cast<ast::CallValue>(middle->rhs());
+        auto call2 = std::static_pointer_cast<ast::CallValue>(outer->rhs());
+        EXPECT_NE(call1, call2);
+        EXPECT_EQ(call1->params()[0], call2->params()[0]);
+        EXPECT_GE(par.expr_pool().hits(), 6);
+
+        Parser plain(text.data(), text.size());
+        auto plain_expr = plain.ParseExpr();
+        // the same tree but for the places of the shared nodes
+        std::regex place("[0-9]+:[0-9]+ ");
+        EXPECT_EQ(std::regex_replace(plain_expr->ToString(0, *plain.line_table()), place, ""),
+                  std::regex_replace(expr->ToString(0, *par.line_table()), place, ""));
+        auto plain_inner = std::static_pointer_cast<ast::BinaryExpr>(
+                std::static_pointer_cast<ast::BinaryExpr>(
+                        std::static_pointer_cast<ast::BinaryExpr>(plain_expr)->lhs())->lhs());
+        EXPECT_NE(plain_inner->lhs(), std::static_pointer_cast<ast::BinaryExpr>(plain_inner->rhs())->lhs());
+    }
+
 }
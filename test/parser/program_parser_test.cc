@@ -23,7 +23,7 @@
             auto expr = par.parse_function();                                         \
             const vector<std::string> &err_messages = par.err_msg();                  \
             temp_errs.push_back(err_messages);                                        \
-            temp_results.push_back(expr->ToString(0));                                \
+            temp_results.push_back(expr->ToString(0, *par.line_table()));             \
             fclose(input);                                                            \
         }                                                                             \
         for (int i = 0; i < temp_errs.size(); i++)                                    \
@@ -49,7 +49,7 @@
         Parser par(input);                                                        \
         auto expr = par.parse_function();                                         \
         EXPECT_EQ(par.err_msg(), errs[i]);                                        \
-        EXPECT_EQ(expr->ToString(0), results[i]);                                 \
+        EXPECT_EQ(expr->ToString(0, *par.line_table()), results[i]);              \
     }
 
 namespace pascal2c::parser
@@ -1039,4 +1039,137 @@ namespace pascal2c::parser
         // OUTPUT_RESULT(ParseParameter, input_strs);
         CHECK_RESULT(ParseParameter, input_strs, results, errs);
     }
+
+    TEST(ProgramParserTest, TestFindSubprograms)
+    {
+        const string input_str = "program p;\n"
+                                 "procedure a;\n"
+                                 "var r: record x: integer end;\n"
+                                 "begin case r.x of 1: begin end end end;\n"
+                                 "function b(x: integer): integer;\n"
+                                 "begin b := x end;\n"
+                                 "begin a end.\n";
+        Parser par(input_str.data(), input_str.size());
+        const TokenStream &tokens = par.tokens();
+        size_t first = 0;
+        while (tokens.kind(first) != TOK_PROCEDURE)
+        {
+            first++;
+        }
+
+        vector<size_t> bounds = Parser::FindSubprograms(tokens, first);
+        ASSERT_EQ(bounds.size(), 3);
+        EXPECT_EQ(bounds[0], first);
+        EXPECT_EQ(tokens.kind(bounds[1]), TOK_FUNCTION);
+        EXPECT_EQ(tokens.kind(bounds[2]), TOK_BEGIN);
+        EXPECT_EQ(tokens.line(bounds[2]), 7);
+
+        // a subprogram without a begin ends the scan
+        const string no_body = "program p;\n"
+                               "procedure a;\n"
+                               "begin end;\n"
+                               "procedure b;\n"
+                               "procedure c;\n"
+                               "begin end;\n"
+                               "begin end.\n";
+        Parser par2(no_body.data(), no_body.size());
+        const TokenStream &tokens2 = par2.tokens();
+        first = 0;
+        while (tokens2.kind(first) != TOK_PROCEDURE)
+        {
+            first++;
+        }
+        bounds = Parser::FindSubprograms(tokens2, first);
+        ASSERT_EQ(bounds.size(), 2);
+        EXPECT_EQ(tokens2.line(bounds[1]), 4);
+    }
+
+    TEST(ProgramParserTest, TestParseSubprogramsInParallel)
+    {
+        // enough subprograms to go over the size the threads start at
+        auto make_program = [](const string &broken) {
+            string source = "program p;\nvar a: integer;\n";
+            for (int i = 0; i < 600; i++)
+            {
+                string name = "f" + std::to_string(i);
+                source += "function " + name + "(x: integer): integer;\n"
+                          "var t: integer;\n"
+                          "begin\n"
+                          "    t := x * " + std::to_string(i) + " + 1;\n"
+                          "    if t > 10 then " + name + " := t else " + name + " := -t\n"
+                          "end;\n";
+                if (i == 300)
+                {
+                    source += broken;
+                }
+            }
+            return source + "begin a := f1(2) end.\n";
+        };
+        const vector<string> input_strs = {
+            make_program(""),
+            make_program("procedure e;\nbegin a := ( end;\n"),
+            make_program("procedure e;\nbegin a := 1;\n"),
+            make_program("procedure e;\nvar b: integer;\nprocedure g;\nbegin end;\n"),
+        };
+
+        for (const string &input_str : input_strs)
+        {
+            Parser serial(input_str.data(), input_str.size());
+            auto expected = serial.Parse();
+            std::shared_ptr<ast::Program> program;
+            std::shared_ptr<const ast::LineTable> lines;
+            vector<string> err_msg;
+            {
+                Parser parallel(input_str.data(), input_str.size());
+                parallel.set_parse_threads(4);
+                program = parallel.Parse();
+                lines = parallel.line_table();
+                err_msg = parallel.err_msg();
+            }
+
+            // the tree outlives the parsers, the nodes the threads made included
+            EXPECT_EQ(err_msg, serial.err_msg());
+            EXPECT_EQ(program->ToString(0, *lines), expected->ToString(0, *serial.line_table()));
+        }
+    }
+    TEST(ProgramParserTest, TestParseFromTokenQueue)
+    {
+        auto make_program = [](const string &broken) {
+            string source = "program p;\nvar a: integer; s: string;\n";
+            for (int i = 0; i < 300; i++)
+            {
+                string name = "f" + std::to_string(i);
+                source += "function " + name + "(x: integer): integer;\n"
+                          "begin\n"
+                          "    s := 'call " + name + "';\n"
+                          "    " + name + " := x * " + std::to_string(i) + " + 1\n"
+                          "end;\n";
+                if (i == 150)
+                {
+                    source += broken;
+                }
+            }
+            return source + "begin a := f1(2) end.\n";
+        };
+        const vector<string> input_strs = {
+            make_program(""),
+            make_program("procedure e;\nbegin a := ( end;\n"),
+            make_program("procedure e;\nbegin a := 'open\nend;\n"),
+        };
+
+        for (const string &input_str : input_strs)
+        {
+            Parser serial(input_str.data(), input_str.size());
+            auto expected = serial.Parse();
+            // a small ring so the scanner and the parser keep waiting for each other
+            Parser queued(std::make_unique<TokenQueue>(input_str, 8));
+            auto program = queued.Parse();
+
+            EXPECT_EQ(queued.err_msg(), serial.err_msg());
+            EXPECT_EQ(program->ToString(0, *queued.line_table()), expected->ToString(0, *serial.line_table()));
+            ASSERT_NE(queued.token_queue(), nullptr);
+            EXPECT_EQ(queued.token_queue()->stats().tokens, serial.tokens().size());
+            EXPECT_EQ(serial.token_queue(), nullptr);
+        }
+    }
 }
\ No newline at end of file
@@ -92,11 +92,11 @@ namespace pascal2c::parser
         std::stringstream str_s;
 
         pascal2c::parser::Parser par(input);
-        while (par.token_ != 0)
+        while (par.token_.kind != 0)
         {
             auto statement = par.ParseStatement();
-            str_s << statement->ToString(0) << "\n" << std::endl;
-            if (par.token_ != 0)
+            str_s << statement->ToString(0, *par.line_table()) << "\n" << std::endl;
+            if (par.token_.kind != 0)
                 par.Match(';');
         }
 //        std::cout << input_str << "\n\n";
@@ -167,11 +167,11 @@ namespace pascal2c::parser
                 "            6:13 1\n\n";
         std::stringstream str_s;
 
-        while (par.token_ != 0)
+        while (par.token_.kind != 0)
         {
             auto statement = par.ParseStatement();
-            str_s << statement->ToString(0) << "\n" << std::endl;
-            if (par.token_ != 0)
+            str_s << statement->ToString(0, *par.line_table()) << "\n" << std::endl;
+            if (par.token_.kind != 0)
                 par.Match(';');
         }
 
@@ -250,11 +250,11 @@ namespace pascal2c::parser
                 "                7:13 1\n\n";
         std::stringstream str_s;
 
-        while (par.token_ != 0)
+        while (par.token_.kind != 0)
         {
             auto statement = par.ParseStatement();
-            str_s << statement->ToString(0) << "\n" << std::endl;
-            if (par.token_ != 0)
+            str_s << statement->ToString(0, *par.line_table()) << "\n" << std::endl;
+            if (par.token_.kind != 0)
                 par.Match(';');
         }
 //        std::cout << input_str << "\n\n";
@@ -361,11 +361,11 @@ namespace pascal2c::parser
             "statement 3:\n"
             "    12:4 ExitStatement\n\n";
         std::stringstream str_s;
-        while (par.token_ != 0)
+        while (par.token_.kind != 0)
         {
             auto statement = par.ParseStatement();
-            str_s << statement->ToString(0) << "\n" << std::endl;
-            if (par.token_ != 0)
+            str_s << statement->ToString(0, *par.line_table()) << "\n" << std::endl;
+            if (par.token_.kind != 0)
                 par.Match(';');
         }
 //        std::cout << input_str << "\n\n";
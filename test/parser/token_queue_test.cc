@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "parser/token_queue.h"
+#include "parser/token_stream.h"
+
+using namespace pascal2c::parser;
+
+TEST(TokenQueueTest, TestScanAll) {
+    TokenQueue queue("Count := 12 + 3.5;\nwriteln('hi')");
+    int kinds[] = {TOK_ID, TOK_ASSIGNOP, TOK_INTEGER, '+', TOK_REAL, ';',
+                   TOK_ID, '(', TOK_STRING, ')', 0};
+    for (int kind : kinds) {
+        queue.Next();
+        ASSERT_EQ(queue.token().kind, kind);
+        if (kind == TOK_ID && queue.token().line == 1) {
+            EXPECT_EQ(queue.text(), "count");
+        }
+        if (kind == TOK_INTEGER) {
+            EXPECT_EQ(queue.value().intval, 12u);
+        }
+        if (kind == TOK_REAL) {
+            EXPECT_DOUBLE_EQ(queue.value().realval, 3.5);
+            EXPECT_EQ(queue.token().column, 15);
+            EXPECT_EQ(queue.token().offset, 14u);
+            EXPECT_EQ(queue.token().length, 3u);
+        }
+        if (kind == TOK_STRING) {
+            EXPECT_EQ(queue.string_value(), "hi");
+            EXPECT_EQ(queue.token().line, 2);
+            EXPECT_EQ(queue.token().column, 9);
+        }
+    }
+
+    // the end stays
+    queue.Next();
+    EXPECT_EQ(queue.token().kind, 0);
+    EXPECT_EQ(queue.stats().tokens, sizeof(kinds) / sizeof(kinds[0]));
+}
+
+// a ring far smaller than the input makes both sides wait for each other
+TEST(TokenQueueTest, TestSameAsStream) {
+    std::string source;
+    for (int i = 0; i < 2000; i++) {
+        std::string n = std::to_string(i);
+        source += "Value" + n + " := " + n + " + 1.5 * x; s := 'line " + n + "';\n";
+        if (i % 31 == 0)
+            source += "bad ? 'open\n";
+    }
+    source += "s := '" + std::string(100000, 'x') + "';\n";
+
+    TokenStream tokens(source);
+    for (size_t capacity : {1, 2, 16, 1000}) {
+        TokenQueue queue(source, capacity);
+        for (size_t i = 0; i < tokens.size(); i++) {
+            queue.Next();
+            Token expected = tokens[i], token = queue.token();
+            ASSERT_EQ(token.kind, expected.kind) << "token " << i;
+            EXPECT_EQ(token.offset, expected.offset) << "token " << i;
+            EXPECT_EQ(token.length, expected.length) << "token " << i;
+            EXPECT_EQ(token.line, expected.line) << "token " << i;
+            EXPECT_EQ(token.column, expected.column) << "token " << i;
+            EXPECT_EQ(queue.text(), tokens.text(i)) << "token " << i;
+            if (token.kind == TOK_ERROR) {
+                EXPECT_EQ(token.payload, expected.payload) << "token " << i;
+            }
+            if (token.kind == TOK_ID) {
+                EXPECT_EQ(queue.symbols()->Name(token.payload), tokens.symbols()->Name(expected.payload)) << "token " << i;
+            }
+            if (token.kind == TOK_INTEGER) {
+                EXPECT_EQ(queue.value().intval, tokens.value(i).intval) << "token " << i;
+            }
+            if (token.kind == TOK_STRING) {
+                EXPECT_EQ(queue.string_value(), tokens.string_value(i)) << "token " << i;
+            }
+        }
+
+        TokenQueue::Stats stats = queue.stats();
+        EXPECT_EQ(stats.capacity, capacity < 2 ? 2 : capacity == 1000 ? 1024 : capacity);
+        EXPECT_EQ(stats.tokens, tokens.size());
+        EXPECT_LE(stats.max_depth, stats.capacity);
+        if (capacity < 1000) {
+            EXPECT_GT(stats.producer_stalls + stats.consumer_stalls, 0u);
+        }
+    }
+}
+
+TEST(TokenQueueTest, TestStopEarly) {
+    std::string source;
+    for (int i = 0; i < 10000; i++)
+        source += "a := b;\n";
+    TokenQueue queue(source, 4);
+    queue.Next();
+    EXPECT_EQ(queue.text(), "a");
+    // the scanner waits on the full ring and is stopped by the destructor
+}
@@ -0,0 +1,28 @@
+#include <gtest/gtest.h>
+
+#include "parser/token_set.h"
+
+using namespace pascal2c::parser;
+
+TEST(TokenSetTest, TestContains) {
+    static constexpr TokenSet tokens = {';', TOK_END, TOK_MAX, 0};
+    static_assert(tokens.Contains(TOK_END), "built at compile time");
+
+    EXPECT_TRUE(tokens.Contains(';'));
+    EXPECT_TRUE(tokens.Contains(TOK_END));
+    EXPECT_TRUE(tokens.Contains(TOK_MAX));
+    EXPECT_TRUE(tokens.Contains(0));
+    EXPECT_FALSE(tokens.Contains(','));
+    EXPECT_FALSE(tokens.Contains(TOK_BEGIN));
+    EXPECT_FALSE(tokens.Contains(-1));
+    EXPECT_FALSE(tokens.Contains(TOK_MAX + 1));
+    EXPECT_FALSE(TokenSet{}.Contains(';'));
+}
+
+TEST(TokenSetTest, TestUnion) {
+    constexpr TokenSet both = TokenSet{TOK_IF} | TokenSet{TOK_THEN, ';'};
+    EXPECT_TRUE(both.Contains(TOK_IF));
+    EXPECT_TRUE(both.Contains(TOK_THEN));
+    EXPECT_TRUE(both.Contains(';'));
+    EXPECT_FALSE(both.Contains(TOK_ELSE));
+}
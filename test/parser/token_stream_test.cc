@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include "parser/token_stream.h"
+
+using namespace pascal2c::parser;
+
+TEST(TokenStreamTest, TestScanAll) {
+    TokenStream tokens("Count := 12 + 3.5;\nwriteln('hi')");
+    int kinds[] = {TOK_ID, TOK_ASSIGNOP, TOK_INTEGER, '+', TOK_REAL, ';',
+                   TOK_ID, '(', TOK_STRING, ')', 0};
+    ASSERT_EQ(tokens.size(), sizeof(kinds) / sizeof(kinds[0]));
+    for (size_t i = 0; i < tokens.size(); i++)
+        EXPECT_EQ(tokens.kind(i), kinds[i]);
+
+    EXPECT_EQ(tokens.text(0), "count");
+    EXPECT_EQ(tokens.text(1), ":=");
+    EXPECT_EQ(tokens.value(2).intval, 12u);
+    EXPECT_DOUBLE_EQ(tokens.value(4).realval, 3.5);
+    EXPECT_EQ(tokens.string_value(8), "hi");
+    EXPECT_EQ(tokens.line(6), 2);
+    EXPECT_EQ(tokens.column(6), 1);
+    EXPECT_EQ(tokens.column(8), 9);
+
+    Token token = tokens[4];
+    EXPECT_EQ(token.kind, TOK_REAL);
+    EXPECT_EQ(token.line, 1);
+    EXPECT_EQ(token.column, 15);
+    EXPECT_EQ(token.offset, 14u);
+    EXPECT_EQ(token.length, 3u);
+
+    // the text of a string is the whole literal, quotes included
+    token = tokens[8];
+    EXPECT_EQ(token.offset, 27u);
+    EXPECT_EQ(token.length, 4u);
+    EXPECT_EQ(tokens.text(8), "'hi'");
+}
+
+TEST(TokenStreamTest, TestIdentifiersInterned) {
+    TokenStream tokens("Count := count + total;\nTOTAL := 1");
+    ASSERT_EQ(tokens.kind(0), TOK_ID);
+    uint32_t count = tokens[0].payload, total = tokens[4].payload;
+    EXPECT_NE(count, 0u);
+    EXPECT_NE(count, total);
+    EXPECT_EQ(tokens[2].payload, count);
+    EXPECT_EQ(tokens[6].payload, total);
+    EXPECT_EQ(tokens.symbols()->Name(count), "count");
+    EXPECT_EQ(tokens.symbols()->Find("total"), total);
+    // an identifier is no literal
+    EXPECT_EQ(tokens.value(0).intval, 0u);
+}
+
+TEST(TokenStreamTest, TestPastTheEnd) {
+    TokenStream tokens("a");
+    ASSERT_EQ(tokens.size(), 2u);
+    EXPECT_EQ(tokens.kind(1), 0);
+    EXPECT_EQ(tokens.kind(100), 0);
+    EXPECT_EQ(tokens.text(100), "");
+}
+
+TEST(TokenStreamTest, TestErrorsAreTokens) {
+    // scanning goes on after an error like the parser's recovery expects
+    TokenStream tokens("a 'open\nb");
+    int kinds[] = {TOK_ID, TOK_ERROR, TOK_ID, 0};
+    ASSERT_EQ(tokens.size(), 4u);
+    for (size_t i = 0; i < tokens.size(); i++)
+        EXPECT_EQ(tokens.kind(i), kinds[i]);
+    EXPECT_STREQ(YYERRMSG[tokens[1].payload], "Unterminated string");
+    EXPECT_EQ(tokens.value(1).intval, 0u);
+    EXPECT_EQ(tokens.text(1), "'open");
+}
+
+// every field of every token of a chunked scan matches the single scan
+static void ExpectSameTokens(const std::string &source, size_t threads, size_t min_chunk) {
+    TokenStream serial(source);
+    TokenStream chunked(source, threads, min_chunk);
+    ASSERT_EQ(chunked.size(), serial.size());
+    for (size_t i = 0; i < serial.size(); i++) {
+        Token expected = serial[i], token = chunked[i];
+        ASSERT_EQ(token.kind, expected.kind) << "token " << i;
+        EXPECT_EQ(token.offset, expected.offset) << "token " << i;
+        EXPECT_EQ(token.length, expected.length) << "token " << i;
+        EXPECT_EQ(token.line, expected.line) << "token " << i;
+        EXPECT_EQ(token.column, expected.column) << "token " << i;
+        EXPECT_EQ(token.payload, expected.payload) << "token " << i;
+        EXPECT_EQ(chunked.text(i), serial.text(i)) << "token " << i;
+        if (token.kind == TOK_STRING) {
+            EXPECT_EQ(chunked.string_value(i), serial.string_value(i)) << "token " << i;
+        } else if (token.kind == TOK_INTEGER) {
+            EXPECT_EQ(chunked.value(i).intval, serial.value(i).intval) << "token " << i;
+        } else if (token.kind == TOK_REAL) {
+            EXPECT_EQ(chunked.value(i).realval, serial.value(i).realval) << "token " << i;
+        }
+    }
+}
+
+TEST(TokenStreamTest, TestScanInChunks) {
+    std::string source;
+    for (int i = 0; i < 200; i++) {
+        std::string n = std::to_string(i);
+        source += "Value" + n + " := " + n + " + 1.5 * x; s := 'line " + n + "';\n";
+        if (i % 7 == 0)
+            source += "{ a comment\n  over { nested\n } lines }\n";
+        if (i % 31 == 0)
+            source += "bad ? 'open\n";
+    }
+    for (size_t min_chunk : {16, 100, 1000}) {
+        for (size_t threads : {2, 3, 8}) {
+            ExpectSameTokens(source, threads, min_chunk);
+            ExpectSameTokens(source + "last", threads, min_chunk);
+            ExpectSameTokens(source + "{ open at the end\n", threads, min_chunk);
+        }
+    }
+}
+
+TEST(TokenStreamTest, TestCommentOverManyChunks) {
+    // the comment starts in the first chunk and ends near the last
+    std::string source = "a := 1;\n{\n";
+    for (int i = 0; i < 100; i++)
+        source += "x := 'not a string; b := " + std::to_string(i) + ";\n";
+    source += "}\nb := 2;\n";
+    for (size_t threads : {2, 4, 8})
+        ExpectSameTokens(source, threads, 64);
+
+    TokenStream tokens(source, 4, 64);
+    ASSERT_EQ(tokens.size(), 9u);
+    EXPECT_EQ(tokens.text(4), "b");
+    EXPECT_EQ(tokens.line(4), 104);
+}
@@ -338,8 +338,97 @@ namespace pascal2c::parser
         // std::cout << expr->ToString(0) << std::endl
         //           << std::endl;
         EXPECT_EQ(par.err_msg(), err);
-        EXPECT_EQ(expr->ToString(0), result);
+        EXPECT_EQ(expr->ToString(0, *par.line_table()), result);
 
         fclose(input);
     }
+
+    // records what the parser hands over and drops every subprogram at once
+    class RecordingHandler : public ProgramHandler
+    {
+    public:
+        void OnProgramHead(const std::shared_ptr<ast::ProgramHead> &head) override
+        {
+            events.push_back("head " + head->id());
+        }
+
+        void OnGlobals(const std::shared_ptr<ast::ProgramBody> &body) override
+        {
+            events.push_back("globals " + std::to_string(body->const_declarations().size()) + " " +
+                             std::to_string(body->var_declarations().size()));
+        }
+
+        void OnSubprogram(std::shared_ptr<ast::Subprogram> subprogram) override
+        {
+            events.push_back("subprogram " + subprogram->subprogram_head()->id());
+            dropped.push_back(subprogram);
+        }
+
+        vector<string> events;
+        vector<std::weak_ptr<ast::Subprogram>> dropped;
+    };
+
+    TEST(TotalParserTest, TestParseStreaming)
+    {
+        const string content = "program p;\n"
+                               "const c = 1;\n"
+                               "var a, b: integer;\n"
+                               "function f(x: integer): integer;\n"
+                               "begin f := x + c end;\n"
+                               "procedure g;\n"
+                               "var t: integer;\n"
+                               "begin t := f(a) end;\n"
+                               "begin g end.\n";
+
+        Parser par(content.data(), content.size());
+        RecordingHandler handler;
+        auto program = par.Parse(handler);
+
+        EXPECT_TRUE(par.syntax_errs().empty());
+        const vector<string> events = {"head p", "globals 1 1", "subprogram f", "subprogram g"};
+        EXPECT_EQ(handler.events, events);
+        EXPECT_TRUE(program->program_body()->subprogram_declarations().empty());
+        EXPECT_NE(program->program_body()->statements(), nullptr);
+        // nobody but the handler held the subprograms
+        for (auto &subprogram : handler.dropped)
+        {
+            EXPECT_TRUE(subprogram.expired());
+        }
+    }
+
+    // every name in the program carries the id its identifier got from the scanner
+    TEST(TotalParserTest, TestSymbols)
+    {
+        const string content = "program p;\n"
+                               "const c = 1;\n"
+                               "var a: integer;\n"
+                               "procedure g(x: integer);\n"
+                               "begin a := x end;\n"
+                               "begin for a := c to 2 do g(a) end.\n";
+        for (bool queued : {false, true})
+        {
+            auto par = queued ? std::make_unique<Parser>(std::make_unique<TokenQueue>(content, 4))
+                              : std::make_unique<Parser>(content.data(), content.size());
+            auto program = par->Parse();
+            ASSERT_TRUE(par->syntax_errs().empty());
+            const ast::Interner &symbols = *par->symbols();
+            ast::SymbolId a = symbols.Find("a");
+            EXPECT_NE(a, 0u);
+
+            const auto &body = *program->program_body();
+            EXPECT_EQ(body.const_declarations()[0]->symbol(), symbols.Find("c"));
+            EXPECT_EQ(body.var_declarations()[0]->id_list()->symbol(0), a);
+            const auto &head = *body.subprogram_declarations()[0]->subprogram_head();
+            EXPECT_EQ(head.symbol(), symbols.Find("g"));
+            EXPECT_EQ(head.parameters()[0]->id_list()->symbol(0), symbols.Find("x"));
+
+            const auto &loop = ast::As<ast::ForStatement>(
+                *ast::As<ast::CompoundStatement>(*body.statements()).statements()[0]);
+            EXPECT_EQ(loop.symbol(), a);
+            EXPECT_EQ(ast::As<ast::CallOrVar>(*loop.from()).symbol(), symbols.Find("c"));
+            const auto &call = ast::As<ast::CallStatement>(*loop.statement());
+            EXPECT_EQ(call.symbol(), symbols.Find("g"));
+            EXPECT_EQ(ast::As<ast::CallOrVar>(*call.expr_list()[0]).symbol(), a);
+        }
+    }
 }